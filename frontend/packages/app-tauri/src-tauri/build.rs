@@ -1,3 +1,38 @@
+use std::env;
+
 fn main() {
+  println!("cargo:rustc-check-cfg=cfg(native_parser)");
+  // The parser's CMake build expects a Unix toolchain with zlib and bzip2;
+  // elsewhere the app keeps indexing in the WASM worker.
+  if env::var("CARGO_CFG_TARGET_OS").map_or(false, |os| os != "windows") {
+    build_native_parser();
+  }
   tauri_build::build()
 }
+
+/// Build the C++ parser library at the repository root and link it, with
+/// the C API from include/waveform_c_api.h.
+fn build_native_parser() {
+  let dst = cmake::Config::new("../../../..")
+    .build_target("vcd_parser")
+    .profile("Release")
+    .define("WAVEFORM_LTO", "OFF")
+    .build();
+
+  println!("cargo:rustc-link-search=native={}/build", dst.display());
+  println!("cargo:rustc-link-lib=static=vcd_parser");
+  println!("cargo:rustc-link-lib=static=fst");
+  println!("cargo:rustc-link-lib=dylib=z");
+  println!("cargo:rustc-link-lib=dylib=bz2");
+  let cxx = if env::var("CARGO_CFG_TARGET_VENDOR").map_or(false, |v| v == "apple") {
+    "c++"
+  } else {
+    "stdc++"
+  };
+  println!("cargo:rustc-link-lib=dylib={cxx}");
+
+  for dir in ["src", "include", "libfst/src", "CMakeLists.txt"] {
+    println!("cargo:rerun-if-changed=../../../../{dir}");
+  }
+  println!("cargo:rustc-cfg=native_parser");
+}
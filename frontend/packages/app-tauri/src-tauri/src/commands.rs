@@ -0,0 +1,230 @@
+//! Commands that index and query waveforms natively, in place of the WASM
+//! worker. The frontend bridge (src/nativeWorker.ts) maps the worker
+//! protocol onto them.
+
+use std::path::{Path, PathBuf};
+use std::sync::atomic::{AtomicU64, Ordering};
+use std::sync::{Arc, Mutex};
+use std::time::{Duration, Instant};
+
+use tauri::ipc::{Channel, InvokeResponseBody, Response};
+use tauri::State;
+
+use crate::native::{Metadata, Parser};
+
+const INDEX_CHUNK_SIZE: usize = 32 * 1024 * 1024;
+const QUERY_CHUNK_SIZE: usize = 32 * 1024 * 1024;
+/// First query step; steps double from here up to QUERY_CHUNK_SIZE.
+const FIRST_QUERY_CHUNK_SIZE: usize = 1024 * 1024;
+/// Snapshot memory ceiling; native memory isn't bound by the WASM heap.
+const SNAPSHOT_BUDGET: u64 = 1024 * 1024 * 1024;
+const PROGRESS_INTERVAL: Duration = Duration::from_millis(100);
+
+/// The open file, if any. Starting or cancelling a query bumps
+/// `query_generation`, which ends the query running before.
+#[derive(Default)]
+pub struct Backend {
+  parser: Arc<Mutex<Option<Parser>>>,
+  query_generation: Arc<AtomicU64>,
+}
+
+#[derive(Clone, serde::Serialize)]
+#[serde(rename_all = "camelCase")]
+pub struct IndexProgress {
+  bytes_read: u64,
+  total_bytes: u64,
+}
+
+/// The sidecar index next to the file, as the CLI writes it.
+fn sidecar(path: &Path) -> PathBuf {
+  let mut name = path.as_os_str().to_owned();
+  name.push(".wvidx");
+  PathBuf::from(name)
+}
+
+/// Run `f` on the open parser off the async runtime.
+async fn with_parser<T, F>(state: &Backend, f: F) -> Result<T, String>
+where
+  T: Send + 'static,
+  F: FnOnce(&mut Parser) -> T + Send + 'static,
+{
+  let slot = state.parser.clone();
+  tauri::async_runtime::spawn_blocking(move || {
+    let mut guard = slot.lock().map_err(|e| e.to_string())?;
+    let parser = guard.as_mut().ok_or("No VCD/FST file is currently loaded")?;
+    Ok(f(parser))
+  })
+  .await
+  .map_err(|e| e.to_string())?
+}
+
+#[tauri::command]
+pub fn file_size(path: String) -> Result<u64, String> {
+  std::fs::metadata(path).map(|m| m.len()).map_err(|e| e.to_string())
+}
+
+/// Open and index `path`, reusing its sidecar index when it is still valid
+/// and writing one otherwise. Replaces the file opened before.
+#[tauri::command]
+pub async fn open_waveform(
+  state: State<'_, Backend>,
+  path: String,
+  on_progress: Channel<IndexProgress>,
+) -> Result<bool, String> {
+  let slot = state.parser.clone();
+  tauri::async_runtime::spawn_blocking(move || {
+    let mut guard = slot.lock().map_err(|e| e.to_string())?;
+    *guard = None;
+
+    let path = PathBuf::from(path);
+    let total_bytes = std::fs::metadata(&path).map(|m| m.len()).unwrap_or(0);
+    let Some(mut parser) = Parser::open(&path) else {
+      return Ok(false);
+    };
+
+    parser.set_transition_index(true);
+    parser.set_lod_pyramids(true);
+    parser.set_snapshot_policy(SNAPSHOT_BUDGET, 0);
+    parser.set_index_threads(0);
+    parser.set_query_threads(0);
+
+    let index_path = sidecar(&path);
+    if !parser.load_index(&index_path) {
+      parser.begin_indexing();
+      let mut last = Instant::now();
+      while parser.index_step(INDEX_CHUNK_SIZE) != 0 {
+        if last.elapsed() >= PROGRESS_INTERVAL {
+          let bytes_read = parser.input_position().min(total_bytes);
+          let _ = on_progress.send(IndexProgress { bytes_read, total_bytes });
+          last = Instant::now();
+        }
+      }
+      parser.finish_indexing();
+      if !parser.is_open() {
+        return Ok(false);
+      }
+      // A read-only directory just means the next open indexes again
+      parser.save_index(&index_path);
+    }
+
+    let _ = on_progress.send(IndexProgress {
+      bytes_read: total_bytes,
+      total_bytes,
+    });
+    *guard = Some(parser);
+    Ok(true)
+  })
+  .await
+  .map_err(|e| e.to_string())?
+}
+
+#[tauri::command]
+pub async fn close_waveform(state: State<'_, Backend>) -> Result<(), String> {
+  let slot = state.parser.clone();
+  tauri::async_runtime::spawn_blocking(move || {
+    if let Ok(mut guard) = slot.lock() {
+      *guard = None;
+    }
+  })
+  .await
+  .map_err(|e| e.to_string())
+}
+
+#[tauri::command]
+pub async fn get_metadata(state: State<'_, Backend>) -> Result<Metadata, String> {
+  with_parser(&state, |p| p.metadata()).await
+}
+
+/// JSON text, parsed by the frontend as with the WASM getSignalsJSON
+#[tauri::command]
+pub async fn get_signals(state: State<'_, Backend>) -> Result<String, String> {
+  with_parser(&state, |p| p.signals_json()).await
+}
+
+#[tauri::command]
+pub async fn get_hierarchy(state: State<'_, Backend>) -> Result<String, String> {
+  with_parser(&state, |p| p.hierarchy_json()).await
+}
+
+#[tauri::command]
+pub async fn get_scope_page(
+  state: State<'_, Backend>,
+  scope: u32,
+  child_offset: u32,
+  child_limit: u32,
+  signal_offset: u32,
+  signal_limit: u32,
+) -> Result<Response, String> {
+  let page = with_parser(&state, move |p| {
+    p.scope_page(scope, child_offset, child_limit, signal_offset, signal_limit)
+  })
+  .await?;
+  Ok(Response::new(page))
+}
+
+#[tauri::command]
+pub async fn get_name_page(
+  state: State<'_, Backend>,
+  first: u32,
+  count: u32,
+) -> Result<Response, String> {
+  let page = with_parser(&state, move |p| p.name_page(first, count)).await?;
+  Ok(Response::new(page))
+}
+
+#[tauri::command]
+pub async fn find_signal(state: State<'_, Backend>, full_path: String) -> Result<i64, String> {
+  with_parser(&state, move |p| p.find_signal(&full_path)).await
+}
+
+#[derive(serde::Serialize)]
+#[serde(rename_all = "camelCase")]
+pub struct QueryDone {
+  /// Frames sent on the channel, which may still be in flight
+  frames: u32,
+  /// False when cancel_query or the next query ended it early
+  complete: bool,
+}
+
+/// Query [t_begin, t_end], sending each step's finalized records to
+/// `on_segment` as a columnar frame (columnar_result.h).
+#[tauri::command]
+pub async fn query(
+  state: State<'_, Backend>,
+  t_begin: u64,
+  t_end: u64,
+  signals: Vec<u32>,
+  pixel_time_step: f32,
+  on_segment: Channel<InvokeResponseBody>,
+) -> Result<QueryDone, String> {
+  let generation = state.query_generation.clone();
+  let current = generation.fetch_add(1, Ordering::SeqCst) + 1;
+  with_parser(&state, move |p| {
+    p.begin_query(t_begin, t_end, &signals, pixel_time_step);
+    // Start small so the first records show up quickly
+    let mut chunk_size = FIRST_QUERY_CHUNK_SIZE;
+    let mut frames = 0;
+    loop {
+      if generation.load(Ordering::SeqCst) != current {
+        p.cancel_query();
+        return QueryDone { frames, complete: false };
+      }
+      let keep_going = p.query_step(chunk_size);
+      chunk_size = (chunk_size * 2).min(QUERY_CHUNK_SIZE);
+      let frame = p.take_query_frame(!keep_going);
+      if on_segment.send(InvokeResponseBody::Raw(frame)).is_ok() {
+        frames += 1;
+      }
+      if !keep_going {
+        return QueryDone { frames, complete: true };
+      }
+    }
+  })
+  .await
+}
+
+/// Ends the running query after its current step.
+#[tauri::command]
+pub fn cancel_query(state: State<'_, Backend>) {
+  state.query_generation.fetch_add(1, Ordering::SeqCst);
+}
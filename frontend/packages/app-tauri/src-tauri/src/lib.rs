@@ -1,6 +1,40 @@
+#[cfg(native_parser)]
+mod commands;
+#[cfg(native_parser)]
+mod native;
+
+/// Whether this build links the native parser (see build.rs). The frontend
+/// falls back to the WASM worker when it doesn't.
+#[tauri::command]
+fn native_backend() -> bool {
+  cfg!(native_parser)
+}
+
 #[cfg_attr(mobile, tauri::mobile_entry_point)]
 pub fn run() {
-  tauri::Builder::default()
+  let builder = tauri::Builder::default().plugin(tauri_plugin_dialog::init());
+
+  #[cfg(native_parser)]
+  let builder = builder
+    .manage(commands::Backend::default())
+    .invoke_handler(tauri::generate_handler![
+      native_backend,
+      commands::file_size,
+      commands::open_waveform,
+      commands::close_waveform,
+      commands::get_metadata,
+      commands::get_signals,
+      commands::get_hierarchy,
+      commands::get_scope_page,
+      commands::get_name_page,
+      commands::find_signal,
+      commands::query,
+      commands::cancel_query,
+    ]);
+  #[cfg(not(native_parser))]
+  let builder = builder.invoke_handler(tauri::generate_handler![native_backend]);
+
+  builder
     .setup(|app| {
       if cfg!(debug_assertions) {
         app.handle().plugin(
@@ -0,0 +1,255 @@
+//! Safe wrapper over the parser's C API (include/waveform_c_api.h).
+
+use std::ffi::{c_char, c_float, c_int, c_uint, CStr, CString};
+use std::path::Path;
+
+#[repr(C)]
+struct WvParser {
+  _private: [u8; 0],
+}
+
+extern "C" {
+  fn wv_open(path: *const c_char) -> *mut WvParser;
+  fn wv_close(p: *mut WvParser);
+
+  fn wv_set_snapshot_policy(p: *mut WvParser, memory_budget: u64, max_replay_bytes: u64);
+  fn wv_set_index_threads(p: *mut WvParser, threads: c_uint);
+  fn wv_set_query_threads(p: *mut WvParser, threads: c_uint);
+  fn wv_set_transition_index(p: *mut WvParser, enabled: c_int);
+  fn wv_set_lod_pyramids(p: *mut WvParser, enabled: c_int);
+
+  fn wv_load_index(p: *mut WvParser, index_path: *const c_char) -> c_int;
+  fn wv_save_index(p: *const WvParser, index_path: *const c_char) -> c_int;
+  fn wv_begin_indexing(p: *mut WvParser);
+  fn wv_index_step(p: *mut WvParser, chunk_size: usize) -> usize;
+  fn wv_finish_indexing(p: *mut WvParser);
+  fn wv_input_position(p: *const WvParser) -> u64;
+  fn wv_is_open(p: *const WvParser) -> c_int;
+
+  fn wv_date(p: *const WvParser) -> *const c_char;
+  fn wv_version(p: *const WvParser) -> *const c_char;
+  fn wv_timescale_magnitude(p: *const WvParser) -> c_int;
+  fn wv_timescale_unit(p: *const WvParser) -> *const c_char;
+  fn wv_time_begin(p: *const WvParser) -> u64;
+  fn wv_time_end(p: *const WvParser) -> u64;
+  fn wv_signal_count(p: *const WvParser) -> u32;
+  fn wv_snapshot_count(p: *const WvParser) -> u32;
+  fn wv_index_memory_usage(p: *const WvParser) -> u64;
+
+  fn wv_signals_json(p: *mut WvParser) -> *const c_char;
+  fn wv_hierarchy_json(p: *mut WvParser) -> *const c_char;
+  fn wv_scope_page(
+    p: *mut WvParser,
+    scope: u32,
+    child_offset: u32,
+    child_limit: u32,
+    signal_offset: u32,
+    signal_limit: u32,
+    size: *mut usize,
+  ) -> *const u8;
+  fn wv_name_page(p: *mut WvParser, first: u32, count: u32, size: *mut usize) -> *const u8;
+  fn wv_find_signal(p: *const WvParser, full_path: *const c_char) -> i64;
+
+  fn wv_begin_query(
+    p: *mut WvParser,
+    start_time: u64,
+    end_time: u64,
+    signals: *const u32,
+    count: usize,
+    pixel_time_step: c_float,
+  );
+  fn wv_query_step(p: *mut WvParser, chunk_size: usize) -> c_int;
+  fn wv_cancel_query(p: *mut WvParser);
+  fn wv_take_query_frame(p: *mut WvParser, final_: c_int, size: *mut usize) -> *const u8;
+}
+
+/// Header fields of an indexed file, as WaveformMetadata on the frontend.
+#[derive(serde::Serialize)]
+#[serde(rename_all = "camelCase")]
+pub struct Metadata {
+  pub date: String,
+  pub version: String,
+  pub timescale_magnitude: i32,
+  pub timescale_unit: String,
+  pub time_begin: u64,
+  pub time_end: u64,
+  pub signal_count: u32,
+  pub snapshot_count: u32,
+  pub index_memory_usage: u64,
+}
+
+/// One open VCD or FST file.
+pub struct Parser {
+  raw: *mut WvParser,
+}
+
+// The handle is only used behind a mutex, one thread at a time.
+unsafe impl Send for Parser {}
+
+fn c_path(path: &Path) -> Option<CString> {
+  CString::new(path.to_str()?).ok()
+}
+
+fn owned(s: *const c_char) -> String {
+  if s.is_null() {
+    return String::new();
+  }
+  unsafe { CStr::from_ptr(s) }.to_string_lossy().into_owned()
+}
+
+fn bytes(data: *const u8, size: usize) -> Vec<u8> {
+  if data.is_null() || size == 0 {
+    return Vec::new();
+  }
+  unsafe { std::slice::from_raw_parts(data, size) }.to_vec()
+}
+
+impl Parser {
+  pub fn open(path: &Path) -> Option<Parser> {
+    let path = c_path(path)?;
+    let raw = unsafe { wv_open(path.as_ptr()) };
+    (!raw.is_null()).then_some(Parser { raw })
+  }
+
+  pub fn set_snapshot_policy(&mut self, memory_budget: u64, max_replay_bytes: u64) {
+    unsafe { wv_set_snapshot_policy(self.raw, memory_budget, max_replay_bytes) }
+  }
+
+  pub fn set_index_threads(&mut self, threads: u32) {
+    unsafe { wv_set_index_threads(self.raw, threads) }
+  }
+
+  pub fn set_query_threads(&mut self, threads: u32) {
+    unsafe { wv_set_query_threads(self.raw, threads) }
+  }
+
+  pub fn set_transition_index(&mut self, enabled: bool) {
+    unsafe { wv_set_transition_index(self.raw, enabled as c_int) }
+  }
+
+  pub fn set_lod_pyramids(&mut self, enabled: bool) {
+    unsafe { wv_set_lod_pyramids(self.raw, enabled as c_int) }
+  }
+
+  pub fn load_index(&mut self, index_path: &Path) -> bool {
+    c_path(index_path).map_or(false, |p| unsafe { wv_load_index(self.raw, p.as_ptr()) } != 0)
+  }
+
+  pub fn save_index(&self, index_path: &Path) -> bool {
+    c_path(index_path).map_or(false, |p| unsafe { wv_save_index(self.raw, p.as_ptr()) } != 0)
+  }
+
+  pub fn begin_indexing(&mut self) {
+    unsafe { wv_begin_indexing(self.raw) }
+  }
+
+  pub fn index_step(&mut self, chunk_size: usize) -> usize {
+    unsafe { wv_index_step(self.raw, chunk_size) }
+  }
+
+  pub fn finish_indexing(&mut self) {
+    unsafe { wv_finish_indexing(self.raw) }
+  }
+
+  /// Bytes of the file consumed so far (0 for FST)
+  pub fn input_position(&self) -> u64 {
+    unsafe { wv_input_position(self.raw) }
+  }
+
+  pub fn is_open(&self) -> bool {
+    unsafe { wv_is_open(self.raw) != 0 }
+  }
+
+  pub fn metadata(&self) -> Metadata {
+    unsafe {
+      Metadata {
+        date: owned(wv_date(self.raw)),
+        version: owned(wv_version(self.raw)),
+        timescale_magnitude: wv_timescale_magnitude(self.raw),
+        timescale_unit: owned(wv_timescale_unit(self.raw)),
+        time_begin: wv_time_begin(self.raw),
+        time_end: wv_time_end(self.raw),
+        signal_count: wv_signal_count(self.raw),
+        snapshot_count: wv_snapshot_count(self.raw),
+        index_memory_usage: wv_index_memory_usage(self.raw),
+      }
+    }
+  }
+
+  pub fn signals_json(&mut self) -> String {
+    owned(unsafe { wv_signals_json(self.raw) })
+  }
+
+  pub fn hierarchy_json(&mut self) -> String {
+    owned(unsafe { wv_hierarchy_json(self.raw) })
+  }
+
+  /// A scope page in the layout of hierarchy_pages.h
+  pub fn scope_page(
+    &mut self,
+    scope: u32,
+    child_offset: u32,
+    child_limit: u32,
+    signal_offset: u32,
+    signal_limit: u32,
+  ) -> Vec<u8> {
+    let mut size = 0;
+    let data = unsafe {
+      wv_scope_page(
+        self.raw,
+        scope,
+        child_offset,
+        child_limit,
+        signal_offset,
+        signal_limit,
+        &mut size,
+      )
+    };
+    bytes(data, size)
+  }
+
+  pub fn name_page(&mut self, first: u32, count: u32) -> Vec<u8> {
+    let mut size = 0;
+    let data = unsafe { wv_name_page(self.raw, first, count, &mut size) };
+    bytes(data, size)
+  }
+
+  pub fn find_signal(&self, full_path: &str) -> i64 {
+    CString::new(full_path).map_or(-1, |p| unsafe { wv_find_signal(self.raw, p.as_ptr()) })
+  }
+
+  pub fn begin_query(&mut self, start_time: u64, end_time: u64, signals: &[u32], pixel_time_step: f32) {
+    unsafe {
+      wv_begin_query(
+        self.raw,
+        start_time,
+        end_time,
+        signals.as_ptr(),
+        signals.len(),
+        pixel_time_step,
+      )
+    }
+  }
+
+  pub fn query_step(&mut self, chunk_size: usize) -> bool {
+    unsafe { wv_query_step(self.raw, chunk_size) != 0 }
+  }
+
+  pub fn cancel_query(&mut self) {
+    unsafe { wv_cancel_query(self.raw) }
+  }
+
+  /// Records finalized since the previous frame, in the compressed
+  /// columnar layout of columnar_result.h
+  pub fn take_query_frame(&mut self, final_: bool) -> Vec<u8> {
+    let mut size = 0;
+    let data = unsafe { wv_take_query_frame(self.raw, final_ as c_int, &mut size) };
+    bytes(data, size)
+  }
+}
+
+impl Drop for Parser {
+  fn drop(&mut self) {
+    unsafe { wv_close(self.raw) }
+  }
+}
@@ -0,0 +1,258 @@
+/**
+ * NativeWorkerBridge -- stands in for the WASM worker, answering the worker
+ * protocol with the Rust backend's commands (src-tauri/src/commands.rs), so
+ * indexing and queries run natively with threads, mmap and sidecar indexes
+ * next to the file.
+ *
+ * Files without a local path (dropped into the window) and builds without
+ * the native parser go to the real WASM worker instead, created on demand.
+ */
+
+import {
+    applyColumnarResult,
+    decodeNamePage,
+    decodeScopePage,
+    NAME_PAGE_SIZE,
+    SCOPE_PAGE_SIZE,
+} from '@waveform-viewer/core';
+import type {
+    MainToWorkerMessage,
+    WorkerToMainMessage,
+    QueryResult,
+    SignalDef,
+    SignalQueryResult,
+    ScopePage,
+} from '@waveform-viewer/core';
+import WaveformWorker from '@waveform-viewer/core/worker?worker';
+import { createChannel, hasNativeBackend, invoke } from './tauriApi.ts';
+
+const PROGRESS_THROTTLE_MS = 100;
+
+interface QueryDone {
+    frames: number;
+    complete: boolean;
+}
+
+export class NativeWorkerBridge {
+    onmessage: ((e: MessageEvent<WorkerToMainMessage>) => void) | null = null;
+    onerror: ((e: ErrorEvent) => void) | null = null;
+
+    private initMessage: MainToWorkerMessage | null = null;
+    private wasmWorker: Promise<Worker> | null = null;
+    /** Whether the open file went to the WASM worker */
+    private useWasm = false;
+
+    private signals: SignalDef[] = [];
+    /** Interned hierarchy names fetched so far, by name id */
+    private names: string[] = [];
+
+    postMessage(msg: MainToWorkerMessage): void {
+        this.handle(msg).catch(err => console.error('Native backend error:', err));
+    }
+
+    terminate(): void {
+        this.wasmWorker?.then(worker => worker.terminate());
+        this.wasmWorker = null;
+        invoke('close_waveform').catch(() => { });
+    }
+
+    private emit(data: WorkerToMainMessage): void {
+        this.onmessage?.({ data } as MessageEvent<WorkerToMainMessage>);
+    }
+
+    /** The WASM worker, initialized with the INIT message this bridge got */
+    private wasm(): Promise<Worker> {
+        if (!this.wasmWorker) {
+            this.wasmWorker = new Promise((resolve, reject) => {
+                const worker = new WaveformWorker();
+                worker.onerror = e => this.onerror?.(e);
+                worker.onmessage = (e: MessageEvent<WorkerToMainMessage>) => {
+                    if (e.data.type !== 'INIT_DONE') return;
+                    if (!e.data.success) {
+                        reject(new Error(e.data.error || 'Failed to init worker'));
+                        return;
+                    }
+                    worker.onmessage = (e: MessageEvent<WorkerToMainMessage>) => this.emit(e.data);
+                    resolve(worker);
+                };
+                worker.postMessage(this.initMessage);
+            });
+        }
+        return this.wasmWorker;
+    }
+
+    private async handle(msg: MainToWorkerMessage): Promise<void> {
+        if (msg.type === 'INIT') {
+            this.initMessage = msg;
+            try {
+                if (!await hasNativeBackend()) await this.wasm();
+                this.emit({ type: 'INIT_DONE', success: true });
+            } catch (err) {
+                this.emit({ type: 'INIT_DONE', success: false, error: (err as Error).message });
+            }
+            return;
+        }
+
+        if (msg.type === 'INDEX_FILE') {
+            this.useWasm = !msg.localPath || !!msg.file || !await hasNativeBackend();
+            if (this.useWasm) await invoke('close_waveform').catch(() => { });
+        }
+
+        if (this.useWasm) {
+            (await this.wasm()).postMessage(msg);
+            return;
+        }
+
+        switch (msg.type) {
+            case 'INDEX_FILE':
+                await this.indexFile(msg.localPath!);
+                break;
+
+            case 'QUERY':
+                await this.query(msg.tBegin, msg.tEnd, msg.signalIndices, msg.pixelTimeStep);
+                break;
+
+            case 'ABORT_QUERY':
+                await invoke('cancel_query');
+                break;
+
+            case 'GET_METADATA':
+                this.emit({ type: 'METADATA_RESULT', requestId: msg.requestId, data: await invoke('get_metadata') });
+                break;
+
+            case 'GET_SIGNALS':
+                this.emit({ type: 'SIGNALS_RESULT', requestId: msg.requestId, data: this.signals });
+                break;
+
+            case 'GET_HIERARCHY': {
+                const json = await invoke<string>('get_hierarchy');
+                this.emit({ type: 'HIERARCHY_RESULT', requestId: msg.requestId, data: JSON.parse(json) });
+                break;
+            }
+
+            case 'FIND_SIGNAL':
+                this.emit({
+                    type: 'FIND_SIGNAL_RESULT',
+                    requestId: msg.requestId,
+                    data: await invoke<number>('find_signal', { fullPath: msg.fullPath })
+                });
+                break;
+
+            case 'GET_SCOPE':
+                this.emit({
+                    type: 'SCOPE_RESULT',
+                    requestId: msg.requestId,
+                    data: await this.getScope(
+                        msg.scope,
+                        msg.childOffset ?? 0,
+                        msg.childLimit ?? SCOPE_PAGE_SIZE,
+                        msg.signalOffset ?? 0,
+                        msg.signalLimit ?? SCOPE_PAGE_SIZE
+                    )
+                });
+                break;
+
+            case 'CLOSE':
+                this.signals = [];
+                this.names = [];
+                await invoke('close_waveform');
+                break;
+        }
+    }
+
+    private async indexFile(path: string): Promise<void> {
+        this.signals = [];
+        this.names = [];
+        const onProgress = createChannel<{ bytesRead: number; totalBytes: number }>(p => {
+            this.emit({ type: 'INDEX_PROGRESS', bytesRead: p.bytesRead, totalBytes: p.totalBytes });
+        });
+        try {
+            const success = await invoke<boolean>('open_waveform', { path, onProgress });
+            if (success) this.signals = JSON.parse(await invoke<string>('get_signals')) as SignalDef[];
+            this.emit({ type: 'INDEX_DONE', success });
+        } catch (err) {
+            this.emit({ type: 'INDEX_DONE', success: false, error: String(err) });
+        }
+    }
+
+    private async query(tBegin: number, tEnd: number, signalIndices: number[], pixelTimeStep: number): Promise<void> {
+        const rollingResult: QueryResult = {
+            tBegin,
+            tEnd,
+            signals: signalIndices.map(idx => ({
+                index: idx,
+                name: this.signals[idx]?.fullPath || `signal_${idx}`,
+                initialValue: this.signals[idx]?.width === 1 ? 'x' : 'bx',
+                transitions: []
+            }))
+        };
+        const entries = new Map<number, SignalQueryResult>();
+        for (const entry of rollingResult.signals) {
+            if (!entries.has(entry.index)) entries.set(entry.index, entry);
+        }
+
+        // Frames may still arrive after the command resolves
+        let received = 0;
+        let expected = -1;
+        let allReceived: () => void = () => { };
+        const framesDone = new Promise<void>(resolve => { allReceived = resolve; });
+        let lastProgressTime = 0;
+
+        const onSegment = createChannel<ArrayBuffer>(buffer => {
+            const applied = applyColumnarResult(new Uint8Array(buffer), 0, tBegin, entries);
+            const now = Date.now();
+            if (applied > 0 && now - lastProgressTime > PROGRESS_THROTTLE_MS) {
+                this.emit({ type: 'QUERY_PROGRESS', result: { ...rollingResult } });
+                lastProgressTime = now;
+            }
+            if (++received === expected) allReceived();
+        });
+
+        try {
+            const done = await invoke<QueryDone>('query', {
+                tBegin: Math.floor(tBegin),
+                tEnd: Math.ceil(tEnd),
+                signals: signalIndices,
+                pixelTimeStep,
+                onSegment
+            });
+            expected = done.frames;
+            if (received < expected) await framesDone;
+
+            if (done.complete) {
+                this.emit({ type: 'QUERY_DONE', result: rollingResult });
+            } else {
+                this.emit({ type: 'QUERY_DONE', result: { tBegin, tEnd, signals: [] }, error: 'Query aborted' });
+            }
+        } catch (err) {
+            this.emit({ type: 'QUERY_DONE', result: { tBegin, tEnd, signals: [] }, error: String(err) });
+        }
+    }
+
+    /** Like WaveformEngine.getScope, fetching missing name pages first */
+    private async getScope(
+        scope: number,
+        childOffset: number,
+        childLimit: number,
+        signalOffset: number,
+        signalLimit: number
+    ): Promise<ScopePage> {
+        const bytes = new Uint8Array(await invoke<ArrayBuffer>('get_scope_page', {
+            scope, childOffset, childLimit, signalOffset, signalLimit
+        }));
+
+        const missing = new Set<number>();
+        decodeScopePage(bytes, id => {
+            if (this.names[id] === undefined) missing.add(id - (id % NAME_PAGE_SIZE));
+            return '';
+        });
+        for (const first of missing) {
+            const page = new Uint8Array(await invoke<ArrayBuffer>('get_name_page', { first, count: NAME_PAGE_SIZE }));
+            decodeNamePage(page, 0, page.byteLength, first, this.names);
+        }
+
+        const page = decodeScopePage(bytes, id => this.names[id] ?? '');
+        if (!page) throw new Error(`Unknown scope ${scope}`);
+        return page;
+    }
+}
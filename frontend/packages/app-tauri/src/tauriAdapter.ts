@@ -1,14 +1,15 @@
 /**
  * TauriPlatformAdapter -- Tauri desktop adapter.
  *
- * Currently Tauri is a thin webview shell with zero custom Rust commands,
- * so this adapter delegates entirely to the web-standard browser APIs.
- * It exists as a separate class so that Tauri-specific capabilities
- * (native file dialogs, IPC commands, etc.) can be added later without
- * touching the web adapter.
+ * Waveforms are indexed and queried by the native parser in the Rust
+ * backend: the worker is a NativeWorkerBridge, and files are picked with
+ * the native dialog so the backend gets their path. Dropped files (browser
+ * File objects) and builds without the native parser use the WASM worker.
  */
 
 import type { PlatformAdapter, PlatformFile, WaveformParserModule } from '@waveform-viewer/core';
+import { NativeWorkerBridge } from './nativeWorker.ts';
+import { hasNativeBackend, invoke, openFileDialog } from './tauriApi.ts';
 
 
 /** Wrap a browser File object into a PlatformFile handle. */
@@ -49,14 +50,26 @@ function showFilePicker(accept: string): Promise<File | null> {
     });
 }
 
-import WaveformWorker from '@waveform-viewer/core/worker?worker';
+/** Show the native file dialog and return a handle on the picked path. */
+async function pickLocalFile(extensions: string[]): Promise<PlatformFile | null> {
+    const path = await openFileDialog([{
+        name: 'Waveforms',
+        extensions: extensions.map(ext => ext.replace(/^\./, '')),
+    }]);
+    if (typeof path !== 'string') return null;
+    return {
+        name: path.split(/[\\/]/).pop() ?? path,
+        size: await invoke<number>('file_size', { path }),
+        localPath: path,
+    };
+}
 
 
 export class TauriPlatformAdapter implements PlatformAdapter {
     readonly platformName = 'tauri' as const;
 
     createWorker(): Worker {
-        return new WaveformWorker();
+        return new NativeWorkerBridge() as unknown as Worker;
     }
 
     getWasmConfig(): { jsUri: string; binaryUri?: string } {
@@ -70,7 +83,9 @@ export class TauriPlatformAdapter implements PlatformAdapter {
 
 
     async pickFile(options?: { extensions?: string[] }): Promise<PlatformFile | null> {
-        // TODO: Replace with Tauri native file dialog when @tauri-apps/api is added
+        if (await hasNativeBackend()) {
+            return pickLocalFile(options?.extensions ?? ['.vcd']);
+        }
         const accept = options?.extensions?.join(',') ?? '.vcd';
         const file = await showFilePicker(accept);
         if (!file) return null;
@@ -0,0 +1,53 @@
+/**
+ * The parts of the Tauri JS API this app uses, read from the global the
+ * webview injects (`app.withGlobalTauri` in tauri.conf.json).
+ */
+
+export interface TauriChannel<T> {
+    onmessage: (message: T) => void;
+}
+
+export interface TauriDialogFilter {
+    name: string;
+    extensions: string[];
+}
+
+interface TauriGlobal {
+    core: {
+        invoke<T>(cmd: string, args?: Record<string, unknown>): Promise<T>;
+        Channel: new <T>() => TauriChannel<T>;
+    };
+    dialog: {
+        open(options?: { multiple?: boolean; directory?: boolean; filters?: TauriDialogFilter[] }): Promise<string | string[] | null>;
+    };
+}
+
+function tauri(): TauriGlobal {
+    const global = (window as unknown as { __TAURI__?: TauriGlobal }).__TAURI__;
+    if (!global) throw new Error('Tauri API not available');
+    return global;
+}
+
+export function invoke<T>(cmd: string, args?: Record<string, unknown>): Promise<T> {
+    return tauri().core.invoke<T>(cmd, args);
+}
+
+export function createChannel<T>(onmessage: (message: T) => void): TauriChannel<T> {
+    const channel = new (tauri().core.Channel)<T>();
+    channel.onmessage = onmessage;
+    return channel;
+}
+
+export function openFileDialog(filters: TauriDialogFilter[]): Promise<string | string[] | null> {
+    return tauri().dialog.open({ multiple: false, directory: false, filters });
+}
+
+let nativeBackend: Promise<boolean> | null = null;
+
+/** Whether the Rust side links the native parser (it doesn't on every platform) */
+export function hasNativeBackend(): Promise<boolean> {
+    if (!nativeBackend) {
+        nativeBackend = invoke<boolean>('native_backend').catch(() => false);
+    }
+    return nativeBackend;
+}
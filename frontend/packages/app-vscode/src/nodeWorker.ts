@@ -57,13 +57,14 @@ parentPort.on('message', async (msg: MainToWorkerMessage) => {
                     throw new Error('NODEFS requires a local path');
                 }
 
+                // NODEFS writes through, so the sidecar lands next to the file
                 const success = await engine.indexFile(filePath, msg.fileSize, (bytesRead: number, totalBytes: number) => {
                     parentPort!.postMessage({
                         type: 'INDEX_PROGRESS',
                         bytesRead,
                         totalBytes
                     } as WorkerToMainMessage);
-                });
+                }, filePath + '.wvidx');
 
                 parentPort!.postMessage({
                     type: 'INDEX_DONE',
@@ -159,6 +160,18 @@ parentPort.on('message', async (msg: MainToWorkerMessage) => {
                 break;
             }
 
+            case 'GET_SCOPE': {
+                if (!engine) return;
+                parentPort!.postMessage({
+                    type: 'SCOPE_RESULT',
+                    requestId: msg.requestId,
+                    data: engine.getScope(
+                        msg.scope, msg.childOffset, msg.childLimit, msg.signalOffset, msg.signalLimit
+                    )
+                } as WorkerToMainMessage);
+                break;
+            }
+
             case 'CLOSE': {
                 if (engine) engine.close();
                 break;
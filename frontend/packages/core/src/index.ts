@@ -7,6 +7,14 @@ export type {
     QueryResult,
     QueryPlan,
     QueryResultBinaryRaw,
+    QueryResultColumnarRaw,
+    QueryResultHandle,
+    SearchKind,
+    SearchResult,
+    HeapBytesRaw,
+    ScopePage,
+    ScopeChildEntry,
+    ScopeSignalEntry,
     VcdParser,
     FstParser,
     WaveformParserModule,
@@ -23,6 +31,11 @@ export type {
     PlatformFile,
 } from './types/platform.ts';
 
+export type {
+    MainToWorkerMessage,
+    WorkerToMainMessage,
+} from './worker/protocol.ts';
+
 // ── State ──────────────────────────────────────────────────────────────
 export {
     appReducer,
@@ -35,6 +48,13 @@ export type {
 
 // ── Services ───────────────────────────────────────────────────────────
 export { WaveformServiceClient as WaveformService } from './wasm/waveformServiceClient.ts';
+export {
+    applyColumnarResult,
+    decodeScopePage,
+    decodeNamePage,
+    NAME_PAGE_SIZE,
+    SCOPE_PAGE_SIZE,
+} from './wasm/binaryDecoders.ts';
 
 // ── Plugins ────────────────────────────────────────────────────────────
 export { coreRadixPlugin } from './plugins/coreRadixPlugin.ts';
@@ -46,6 +46,94 @@ export interface QueryPlan {
     snapshot_index: number;
 }
 
+/** A byte range in WASM memory, valid until the call that produced it is repeated */
+export interface HeapBytesRaw {
+    ptr: number;
+    size: number;
+}
+
+/** A child scope listed in a ScopePage */
+export interface ScopeChildEntry {
+    scope: number;
+    name: string;
+    childCount: number;
+    signalCount: number;
+    totalSignalCount: number;
+}
+
+/** A signal listed in a ScopePage */
+export interface ScopeSignalEntry {
+    index: number;
+    name: string;
+    width: number;
+    type: string;
+    msb?: number;
+    lsb?: number;
+}
+
+/**
+ * One page of a scope: its own counts plus the children and signals in
+ * [childOffset, childOffset + children.length) and
+ * [signalOffset, signalOffset + signals.length). The root is scope 0.
+ */
+export interface ScopePage {
+    scope: number;
+    /** -1 for the root */
+    parent: number;
+    name: string;
+    childCount: number;
+    signalCount: number;
+    totalSignalCount: number;
+    childOffset: number;
+    children: ScopeChildEntry[];
+    signalOffset: number;
+    signals: ScopeSignalEntry[];
+}
+
+/** Counters of the FST decoded block cache */
+export interface BlockCacheStats {
+    hits: number;
+    misses: number;
+    entries: number;
+    memoryUsage: number;
+}
+
+/** Counters of the per-signal query result cache */
+export interface QueryCacheStats {
+    /** Signals answered from the cache alone */
+    hits: number;
+    /** Signals whose cached records were spliced around a shorter replay */
+    partialHits: number;
+    misses: number;
+    entries: number;
+    memoryUsage: number;
+}
+
+/** getStatsJSON(), parsed: counters since setStatsEnabled */
+export interface ParserStats {
+    bytesScanned: number;
+    linesParsed: number;
+    idLookups: number;
+    changesApplied: number;
+    changesEmitted: number;
+    glitchesCollapsed: number;
+    /** FST only, estimated */
+    blocksDecoded: number;
+    /** By phase: open, index, load_index, begin_query, snapshot_restore, query_step, flush, search */
+    phases: Record<string, { ms: number; calls: number }>;
+}
+
+/** findNext() kind, as SearchKind in waveform_parser.h: 0 any change, 1 rising, 2 falling, 3 equals */
+export type SearchKind = 0 | 1 | 2 | 3;
+
+/** findNext() result; `time` is meaningless unless `found` */
+export interface SearchResult {
+    found: boolean;
+    time: number;
+    /** The Equals value is neither binary nor hex: nothing was searched */
+    invalidValue: boolean;
+}
+
 /** Binary query result raw pointers from WASM */
 export interface QueryResultBinaryRaw {
     ptr1Bit: number;
@@ -56,6 +144,26 @@ export interface QueryResultBinaryRaw {
     countStringPool: number;
 }
 
+/**
+ * Columnar query result in WASM memory: one run per queried signal, in
+ * begin_query order (layout documented in columnar_result.h)
+ */
+export interface QueryResultColumnarRaw {
+    ptr: number;
+    size: number;
+}
+
+/**
+ * Columnar result in one of a few WASM-side arenas. Its bytes stay valid
+ * until release_query_result(handle), or until the file is closed or
+ * another one opened; views must still be taken from the current HEAPU8,
+ * which memory growth may replace. handle is 0 (and no result was taken)
+ * while every arena is held.
+ */
+export interface QueryResultHandle extends QueryResultColumnarRaw {
+    handle: number;
+}
+
 /**
  * VcdParser WASM class instance — two-phase API.
  *
@@ -64,7 +172,7 @@ export interface QueryResultBinaryRaw {
  *   push_chunk_for_index() loop -> finish_indexing()
  *
  * Phase 2 — Query:
- *   get_query_plan() -> begin_query() ->
+ *   get_query_plan() -> query_indices_buffer() -> begin_query() ->
  *   push_chunk_for_query() loop -> finish_query_binary()
  */
 export interface VcdParser {
@@ -78,22 +186,53 @@ export interface VcdParser {
     close_file(): void;
 
     /* Indexing phase */
+    /**
+     * Cap snapshot memory (bytes, 0 = unlimited) and the bytes replayed
+     * between snapshots (0 = default 10 MB). The budget wins on conflict.
+     */
+    set_snapshot_policy(memory_budget: number, max_replay_bytes: number): void;
+    /** Record per-signal change intervals for sparse queries (no-op on FST) */
+    set_transition_index(enabled: boolean): void;
+    /** Cache zoomed-out summaries built by whole-trace queries (no-op on FST) */
+    set_lod_pyramids(enabled: boolean): void;
+    /** Threads decoding or replaying a query, 0 = all cores (no-op on unthreaded builds) */
+    set_query_threads(threads: number): void;
+    /** Bytes of decoded value changes kept across queries (no-op on VCD) */
+    set_block_cache_budget(bytes: number): void;
+    /** Bytes of finished query results kept per signal and resolution, 0 = off */
+    set_query_cache_budget(bytes: number): void;
     begin_indexing(): void;
     index_step(chunk_size: number): number;
     finish_indexing(): void;
+    /** Keep indexing a file that is still being written (set before begin_indexing; no-op on FST) */
+    set_follow(enabled: boolean): void;
+    /** Index bytes appended since the last pass; 0 once caught up */
+    follow_step(chunk_size: number): number;
+
+    /* Index persistence (FST has nothing to persist and returns false) */
+    save_index(index_path: string): boolean;
+    load_index(index_path: string): boolean;
 
     /* Query phase */
     get_query_plan(start_time: number): QueryPlan;
+    /** Room for `count` u32 signal indices in WASM memory, read by the next begin_query */
+    query_indices_buffer(count: number): number;
     begin_query(
         start_time: number,
         end_time: number,
-        indicesJSON: string,
+        count: number,
         snapshot_index: number,
         pixel_time_step: number
     ): void;
     query_step(chunk_size: number): boolean;
     cancel_query(): void;
     flush_query_binary(): QueryResultBinaryRaw;
+    /** Same result grouped per signal; `compressed` varint-encodes time deltas */
+    flush_query_columnar(compressed: boolean): QueryResultColumnarRaw;
+    acquire_query_result(compressed: boolean): QueryResultHandle;
+    /** Records finalized since the last segment; `final` after the last query_step adds the rest */
+    acquire_query_segment(final: boolean, compressed: boolean): QueryResultHandle;
+    release_query_result(handle: number): boolean;
 
     /* Metadata accessors */
     getDate(): string;
@@ -105,10 +244,47 @@ export interface VcdParser {
     getSignalCount(): number;
     getSnapshotCount(): number;
     getIndexMemoryUsage(): number;
+    /** Decoded block cache counters (all zero on VCD) */
+    getBlockCacheStats(): BlockCacheStats;
+    getQueryCacheStats(): QueryCacheStats;
+    /** Collect hot-path counters (and with `trace` a phase timeline) from now on */
+    setStatsEnabled(enabled: boolean, trace: boolean): void;
+    /** ParserStats as JSON; all zero while disabled */
+    getStatsJSON(): string;
+    /** Chrome trace-event JSON, for chrome://tracing or Perfetto */
+    getTraceJSON(): string;
+
+    /* Value search */
+    /**
+     * First change of `signal` after `from_time` (last before it when
+     * `backward`) matching `kind`; `value` (binary, or hex after "0x" or
+     * "h") is for Equals
+     */
+    findNext(
+        signal: number,
+        kind: SearchKind,
+        value: string,
+        from_time: number,
+        backward: boolean
+    ): SearchResult;
 
     /* Signal / hierarchy */
     getSignalsJSON(): string;
     getHierarchyJSON(): string;
+    /** Paged binary hierarchy, layout documented in hierarchy_pages.h */
+    getScopeCount(): number;
+    getNameCount(): number;
+    getScopePage(
+        scope: number,
+        child_offset: number,
+        child_limit: number,
+        signal_offset: number,
+        signal_limit: number
+    ): HeapBytesRaw;
+    getNamePage(first: number, count: number): HeapBytesRaw;
+    /** '' / 0 for an unknown index */
+    getSignalPath(index: number): string;
+    getSignalWidth(index: number): number;
     findSignal(fullPath: string): number;
 }
 
@@ -0,0 +1,187 @@
+/**
+ * Decoders for the parser's binary layouts, shared by the WASM engine (which
+ * reads them from the module heap) and hosts that receive the same bytes
+ * over IPC, such as the Tauri native backend.
+ */
+
+import type {
+    SignalQueryResult,
+    ScopePage,
+    ScopeChildEntry,
+    ScopeSignalEntry,
+} from '../types/waveform.ts';
+
+/* Columnar result layout, see columnar_result.h */
+const COLUMNAR_HEADER_SIZE = 8;
+const COLUMNAR_ENTRY_SIZE = 20;
+const COLUMNAR_COMPRESSED = 1;
+const RUN_MULTIBIT = 1;
+const RUN_WIDE_VALUES = 2;
+
+const VALUE_MAP = ['0', '1', 'x', 'z', 'g'] as const;
+
+/* Hierarchy pages, see hierarchy_pages.h */
+const SCOPE_HEADER_SIZE = 40;
+const CHILD_ENTRY_SIZE = 20;
+const SIGNAL_ENTRY_SIZE = 24;
+const NO_SCOPE = 0xffffffff;
+/** Names fetched per name page request */
+export const NAME_PAGE_SIZE = 4096;
+/** Children and signals per scope page by default */
+export const SCOPE_PAGE_SIZE = 1000;
+
+/** VarType in declaration order */
+const VAR_TYPES = [
+    'wire', 'reg', 'integer', 'real', 'parameter', 'event', 'supply0', 'supply1',
+    'tri', 'triand', 'trior', 'trireg', 'tri0', 'tri1', 'wand', 'wor', 'unknown',
+] as const;
+
+/**
+ * Apply the columnar result (or segment) at `bytes[ptr]` to `entries`, in
+ * record order: records at or before tBegin set the initial value, later
+ * ones are appended. Each run already holds one signal's records in time
+ * order. Returns the number of records applied.
+ */
+export function applyColumnarResult(
+    bytes: Uint8Array,
+    ptr: number,
+    tBegin: number,
+    entries: Map<number, SignalQueryResult>
+): number {
+    const dataView = new DataView(bytes.buffer, bytes.byteOffset, bytes.byteLength);
+    const textDecoder = new TextDecoder();
+
+    const runCount = dataView.getUint32(ptr, true);
+    const compressed = (dataView.getUint32(ptr + 4, true) & COLUMNAR_COMPRESSED) !== 0;
+    let applied = 0;
+
+    for (let r = 0; r < runCount; r++) {
+        const base = ptr + COLUMNAR_HEADER_SIZE + r * COLUMNAR_ENTRY_SIZE;
+        const entry = entries.get(dataView.getUint32(base, true));
+        const count = dataView.getUint32(base + 4, true);
+        const flags = dataView.getUint32(base + 8, true);
+        if (!entry || count === 0) continue;
+
+        let timePos = ptr + dataView.getUint32(base + 12, true);
+        let valuePos = ptr + dataView.getUint32(base + 16, true);
+        const multi = (flags & RUN_MULTIBIT) !== 0;
+        const bits = (flags & RUN_WIDE_VALUES) ? 4 : 2;
+
+        let timestamp = 0;
+        for (let i = 0; i < count; i++) {
+            if (compressed) {
+                let delta = 0;
+                let scale = 1;
+                let b: number;
+                do {
+                    b = bytes[timePos++];
+                    delta += (b & 0x7f) * scale;
+                    scale *= 0x80;
+                } while (b & 0x80);
+                timestamp += delta;
+            } else {
+                timestamp = dataView.getUint32(timePos, true) +
+                    dataView.getUint32(timePos + 4, true) * 0x100000000;
+                timePos += 8;
+            }
+
+            let value: string;
+            if (multi) {
+                let length = 0;
+                let scale = 1;
+                let b: number;
+                do {
+                    b = bytes[valuePos++];
+                    length += (b & 0x7f) * scale;
+                    scale *= 0x80;
+                } while (b & 0x80);
+                value = textDecoder.decode(bytes.subarray(valuePos, valuePos + length));
+                valuePos += length;
+            } else {
+                const bit = i * bits;
+                const v = (bytes[valuePos + (bit >> 3)] >> (bit & 7)) & ((1 << bits) - 1);
+                value = VALUE_MAP[v] ?? 'x';
+            }
+
+            if (timestamp <= tBegin) {
+                entry.initialValue = value;
+                entry.transitions = [];
+            } else {
+                entry.transitions.push([timestamp, value]);
+            }
+        }
+        applied += count;
+    }
+
+    return applied;
+}
+
+/**
+ * Decode a scope page; `nameOf` resolves interned name ids. Returns null
+ * for the empty page of an unknown scope.
+ */
+export function decodeScopePage(bytes: Uint8Array, nameOf: (id: number) => string): ScopePage | null {
+    if (bytes.byteLength < SCOPE_HEADER_SIZE) return null;
+    const view = new DataView(bytes.buffer, bytes.byteOffset, bytes.byteLength);
+    const u32 = (offset: number) => view.getUint32(offset, true);
+
+    const children: ScopeChildEntry[] = [];
+    const childCount = u32(28);
+    for (let i = 0; i < childCount; i++) {
+        const base = SCOPE_HEADER_SIZE + i * CHILD_ENTRY_SIZE;
+        children.push({
+            scope: u32(base),
+            name: nameOf(u32(base + 4)),
+            childCount: u32(base + 8),
+            signalCount: u32(base + 12),
+            totalSignalCount: u32(base + 16),
+        });
+    }
+
+    const signals: ScopeSignalEntry[] = [];
+    const signalBase = SCOPE_HEADER_SIZE + childCount * CHILD_ENTRY_SIZE;
+    const signalCount = u32(36);
+    for (let i = 0; i < signalCount; i++) {
+        const base = signalBase + i * SIGNAL_ENTRY_SIZE;
+        const entry: ScopeSignalEntry = {
+            index: u32(base),
+            name: nameOf(u32(base + 4)),
+            width: u32(base + 8),
+            type: VAR_TYPES[u32(base + 12)] ?? 'unknown',
+        };
+        const msb = view.getInt32(base + 16, true);
+        if (msb >= 0) {
+            entry.msb = msb;
+            entry.lsb = view.getInt32(base + 20, true);
+        }
+        signals.push(entry);
+    }
+
+    const parent = u32(4);
+    return {
+        scope: u32(0),
+        parent: parent === NO_SCOPE ? -1 : parent,
+        name: nameOf(u32(8)),
+        childCount: u32(12),
+        signalCount: u32(16),
+        totalSignalCount: u32(20),
+        childOffset: u32(24),
+        children,
+        signalOffset: u32(32),
+        signals,
+    };
+}
+
+/** Store the names of the page at `bytes[ptr]` into `names`, from index `first` */
+export function decodeNamePage(bytes: Uint8Array, ptr: number, size: number, first: number, names: string[]): void {
+    if (size < 8) return;
+    const view = new DataView(bytes.buffer, bytes.byteOffset, bytes.byteLength);
+    const count = view.getUint32(ptr, true);
+    const text = ptr + 4 * (count + 2);
+    const textDecoder = new TextDecoder();
+    for (let i = 0; i < count; i++) {
+        const begin = view.getUint32(ptr + 4 * (i + 1), true);
+        const end = view.getUint32(ptr + 4 * (i + 2), true);
+        names[first + i] = textDecoder.decode(bytes.subarray(text + begin, text + end));
+    }
+}
@@ -13,20 +13,43 @@ import type {
     ScopeNode,
     QueryResult,
     SignalQueryResult,
+    ScopePage,
 } from '../types/waveform.ts';
+import {
+    applyColumnarResult,
+    decodeNamePage,
+    decodeScopePage,
+    NAME_PAGE_SIZE,
+    SCOPE_PAGE_SIZE,
+} from './binaryDecoders.ts';
 
 const INDEX_CHUNK_SIZE = 32 * 1024 * 1024;
 const QUERY_CHUNK_SIZE = 32 * 1024 * 1024;
+/** First query step; steps double from here up to QUERY_CHUNK_SIZE. */
+const FIRST_QUERY_CHUNK_SIZE = 1024 * 1024;
 
-const SIZEOF_TRANSITION_1BIT = 16;
-const SIZEOF_TRANSITION_MULTIBIT = 24;
+/** Ceiling for snapshot memory: a quarter of the 2 GB WASM heap. */
+const MAX_SNAPSHOT_BUDGET = 512 * 1024 * 1024;
 
-const VALUE_MAP = ['0', '1', 'x', 'z', 'g'] as const;
+/**
+ * Default snapshot memory budget: an eighth of the device memory where the
+ * browser reports it (navigator.deviceMemory, in GB), capped so the rest of
+ * the WASM heap stays available for queries.
+ */
+function defaultSnapshotBudget(): number {
+    const deviceGB = (globalThis.navigator as { deviceMemory?: number } | undefined)?.deviceMemory;
+    if (!deviceGB) return MAX_SNAPSHOT_BUDGET;
+    return Math.min(MAX_SNAPSHOT_BUDGET, Math.floor(deviceGB * 1024 * 1024 * 1024 / 8));
+}
 
 export class WaveformEngine {
     private parser: VcdParser | FstParser | null = null;
     public module: WaveformParserModule;
     private fileExtension: string = '';
+    private snapshotBudget = defaultSnapshotBudget();
+    private maxReplayBytes = 0;
+    /** Interned hierarchy names fetched so far, by name id */
+    private names: string[] = [];
 
     constructor(module: WaveformParserModule) {
         this.module = module;
@@ -40,10 +63,26 @@ export class WaveformEngine {
         return this.parser !== null && this.parser.isOpen();
     }
 
+    /**
+     * Snapshot placement for subsequently indexed files: at most
+     * `memoryBudget` bytes of snapshots (0 = unlimited), at most
+     * `maxReplayBytes` scanned per query start (0 = parser default).
+     */
+    setSnapshotPolicy(memoryBudget: number, maxReplayBytes = 0): void {
+        this.snapshotBudget = memoryBudget;
+        this.maxReplayBytes = maxReplayBytes;
+    }
+
+    /**
+     * Index `filePath`. When `indexPath` is given, a sidecar index written by
+     * an earlier run is loaded from it instead (if still valid for the file),
+     * and a freshly built index is saved to it.
+     */
     async indexFile(
         filePath: string,
         fileSize: number,
-        onProgress?: (bytesRead: number, totalBytes: number) => void
+        onProgress?: (bytesRead: number, totalBytes: number) => void,
+        indexPath?: string
     ): Promise<boolean> {
         this.close();
 
@@ -60,18 +99,34 @@ export class WaveformEngine {
             return false;
         }
 
+        // The viewer queries a handful of visible signals at a time, which
+        // is exactly the case the transition index speeds up.
+        this.parser!.set_transition_index(true);
+        // Fully zoomed-out redraws then come from cached summaries
+        this.parser!.set_lod_pyramids(true);
+        this.parser!.set_snapshot_policy(this.snapshotBudget, this.maxReplayBytes);
+        // Only takes effect in a pthread build of the module
+        this.parser!.set_query_threads(0);
+
+        if (indexPath && this.parser!.load_index(indexPath)) {
+            onProgress?.(fileSize, fileSize);
+            return true;
+        }
+
         this.parser!.begin_indexing();
 
         let offset = 0;
 
-        while (offset < fileSize) {
+        // A gzip VCD yields more bytes than it has on disk, so read to the
+        // end rather than to fileSize
+        for (;;) {
             const bytesRead = this.parser!.index_step(INDEX_CHUNK_SIZE);
             if (bytesRead === 0) break; // EOF or error
 
             offset += bytesRead;
             // Since FST parsing is an all-at-once blocking call right now inside WASM,
             // we will simulate progress if it immediately returns 0 bytes.
-            onProgress?.(offset, fileSize);
+            onProgress?.(Math.min(offset, fileSize), fileSize);
 
             // Yield to event loop to allow messages (like ABORT) to process
             await new Promise(resolve => setTimeout(resolve, 0));
@@ -83,6 +138,9 @@ export class WaveformEngine {
             return false;
         }
 
+        // A read-only mount just means the next open indexes again
+        if (indexPath) this.parser!.save_index(indexPath);
+
         // Just ensure progress is 100%
         onProgress?.(fileSize, fileSize);
 
@@ -106,10 +164,12 @@ export class WaveformEngine {
         const safeTEnd = Math.ceil(tEnd);
         const plan = parser.get_query_plan(BigInt(safeTBegin) as unknown as number);
 
+        const indicesPtr = parser.query_indices_buffer(signalIndices.length);
+        new Uint32Array(mod.HEAPU8.buffer, indicesPtr, signalIndices.length).set(signalIndices);
         parser.begin_query(
             BigInt(safeTBegin) as unknown as number,
             BigInt(safeTEnd) as unknown as number,
-            JSON.stringify(signalIndices),
+            signalIndices.length,
             plan.snapshot_index,
             pixelTimeStep
         );
@@ -122,39 +182,33 @@ export class WaveformEngine {
             tEnd,
             signals: signalIndices.map(idx => ({
                 index: idx,
-                name: '',
-                initialValue: 'x',
+                name: parser.getSignalPath(idx) || `signal_${idx}`,
+                initialValue: parser.getSignalWidth(idx) === 1 ? 'x' : 'bx',
                 transitions: []
             }))
         };
-        const CHUNK_SIZE = 10000;
+        const entries = new Map<number, SignalQueryResult>();
+        for (const entry of rollingResult.signals) {
+            if (!entries.has(entry.index)) entries.set(entry.index, entry);
+        }
         const PROGRESS_THROTTLE_MS = 100;
         let lastProgressTime = 0;
 
-        let isFirstSlice = true;
-        const flushToRolling = (forceProgress = false) => {
-            const rawResult = parser.flush_query_binary();
-            const slice = this.decodeBinaryResult(rawResult, mod, tBegin, tEnd, signalIndices);
-
-            let hasNewData = false;
-            for (let i = 0; i < slice.signals.length; i++) {
-                const s = slice.signals[i];
-                const r = rollingResult.signals[i];
-
-                if (isFirstSlice) {
-                    r.name = s.name;
-                    r.initialValue = s.initialValue;
-                }
-                if (s.transitions.length > 0) {
-                    r.transitions.push(...s.transitions);
-                    hasNewData = true;
-                }
+        // Each segment only holds records that are final, so it is appended
+        // to the rolling result and can be drawn right away.
+        const appendSegment = (final: boolean) => {
+            const segment = parser.acquire_query_segment(final, true);
+            if (segment.handle === 0) throw new Error('No free query result arena');
+            let applied: number;
+            try {
+                applied = applyColumnarResult(mod.HEAPU8, segment.ptr, tBegin, entries);
+            } finally {
+                parser.release_query_result(segment.handle);
             }
-            isFirstSlice = false;
 
-            if (hasNewData && onProgress) {
+            if ((applied > 0 || final) && onProgress) {
                 const now = Date.now();
-                if (forceProgress || (now - lastProgressTime > PROGRESS_THROTTLE_MS)) {
+                if (final || (now - lastProgressTime > PROGRESS_THROTTLE_MS)) {
                     onProgress({ ...rollingResult });
                     lastProgressTime = now;
                 }
@@ -162,12 +216,15 @@ export class WaveformEngine {
         };
 
         try {
+            // Start small so the first records show up quickly
+            let chunkSize = FIRST_QUERY_CHUNK_SIZE;
             while (true) {
                 if (abortSignal?.aborted) throw new Error('Query aborted');
 
-                const keepGoing = parser.query_step(QUERY_CHUNK_SIZE);
+                const keepGoing = parser.query_step(chunkSize);
+                chunkSize = Math.min(chunkSize * 2, QUERY_CHUNK_SIZE);
 
-                flushToRolling();
+                appendSegment(false);
 
                 if (!keepGoing) break;
 
@@ -177,7 +234,7 @@ export class WaveformEngine {
             abortSignal?.removeEventListener('abort', onAbort);
         }
 
-        flushToRolling(true); // Final forced progress report
+        appendSegment(true); // Final forced progress report
         return rollingResult;
     }
 
@@ -207,12 +264,36 @@ export class WaveformEngine {
         return JSON.parse(this.parser!.getHierarchyJSON()) as ScopeNode;
     }
 
+    /**
+     * One page of a scope's children and signals (the root is scope 0).
+     * Names are resolved from the interned name table, fetched in pages
+     * the first time they are needed.
+     */
+    getScope(
+        scope: number,
+        childOffset = 0,
+        childLimit = SCOPE_PAGE_SIZE,
+        signalOffset = 0,
+        signalLimit = SCOPE_PAGE_SIZE
+    ): ScopePage {
+        this.assertOpen();
+        const parser = this.parser!;
+        const raw = parser.getScopePage(scope, childOffset, childLimit, signalOffset, signalLimit);
+
+        // Copy out first: fetching names may grow the heap
+        const bytes = this.module.HEAPU8.slice(raw.ptr, raw.ptr + raw.size);
+        const page = decodeScopePage(bytes, id => this.nameOf(id));
+        if (!page) throw new Error(`Unknown scope ${scope}`);
+        return page;
+    }
+
     findSignal(fullPath: string): number {
         this.assertOpen();
         return this.parser!.findSignal(fullPath);
     }
 
     close(): void {
+        this.names = [];
         if (this.parser) {
             this.parser.close();
             this.parser.delete();
@@ -220,82 +301,16 @@ export class WaveformEngine {
         }
     }
 
-    private decodeBinaryResult(
-        raw: { ptr1Bit: number; count1Bit: number; ptrMulti: number; countMulti: number; ptrStringPool: number; countStringPool: number },
-        mod: WaveformParserModule,
-        tBegin: number,
-        tEnd: number,
-        signalIndices: number[]
-    ): QueryResult {
-        const heap = mod.HEAPU8;
-        const dataView = new DataView(heap.buffer);
-        const allSignals: SignalDef[] = JSON.parse(this.parser!.getSignalsJSON());
-
-        const signalMap = new Map<number, SignalQueryResult>();
-        for (const idx of signalIndices) {
-            const sig = allSignals[idx];
-            signalMap.set(idx, {
-                index: idx,
-                name: sig?.fullPath ?? `signal_${idx}`,
-                initialValue: sig?.width === 1 ? 'x' : 'bx',
-                transitions: [],
-            });
-        }
-
-        for (let i = 0; i < raw.count1Bit; i++) {
-            const base = raw.ptr1Bit + i * SIZEOF_TRANSITION_1BIT;
-            const tsLow = dataView.getUint32(base, true);
-            const tsHigh = dataView.getUint32(base + 4, true);
-            const timestamp = tsLow + tsHigh * 0x100000000;
-            const signalIndex = dataView.getUint32(base + 8, true);
-            const value = heap[base + 12];
-
-            const entry = signalMap.get(signalIndex);
-            if (!entry) continue;
-
-            if (timestamp <= tBegin) {
-                entry.initialValue = VALUE_MAP[value] ?? 'x';
-                entry.transitions = [];
-            } else {
-                entry.transitions.push([timestamp, VALUE_MAP[value] ?? 'x']);
-            }
-        }
-
-        const textDecoder = new TextDecoder();
-        for (let i = 0; i < raw.countMulti; i++) {
-            const base = raw.ptrMulti + i * SIZEOF_TRANSITION_MULTIBIT;
-            const tsLow = dataView.getUint32(base, true);
-            const tsHigh = dataView.getUint32(base + 4, true);
-            const timestamp = tsLow + tsHigh * 0x100000000;
-            const signalIndex = dataView.getUint32(base + 8, true);
-            const strOffset = dataView.getUint32(base + 12, true);
-            const strLength = dataView.getUint32(base + 16, true);
-
-            const entry = signalMap.get(signalIndex);
-            if (!entry) continue;
-
-            const strBytes = heap.subarray(
-                raw.ptrStringPool + strOffset,
-                raw.ptrStringPool + strOffset + strLength
-            );
-            const valStr = textDecoder.decode(strBytes);
-
-
-            if (timestamp <= tBegin) {
-                entry.initialValue = valStr;
-                entry.transitions = [];
-            } else {
-                entry.transitions.push([timestamp, valStr]);
-            }
-        }
-
-        const resultSignals: SignalQueryResult[] = [];
-        for (const idx of signalIndices) {
-            const entry = signalMap.get(idx);
-            if (entry) resultSignals.push(entry);
-        }
+    private nameOf(id: number): string {
+        if (this.names[id] === undefined) this.fetchNames(id);
+        return this.names[id] ?? '';
+    }
 
-        return { tBegin, tEnd, signals: resultSignals };
+    /** Fill the name cache with the page holding name `id` */
+    private fetchNames(id: number): void {
+        const first = id - (id % NAME_PAGE_SIZE);
+        const raw = this.parser!.getNamePage(first, NAME_PAGE_SIZE);
+        decodeNamePage(this.module.HEAPU8, raw.ptr, raw.size, first, this.names);
     }
 
     private assertOpen(): void {
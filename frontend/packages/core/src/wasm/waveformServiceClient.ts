@@ -9,6 +9,7 @@ import type {
     SignalDef,
     ScopeNode,
     QueryResult,
+    ScopePage,
 } from '../types/waveform.ts';
 import type { PlatformAdapter, PlatformFile } from '../types/platform.ts';
 import type { MainToWorkerMessage, WorkerToMainMessage } from '../worker/protocol.ts';
@@ -159,6 +160,19 @@ export class WaveformServiceClient {
         return this.sendRpcRequest<number>('FIND_SIGNAL', { fullPath });
     }
 
+    /** One page of a scope's children and signals; the root is scope 0 */
+    async getScope(
+        scope: number,
+        childOffset?: number,
+        childLimit?: number,
+        signalOffset?: number,
+        signalLimit?: number
+    ): Promise<ScopePage> {
+        return this.sendRpcRequest<ScopePage>('GET_SCOPE', {
+            scope, childOffset, childLimit, signalOffset, signalLimit
+        });
+    }
+
     // For backwards compatibility and synchronous needs in React.
     // In a worker setup, we might need to pre-fetch these when index finishes.
     // For now, these will throw if not pre-fetched, but we'll try to provide them.
@@ -280,6 +294,7 @@ export class WaveformServiceClient {
             case 'SIGNALS_RESULT':
             case 'HIERARCHY_RESULT':
             case 'FIND_SIGNAL_RESULT':
+            case 'SCOPE_RESULT':
                 const pending = this.pendingRequests.get(msg.requestId);
                 if (pending) {
                     this.pendingRequests.delete(msg.requestId);
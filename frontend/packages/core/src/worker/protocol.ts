@@ -1,4 +1,4 @@
-import type { QueryResult } from '../types/waveform.ts';
+import type { QueryResult, ScopePage } from '../types/waveform.ts';
 
 export type MainToWorkerMessage =
     | { type: 'INIT'; wasmJsUri: string; wasmBinaryUri?: string }
@@ -10,6 +10,10 @@ export type MainToWorkerMessage =
     | { type: 'GET_SIGNALS'; requestId: number }
     | { type: 'GET_HIERARCHY'; requestId: number }
     | { type: 'FIND_SIGNAL'; requestId: number; fullPath: string }
+    | {
+        type: 'GET_SCOPE'; requestId: number; scope: number;
+        childOffset?: number; childLimit?: number; signalOffset?: number; signalLimit?: number
+    }
     | { type: 'CLOSE' };
 
 export type WorkerToMainMessage =
@@ -22,4 +26,5 @@ export type WorkerToMainMessage =
     | { type: 'METADATA_RESULT'; requestId: number; data: any }
     | { type: 'SIGNALS_RESULT'; requestId: number; data: any }
     | { type: 'HIERARCHY_RESULT'; requestId: number; data: any }
-    | { type: 'FIND_SIGNAL_RESULT'; requestId: number; data: number };
+    | { type: 'FIND_SIGNAL_RESULT'; requestId: number; data: number }
+    | { type: 'SCOPE_RESULT'; requestId: number; data: ScopePage };
@@ -10,6 +10,35 @@ declare const self: DedicatedWorkerGlobalScope;
 let engine: WaveformEngine | null = null;
 let abortController: AbortController | null = null;
 
+/**
+ * WORKERFS mounts are read-only, so sidecar indexes for picked files live in
+ * an IndexedDB-backed directory instead. Resolves false where IndexedDB is
+ * unavailable, in which case files are simply re-indexed.
+ */
+const INDEX_CACHE_DIR = '/index-cache';
+let indexCacheReady: Promise<boolean> | null = null;
+
+// eslint-disable-next-line @typescript-eslint/no-explicit-any
+function mountIndexCache(FS: any): Promise<boolean> {
+    if (!indexCacheReady) {
+        indexCacheReady = new Promise(resolve => {
+            try {
+                FS.mkdir(INDEX_CACHE_DIR);
+                FS.mount(FS.filesystems.IDBFS, {}, INDEX_CACHE_DIR);
+                FS.syncfs(true, (err: unknown) => resolve(!err));
+            } catch (e) {
+                resolve(false);
+            }
+        });
+    }
+    return indexCacheReady;
+}
+
+// eslint-disable-next-line @typescript-eslint/no-explicit-any
+function flushIndexCache(FS: any): Promise<void> {
+    return new Promise(resolve => FS.syncfs(false, () => resolve()));
+}
+
 self.onmessage = async (e: MessageEvent<MainToWorkerMessage>) => {
     const msg = e.data;
 
@@ -73,10 +102,14 @@ self.onmessage = async (e: MessageEvent<MainToWorkerMessage>) => {
                 }
 
                 let filePath = '';
+                let indexPath: string | undefined;
                 if (msg.file) {
                     filePath = '/work/' + msg.file.name;
                     try { FS.unmount('/work'); } catch (e) { }
                     FS.mount(FS.filesystems.WORKERFS, { files: [msg.file] }, '/work');
+                    if (await mountIndexCache(FS)) {
+                        indexPath = `${INDEX_CACHE_DIR}/${msg.file.name}.${msg.fileSize}.wvidx`;
+                    }
                 } else if (msg.localPath) {
                     filePath = msg.localPath;
                 }
@@ -87,7 +120,8 @@ self.onmessage = async (e: MessageEvent<MainToWorkerMessage>) => {
                         bytesRead,
                         totalBytes
                     } as WorkerToMainMessage);
-                });
+                }, indexPath);
+                if (success && indexPath) await flushIndexCache(FS);
 
                 self.postMessage({
                     type: 'INDEX_DONE',
@@ -184,6 +218,18 @@ self.onmessage = async (e: MessageEvent<MainToWorkerMessage>) => {
                 break;
             }
 
+            case 'GET_SCOPE': {
+                if (!engine) return;
+                self.postMessage({
+                    type: 'SCOPE_RESULT',
+                    requestId: msg.requestId,
+                    data: engine.getScope(
+                        msg.scope, msg.childOffset, msg.childLimit, msg.signalOffset, msg.signalLimit
+                    )
+                } as WorkerToMainMessage);
+                break;
+            }
+
             case 'CLOSE': {
                 if (engine) engine.close();
                 break;
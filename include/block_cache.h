@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace vcd
+{
+
+    /**
+     * @brief LRU cache of decoded value changes, per time tile and handle.
+     *
+     * An FST query decodes value-change blocks that the next pan or zoom
+     * usually needs again. The parser splits the dump into fixed time tiles
+     * of about one block each and stores every (tile, handle) pair it
+     * decoded, so a later query can replay those changes without going
+     * back to libfst. The least recently used pairs are dropped once the
+     * cache exceeds its byte budget.
+     */
+    class BlockCache
+    {
+       public:
+        /// Value changes of one handle inside one tile, in time order.
+        struct Entry
+        {
+            std::vector<uint64_t> times;
+            std::vector<uint32_t> value_ends;  // into values
+            std::string values;
+
+            size_t size() const { return times.size(); }
+            std::string_view value(size_t i) const
+            {
+                uint32_t b = i ? value_ends[i - 1] : 0;
+                return std::string_view(values).substr(b, value_ends[i] - b);
+            }
+            void add(uint64_t time, std::string_view value)
+            {
+                times.push_back(time);
+                values.append(value);
+                value_ends.push_back(static_cast<uint32_t>(values.size()));
+            }
+        };
+
+        struct Stats
+        {
+            uint64_t hits = 0;
+            uint64_t misses = 0;
+            size_t entries = 0;
+            size_t memory_usage = 0;
+        };
+
+        /// Bytes the cache may hold; 0 disables it.
+        void set_budget(size_t bytes);
+        size_t budget() const { return budget_; }
+
+        void clear();
+
+        /**
+         * @brief The cached changes of `handle` in `tile`, or nullptr.
+         * Counts a hit or a miss and marks the entry as recently used.
+         */
+        const Entry* find(uint32_t tile, uint32_t handle);
+
+        /// Count lookups that were known to miss without calling find().
+        void note_misses(uint64_t n) { stats_.misses += n; }
+
+        /// Whether (tile, handle) is cached, without touching stats or order.
+        bool contains(uint32_t tile, uint32_t handle) const
+        {
+            return map_.count(key(tile, handle)) != 0;
+        }
+
+        /**
+         * @brief Store the changes of `handle` in `tile`, replacing any
+         * previous entry, then evict down to the budget.
+         */
+        void insert(uint32_t tile, uint32_t handle, Entry&& entry);
+
+        const Stats& stats() const { return stats_; }
+
+       private:
+        static uint64_t key(uint32_t tile, uint32_t handle)
+        {
+            return (static_cast<uint64_t>(tile) << 32) | handle;
+        }
+
+        struct Node
+        {
+            Entry entry;
+            size_t bytes = 0;
+            std::list<uint64_t>::iterator position;
+        };
+
+        void erase(std::unordered_map<uint64_t, Node>::iterator it);
+        static size_t bytes_of(const Entry& e);
+
+        size_t budget_ = 32 * 1024 * 1024;
+        std::unordered_map<uint64_t, Node> map_;
+        std::list<uint64_t> order_;  // most recently used first
+        Stats stats_;
+    };
+
+}  // namespace vcd
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "waveform_parser.h"
+
+namespace vcd
+{
+
+    /**
+     * @brief Re-encodes a QueryResultBinary as one contiguous run per signal.
+     *
+     * The flat result interleaves every signal in 16/24-byte records; the
+     * viewer only ever draws one signal at a time, so the encoder groups the
+     * records by signal (keeping their order) and packs each group tightly.
+     * All integers are little-endian.
+     *
+     *   u32 signal_count, u32 flags
+     *   signal_count x { u32 signal_index, u32 count, u32 run_flags,
+     *                    u32 times_offset, u32 values_offset }
+     *   times and values of each run, at the offsets given in its entry
+     *   (from the start of the buffer)
+     *
+     * Times are either raw u64s (8-byte aligned, so they can be viewed as a
+     * BigUint64Array) or, with COMPRESSED, LEB128 varints of the difference
+     * to the previous time of the same run (the first one from 0). 1-bit
+     * values are packed LSB first: 2 bits each, or 4 bits if the run holds a
+     * glitch (value 4). Multi-bit values are a varint length followed by the
+     * value's bytes.
+     */
+    class ColumnarEncoder
+    {
+       public:
+        /// Header flags
+        static constexpr uint32_t COMPRESSED = 1u << 0;
+
+        /// Run flags
+        static constexpr uint32_t MULTIBIT = 1u << 0;
+        static constexpr uint32_t WIDE_VALUES = 1u << 1;  // 4-bit 1-bit values
+
+        static constexpr size_t HEADER_SIZE = 8;
+        static constexpr size_t ENTRY_SIZE = 20;
+
+        /**
+         * @brief Encode `res` with one run per entry of `signals`, in that
+         * order. Records of signals not listed are dropped. The returned
+         * buffer stays valid until the next encode().
+         */
+        const std::vector<uint8_t>& encode(
+            const QueryResultBinary& res, const std::vector<uint32_t>& signals,
+            bool compressed);
+
+        const std::vector<uint8_t>& buffer() const { return out_; }
+
+       private:
+        void put_u32(size_t at, uint32_t v);
+        void append_u64(uint64_t v);
+        void append_varint(uint64_t v);
+        void align(size_t to);
+
+        std::vector<uint8_t> out_;
+
+        // Records of run r are order[begin[r]] .. order[begin[r + 1] - 1]
+        struct Grouping
+        {
+            std::vector<uint32_t> begin;
+            std::vector<uint32_t> order;
+            std::vector<uint32_t> cursor;
+        };
+
+        template <typename Record>
+        void group(const Record* records, size_t count, Grouping& g);
+
+        std::vector<uint32_t> run_of_signal_;
+        Grouping group_1bit_;
+        Grouping group_multi_;
+    };
+
+}  // namespace vcd
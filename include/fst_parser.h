@@ -4,6 +4,8 @@
 #include <string>
 #include <vector>
 
+#include "block_cache.h"
+#include "query_cache.h"
 #include "waveform_parser.h"
 
 // Forward declaration of fstReaderContext
@@ -41,12 +43,19 @@ namespace vcd
             const std::string& full_path) const override;
 
         // --- Indexing Phase ---
+        // FST files are read block-wise; there are no snapshots to place.
+        void set_snapshot_policy(const SnapshotPolicy& /*policy*/) override {}
         bool open_file(const std::string& filepath) override;
         void close_file() override;
         void begin_indexing() override;
         size_t index_step(size_t chunk_size) override;
         void finish_indexing() override;
 
+        // --- Index Persistence ---
+        // FST already carries its own block index; nothing to persist.
+        bool save_index(const std::string& index_path) const override;
+        bool load_index(const std::string& index_path) override;
+
         // --- Query Phase ---
         QueryPlan get_query_plan(uint64_t start_time) const override;
 
@@ -57,12 +66,51 @@ namespace vcd
 
         bool query_step(size_t chunk_size) override;
         QueryResultBinary flush_query_binary() override;
+        QueryResultBinary take_query_segment(bool final) override;
         void cancel_query() override;
 
+        // --- Value Search ---
+        // Decodes only the signal's handle, over time windows that start
+        // about one block wide on the side of `from_time` and double.
+        SearchResult find_next(uint32_t signal_index,
+                               const SearchPredicate& predicate,
+                               uint64_t from_time,
+                               SearchDirection direction) override;
+
+        // --- Query Threads ---
+        // Handles a query has to decode are split across this many
+        // threads, each with its own reader on the file. 1 (the default)
+        // decodes on the calling thread, 0 uses every hardware thread.
+        // Ignored on builds without thread support.
+        void set_query_threads(unsigned threads);
+
+        // --- Decoded block cache ---
+        // Value changes decoded by queries are kept for later ones, up to
+        // `bytes` (0 disables the cache). Defaults to 32 MB.
+        void set_block_cache_budget(size_t bytes);
+        const BlockCache::Stats& block_cache_stats() const;
+
+        // --- Query result cache ---
+        // Finished query results per signal and pixel_time_step, up to
+        // `bytes` (0 disables the cache). Defaults to 16 MB.
+        void set_query_cache_budget(size_t bytes);
+        const QueryCache::Stats& query_cache_stats() const;
+
         // --- Statistics ---
         size_t snapshot_count() const override;
+        // Block cache plus the per-signal state kept between queries; the
+        // query cache is reported by query_cache_stats()
         size_t index_memory_usage() const override;
 
+        // --- Instrumentation ---
+        // bytes_scanned and blocks_decoded are estimated: libfst decodes
+        // whole blocks without reporting them, so every tile a step decodes
+        // (about one block, see query_step) counts as one, and so does
+        // every initial value looked up through libfst.
+        void set_stats_enabled(bool enabled, bool trace = false) override;
+        ParserStats stats() const override;
+        std::string trace_json() const override;
+
        private:
         struct Impl;
         std::unique_ptr<Impl> impl_;
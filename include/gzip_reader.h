@@ -0,0 +1,153 @@
+#pragma once
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+namespace vcd
+{
+
+    /**
+     * @brief Seekable reads from a gzip-compressed file.
+     *
+     * Deflate can only resume where its state is known: at a block
+     * boundary, given the bit position there and the 32 KB of output
+     * before it. While the file is decompressed front to back (during
+     * indexing), such a checkpoint is taken at the first block boundary
+     * after every `span` bytes of output. seek() then restarts at the
+     * closest checkpoint at or before the target and inflates forward
+     * from there, so a query replays at most about one span it doesn't
+     * need instead of everything in front of its snapshot. Checkpoints
+     * are saved with the index sidecar.
+     *
+     * Concatenated members (as written by pigz or `cat a.gz b.gz`) are
+     * read as one stream. Anything after the last member is ignored.
+     */
+    class GzipReader
+    {
+       public:
+        GzipReader() = default;
+        ~GzipReader();
+
+        GzipReader(const GzipReader&) = delete;
+        GzipReader& operator=(const GzipReader&) = delete;
+
+        /// Whether `f` starts with the gzip magic; rewinds `f`.
+        static bool is_gzip(std::FILE* f);
+
+        /// Read `f` (owned by the caller) of `file_size` bytes on disk.
+        bool open(std::FILE* f, uint64_t file_size);
+        void close();
+        bool is_open() const { return file_ != nullptr; }
+
+        /// Spacing of the checkpoints taken from now on (default 4 MB).
+        void set_checkpoint_span(uint64_t bytes) { span_ = bytes; }
+
+        /// Decompress up to `n` bytes from position(); 0 at the end or on
+        /// a corrupt stream.
+        size_t read(uint8_t* buf, size_t n);
+
+        /// Move to decompressed offset `offset`. False past the end.
+        bool seek(uint64_t offset);
+
+        uint64_t position() const { return out_pos_; }
+        /// Compressed bytes consumed so far.
+        uint64_t input_position() const { return in_pos_ - strm_.avail_in; }
+
+        /// Decompressed size once the end has been read (or restored).
+        bool size_known() const { return size_ != UINT64_MAX; }
+        uint64_t size() const { return size_; }
+
+        size_t checkpoint_count() const { return checkpoints_.size(); }
+        size_t memory_usage() const;
+
+        /// Serialize the checkpoints through a writer with pod() and
+        /// pod_vec(). Only complete once the end has been read.
+        template <typename Writer>
+        void save(Writer& w) const;
+
+        /// Counterpart of save(), for the file given to open().
+        template <typename Reader>
+        bool restore(Reader& r);
+
+       private:
+        static constexpr size_t WINDOW_SIZE = 32 * 1024;
+        static constexpr size_t INPUT_SIZE = 64 * 1024;
+
+        struct Checkpoint
+        {
+            uint64_t out = 0;   // decompressed offset
+            uint64_t in = 0;    // first compressed byte not fully consumed
+            uint32_t bits = 0;  // bits of in[-1] still to be used, 0..7
+            std::vector<uint8_t> window;  // output before `out`
+        };
+
+        bool restart(const Checkpoint* at);  // nullptr: the file's start
+        bool fill_input();
+        bool next_member();
+        void remember(const uint8_t* data, size_t n);
+        void add_checkpoint();
+
+        std::FILE* file_ = nullptr;
+        uint64_t file_size_ = 0;
+        z_stream strm_{};
+        bool strm_ready_ = false;
+        bool raw_ = false;  // inside a member, restarted at a checkpoint
+        bool at_end_ = false;
+
+        std::vector<uint8_t> input_;
+        uint64_t in_pos_ = 0;  // file offset of input_'s end
+        uint64_t out_pos_ = 0;
+        uint64_t size_ = UINT64_MAX;
+
+        std::vector<uint8_t> window_;  // ring of the last WINDOW_SIZE bytes
+        std::vector<uint8_t> skip_;    // output discarded by seek()
+        uint64_t span_ = 4 * 1024 * 1024;
+        std::vector<Checkpoint> checkpoints_;  // by out
+    };
+
+    template <typename Writer>
+    void GzipReader::save(Writer& w) const
+    {
+        w.pod(size_);
+        w.pod(static_cast<uint64_t>(checkpoints_.size()));
+        for (const Checkpoint& c : checkpoints_)
+        {
+            w.pod(c.out);
+            w.pod(c.in);
+            w.pod(c.bits);
+            w.pod_vec(c.window);
+        }
+    }
+
+    template <typename Reader>
+    bool GzipReader::restore(Reader& r)
+    {
+        uint64_t size = r.template pod<uint64_t>();
+        uint64_t n = r.template pod<uint64_t>();
+        std::vector<Checkpoint> loaded;
+        for (uint64_t i = 0; i < n && r.ok(); ++i)
+        {
+            Checkpoint c;
+            c.out = r.template pod<uint64_t>();
+            c.in = r.template pod<uint64_t>();
+            c.bits = r.template pod<uint32_t>();
+            if (!r.pod_vec(c.window)) return false;
+            uint64_t prev = loaded.empty() ? 0 : loaded.back().out;
+            if (c.out <= prev || c.out > size || c.in == 0 ||
+                c.in > file_size_ || c.bits > 7 ||
+                c.window.size() != std::min<uint64_t>(c.out, WINDOW_SIZE))
+                return false;
+            loaded.push_back(std::move(c));
+        }
+        if (!r.ok() || size == UINT64_MAX) return false;
+        checkpoints_ = std::move(loaded);
+        size_ = size;
+        return true;
+    }
+
+}  // namespace vcd
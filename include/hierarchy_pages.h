@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "waveform_parser.h"
+
+namespace vcd
+{
+
+    /**
+     * @brief The scope tree as a flat table that can be browsed page by page.
+     *
+     * Serializing the whole hierarchy at once does not scale to designs
+     * with millions of signals, and most of it is never expanded. build()
+     * numbers the scopes breadth-first (the root is scope 0, siblings are
+     * consecutive) and interns every scope and signal name once, so the
+     * "clk" of a thousand instances is sent once. The viewer then asks for
+     * one scope at a time, a page of its children and signals at a time,
+     * and for the names it has not seen yet. All integers are
+     * little-endian u32 unless noted.
+     *
+     * scope_page():
+     *   scope, parent (UINT32_MAX for the root), name, child_count,
+     *   signal_count, total_signal_count (this scope and below),
+     *   child_offset, children_in_page, signal_offset, signals_in_page
+     *   children_in_page x { scope, name, child_count, signal_count,
+     *                        total_signal_count }
+     *   signals_in_page x { signal_index, name, width, type (VarType),
+     *                       i32 msb, i32 lsb }
+     *
+     * name_page():
+     *   count, (count + 1) byte offsets into the UTF-8 text that follows
+     *   (from its start), the text
+     */
+    class HierarchyPages
+    {
+       public:
+        static constexpr uint32_t NONE = UINT32_MAX;
+
+        static constexpr size_t SCOPE_HEADER_SIZE = 40;
+        static constexpr size_t CHILD_ENTRY_SIZE = 20;
+        static constexpr size_t SIGNAL_ENTRY_SIZE = 24;
+
+        /// Index the tree under `root` (nullptr leaves the table empty)
+        void build(const ScopeNode* root,
+                   const std::vector<SignalDef>& signals);
+        void clear();
+
+        bool empty() const { return scopes_.empty(); }
+        size_t scope_count() const { return scopes_.size(); }
+        size_t name_count() const { return name_ends_.size(); }
+
+        /**
+         * @brief Encode `scope` with children [child_offset, child_offset +
+         * child_limit) and signals [signal_offset, signal_offset +
+         * signal_limit), clamped to what it has. An unknown scope gives an
+         * empty buffer. The buffer stays valid until the next page.
+         */
+        const std::vector<uint8_t>& scope_page(uint32_t scope,
+                                               uint32_t child_offset,
+                                               uint32_t child_limit,
+                                               uint32_t signal_offset,
+                                               uint32_t signal_limit);
+
+        /// Encode names [first, first + count), clamped to name_count()
+        const std::vector<uint8_t>& name_page(uint32_t first, uint32_t count);
+
+       private:
+        struct Scope
+        {
+            uint32_t parent = NONE;
+            uint32_t name = 0;
+            uint32_t first_child = 0;  // children are consecutive scopes
+            uint32_t child_count = 0;
+            uint32_t total_signals = 0;
+            const ScopeNode* node = nullptr;
+        };
+
+        void put_u32(uint32_t v);
+
+        std::vector<Scope> scopes_;
+        std::vector<uint32_t> signal_names_;  // by signal index
+        const std::vector<SignalDef>* signals_ = nullptr;
+
+        std::string names_;
+        std::vector<uint32_t> name_ends_;  // into names_
+
+        std::vector<uint8_t> out_;
+    };
+
+}  // namespace vcd
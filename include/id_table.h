@@ -0,0 +1,151 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "waveform_parser.h"
+
+namespace vcd
+{
+
+    /**
+     * @brief Maps VCD id codes to the signals declared with them.
+     *
+     * Built once the definitions are complete. Id codes are normally short
+     * base-94 strings of printable characters handed out densely, so when
+     * every id is at most two such characters (or three, with enough ids
+     * to fill that code space), an id indexes the table directly.
+     * Otherwise a minimal perfect hash (hash and displace) picks the slot
+     * and the stored id is compared in full, so long ids never collide.
+     * Aliases (several $var lines sharing an id) are stored flat.
+     */
+    class IdTable
+    {
+       public:
+        /// Signal indices sharing one id code.
+        struct Aliases
+        {
+            const uint32_t* first = nullptr;
+            const uint32_t* last = nullptr;
+
+            const uint32_t* begin() const { return first; }
+            const uint32_t* end() const { return last; }
+            bool empty() const { return first == last; }
+        };
+
+        void build(const std::vector<SignalDef>& signals);
+        void clear();
+
+        Aliases find(std::string_view id) const
+        {
+            size_t slot = direct_ ? direct_code(id) : hashed_slot(id);
+            if (slot >= entries_.size()) return {};
+            const Entry& e = entries_[slot];
+            return {aliases_.data() + e.first,
+                    aliases_.data() + e.first + e.count};
+        }
+
+        size_t memory_usage() const;
+
+       private:
+        struct Entry
+        {
+            uint32_t first = 0;  // into aliases_
+            uint32_t count = 0;
+        };
+
+        static constexpr unsigned FIRST_CHAR = '!';
+        static constexpr unsigned RADIX = '~' - '!' + 1;  // 94
+        static constexpr size_t MAX_DIRECT_LENGTH = 3;
+
+        // Dense code of a printable id: ids of length L follow all shorter
+        // ones, so "!" = 0, "~" = 93, "!!" = 94, ...
+        static size_t direct_code(std::string_view id)
+        {
+            if (id.empty() || id.size() > MAX_DIRECT_LENGTH)
+                return SIZE_MAX;
+            size_t code = 0, base = 0, span = 1;
+            for (char ch : id)
+            {
+                unsigned d = static_cast<unsigned char>(ch) - FIRST_CHAR;
+                if (d >= RADIX) return SIZE_MAX;
+                code = code * RADIX + d;
+                base += span;
+                span *= RADIX;
+            }
+            return base - 1 + code;
+        }
+
+        // Buckets whose seed has this bit set hold a single id, placed
+        // directly in slot (seed & ~SINGLE_SLOT).
+        static constexpr uint32_t SINGLE_SLOT = 0x80000000u;
+
+        // Map a 32-bit hash onto [0, n) without a division
+        static size_t reduce(uint64_t h, size_t n)
+        {
+            return static_cast<size_t>(((h & 0xffffffffu) * n) >> 32);
+        }
+
+        // MurmurHash3 finalizer: FNV alone leaves the high bits of short
+        // ids nearly constant, which would pile them into a few buckets.
+        static uint64_t avalanche(uint64_t h)
+        {
+            h ^= h >> 33;
+            h *= 0xff51afd7ed558ccdULL;
+            h ^= h >> 33;
+            h *= 0xc4ceb9fe1a85ec53ULL;
+            h ^= h >> 33;
+            return h;
+        }
+
+        static uint64_t hash(std::string_view id)
+        {
+            uint64_t h = 0xcbf29ce484222325ULL;  // FNV-1a
+            for (unsigned char c : id)
+            {
+                h ^= c;
+                h *= 0x100000001b3ULL;
+            }
+            return avalanche(h);
+        }
+
+        static uint64_t mix(uint64_t h, uint32_t seed)
+        {
+            return avalanche(h ^ ((seed + 1) * 0x9e3779b97f4a7c15ULL));
+        }
+
+        // Slot of `id` in hashed mode, or SIZE_MAX if it isn't declared
+        size_t hashed_slot(std::string_view id) const
+        {
+            if (seeds_.empty()) return SIZE_MAX;
+            uint64_t h = hash(id);
+            uint32_t seed = seeds_[reduce(h >> 32, seeds_.size())];
+            size_t slot = (seed & SINGLE_SLOT)
+                              ? seed & ~SINGLE_SLOT
+                              : reduce(mix(h, seed), entries_.size());
+            uint32_t b = key_offsets_[slot], e = key_offsets_[slot + 1];
+            if (std::string_view(keys_).substr(b, e - b) != id)
+                return SIZE_MAX;
+            return slot;
+        }
+
+        // Place `ids` with a minimal perfect hash; returns each id's slot.
+        std::vector<size_t> build_hashed(
+            const std::vector<std::string_view>& ids);
+
+        bool direct_ = true;
+        std::vector<Entry> entries_;
+        std::vector<uint32_t> aliases_;
+
+        // Hashed mode: one displacement seed per bucket, plus the ids
+        // themselves for verification (slot s holds keys_ from
+        // key_offsets_[s] to key_offsets_[s + 1]).
+        std::vector<uint32_t> seeds_;
+        std::vector<uint32_t> key_offsets_;
+        std::string keys_;
+    };
+
+}  // namespace vcd
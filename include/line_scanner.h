@@ -0,0 +1,77 @@
+#pragma once
+
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace vcd
+{
+
+    /**
+     * @brief Bulk byte classification for tokenizing VCD text.
+     *
+     * scan() sweeps a buffer once with SIMD compares (AVX2 or SSE2 on x86,
+     * SIMD128 on WASM, a scalar loop elsewhere) and keeps two bitmaps, one
+     * bit per byte: newlines, and blanks (any byte <= ' ', which includes
+     * '\n', '\r' and '\t'). Line and token boundaries are then found by
+     * counting trailing zeros instead of re-scanning bytes with find().
+     */
+    class LineScanner
+    {
+       public:
+        /**
+         * @brief Classify `buf`; positions below are offsets into it. The
+         * buffer must stay alive while those offsets are used.
+         */
+        void scan(std::string_view buf);
+
+        /// First newline at or after `from`, or the buffer size if none.
+        size_t next_newline(size_t from) const
+        {
+            return next_set(newline_, from);
+        }
+
+        /// First blank at or after `from`, or the buffer size if none.
+        size_t next_blank(size_t from) const { return next_set(blank_, from); }
+
+        /// Offset of `p`, which must point into the scanned buffer.
+        size_t offset_of(const char* p) const
+        {
+            return static_cast<size_t>(p - data_);
+        }
+
+       private:
+        size_t next_set(const std::vector<uint64_t>& mask, size_t from) const
+        {
+            size_t w = from / 64;
+            if (w >= mask.size()) return size_;
+            uint64_t bits = mask[w] & (~uint64_t(0) << (from % 64));
+            while (bits == 0)
+            {
+                if (++w == mask.size()) return size_;
+                bits = mask[w];
+            }
+            size_t pos = w * 64 + static_cast<size_t>(__builtin_ctzll(bits));
+            return pos < size_ ? pos : size_;
+        }
+
+        const char* data_ = nullptr;
+        size_t size_ = 0;
+        std::vector<uint64_t> newline_;
+        std::vector<uint64_t> blank_;
+    };
+
+    /**
+     * @brief Parse the leading unsigned decimal of `s` without allocating,
+     * ignoring whatever follows it (like std::stoull). Returns false if `s`
+     * doesn't start with a digit or the value overflows.
+     */
+    inline bool parse_u64(std::string_view s, uint64_t& out)
+    {
+        auto res = std::from_chars(s.data(), s.data() + s.size(), out);
+        return res.ec == std::errc();
+    }
+
+}  // namespace vcd
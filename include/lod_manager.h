@@ -5,6 +5,7 @@
 #include <string_view>
 #include <vector>
 
+#include "signal_slots.h"
 #include "waveform_parser.h"
 
 namespace vcd
@@ -13,14 +14,30 @@ namespace vcd
     /**
      * @brief Manages Level of Detail (LOD) and Glitch detection for waveform
      * parsers.
+     *
+     * Per-signal state is indexed by the query's SignalSlots, as are the
+     * last_index vectors passed in; records carry the global signal index.
      */
     class LodManager
     {
        public:
+        /// One signal's glitch and collapse state, with its multi-bit
+        /// values copied out of the query string pool
+        struct SignalState
+        {
+            uint64_t last_emitted_time = 0;
+            uint64_t last_transition_time = 0;
+            bool glitch = false;
+            uint8_t value_1bit = 0;
+            std::string value_multi;       // last emitted
+            std::string glitch_end_multi;  // latest, during a glitch
+        };
+
         /**
-         * @brief Initialize or reset the LOD manager.
+         * @brief Initialize or reset the LOD manager for the signals of
+         * `slots`, which must outlive the query.
          */
-        void reset(size_t signal_count, float pixel_time_step);
+        void reset(const SignalSlots& slots, float pixel_time_step);
 
         /**
          * @brief Process a 1-bit value change.
@@ -34,7 +51,7 @@ namespace vcd
          */
         void process_multibit(uint64_t current_time, uint32_t sig_idx,
                               std::string_view val_tok,
-                              const std::string& old_v,
+                              std::string_view old_v,
                               std::vector<TransitionMultiBit>& res_multibit,
                               std::vector<int64_t>& last_index_multi,
                               std::string& query_string_pool);
@@ -55,6 +72,44 @@ namespace vcd
             std::vector<int64_t>& last_index_multi,
             std::string& query_string_pool);
 
+        /**
+         * @brief Continue a signal whose earlier records were not produced
+         * here (e.g. spliced in from the query cache): its latest record,
+         * at `last_time`, is where glitch detection picks up.
+         */
+        void resume_1bit(uint64_t last_time, uint32_t sig_idx, uint8_t v);
+
+        /**
+         * @brief Multi-bit resume_1bit(); the latest record's value is at
+         * [offset, offset + length) of the query string pool.
+         */
+        void resume_multibit(uint64_t last_time, uint32_t sig_idx,
+                             uint32_t offset, uint32_t length);
+
+        /**
+         * @brief The state of signal `sig_idx` (before flush_glitches()),
+         * so a later query can continue where this one stopped.
+         */
+        SignalState save(uint32_t sig_idx,
+                         std::string_view query_string_pool) const;
+
+        /**
+         * @brief Continue signal `sig_idx` from a saved state; its
+         * multi-bit values are appended to the query string pool.
+         */
+        void restore(uint32_t sig_idx, const SignalState& state,
+                     std::string& query_string_pool);
+
+        /**
+         * @brief Whether a change at the initial value's own timestamp
+         * differed from the value before it, i.e. a query begun earlier
+         * would have a record there as well.
+         */
+        bool changed_at_start(uint32_t sig_idx) const
+        {
+            return start_changed_[(*slots_)[sig_idx]];
+        }
+
         /**
          * @brief Flush any open glitches at the end of a query.
          */
@@ -64,10 +119,16 @@ namespace vcd
                             std::vector<int64_t>& last_index_multi,
                             std::string& query_string_pool);
 
+        /// Glitch runs started since construction; reset() keeps counting
+        uint64_t glitch_count() const { return glitch_count_; }
+
        private:
+        const SignalSlots* slots_ = nullptr;
         float pixel_time_step_ = -1.0f;
         std::vector<uint64_t> last_emitted_time_;
         std::vector<bool> signal_is_glitch_;
+        std::vector<bool> start_changed_;
+        uint64_t start_time_ = 0;  // of the initial values
 
         // Shadow state: the last EMITTED value (pre-glitch)
         std::vector<uint64_t> last_transition_time_;
@@ -80,6 +141,7 @@ namespace vcd
         std::vector<uint32_t> glitch_end_multi_length_;
 
         uint32_t glitch_string_offset_ = static_cast<uint32_t>(-1);
+        uint64_t glitch_count_ = 0;
     };
 
 }  // namespace vcd
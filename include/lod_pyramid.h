@@ -0,0 +1,133 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace vcd
+{
+
+    /**
+     * @brief Multi-resolution summary of one signal's value changes.
+     *
+     * Level l groups the changes into aligned buckets of 2^(base + l) time
+     * units and keeps, per non-empty bucket, the first and last change time,
+     * the number of changes and the settled value. A bucket holding more than
+     * one change is drawn as a glitch. Values are opaque ids: the 2-bit code
+     * for 1-bit signals, an interned string id for wider ones.
+     */
+    class LodPyramid
+    {
+       public:
+        struct Bucket
+        {
+            uint64_t first_time;
+            uint64_t last_time;
+            uint32_t count;  // changes at distinct timestamps
+            uint32_t value;  // value after the last change
+        };
+
+        /// The finest level spans the trace with at most this many buckets.
+        static constexpr uint64_t MAX_FINE_BUCKETS = uint64_t(1) << 15;
+
+        /**
+         * @brief Start collecting the changes of a trace spanning
+         * [t_begin, t_end]; `initial_value` holds before the first change.
+         */
+        void begin(uint64_t t_begin, uint64_t t_end, uint32_t initial_value);
+
+        /**
+         * @brief Record a change. Times must be non-decreasing.
+         */
+        void add(uint64_t time, uint32_t value);
+
+        /**
+         * @brief Derive the coarser levels from the finest one.
+         */
+        void finish();
+
+        bool ready() const { return ready_; }
+
+        /**
+         * @brief Coarsest level whose bucket width does not exceed
+         * `pixel_time_step`, or -1 if even the finest level is wider.
+         */
+        int level_for(float pixel_time_step) const;
+
+        /**
+         * @brief Replay `level` over [t_begin, t_end] as emit(time, value,
+         * glitch) calls with strictly increasing times: the value at t_begin
+         * first, then one change per quiet bucket. Like LodManager, a busy
+         * bucket opens a glitch that extends over following buckets less than
+         * a bucket width apart and closes with the settled value.
+         */
+        template <typename Emit>
+        void emit_range(int level, uint64_t t_begin, uint64_t t_end,
+                        Emit&& emit) const;
+
+        size_t memory_usage() const;
+
+       private:
+        uint64_t bucket_of(const Bucket& b, size_t level) const
+        {
+            return (b.first_time - origin_) >> (base_shift_ + level);
+        }
+
+        uint64_t origin_ = 0;
+        unsigned base_shift_ = 0;
+        uint32_t initial_value_ = 0;
+        bool ready_ = false;
+        std::vector<std::vector<Bucket>> levels_;
+    };
+
+    template <typename Emit>
+    void LodPyramid::emit_range(int level, uint64_t t_begin, uint64_t t_end,
+                                Emit&& emit) const
+    {
+        const std::vector<Bucket>& b = levels_[level];
+        const uint64_t width = uint64_t(1) << (base_shift_ + level);
+
+        // First bucket with a change at or after t_begin
+        auto it = std::lower_bound(b.begin(), b.end(), t_begin,
+                                   [](const Bucket& x, uint64_t t)
+                                   { return x.last_time < t; });
+        uint32_t before = it == b.begin() ? initial_value_ : (it - 1)->value;
+
+        bool glitch = false;
+        uint64_t last_time = t_begin;
+        uint32_t settled = before;
+        if (it != b.end() && it->first_time <= t_begin)
+        {
+            // The bucket straddles t_begin: its changes up to t_begin fold
+            // into the starting value, any later ones open a glitch.
+            glitch = it->last_time > t_begin;
+            emit(t_begin, glitch ? before : it->value, glitch);
+            last_time = it->last_time;
+            settled = it->value;
+            ++it;
+        }
+        else
+        {
+            emit(t_begin, before, false);
+        }
+
+        for (; it != b.end() && it->first_time <= t_end; ++it)
+        {
+            if (glitch && it->first_time - last_time < width)
+            {
+                last_time = it->last_time;
+                settled = it->value;
+                continue;
+            }
+            if (glitch) emit(last_time, settled, false);
+
+            glitch = it->count > 1;
+            emit(it->first_time, it->value, glitch);
+            last_time = it->last_time;
+            settled = it->value;
+        }
+        if (glitch) emit(last_time, settled, false);
+    }
+
+}  // namespace vcd
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace vcd
+{
+
+    /**
+     * @brief Read-only memory mapping of a whole file.
+     *
+     * Only available on native POSIX builds. Elsewhere (WASM, Windows)
+     * map() returns false and callers keep using stdio reads.
+     */
+    class MappedFile
+    {
+       public:
+        MappedFile() = default;
+        ~MappedFile();
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        MappedFile(MappedFile&& other) noexcept;
+        MappedFile& operator=(MappedFile&& other) noexcept;
+
+        /**
+         * @brief Map `path` read-only. Empty files cannot be mapped.
+         */
+        bool map(const std::string& path);
+
+        /**
+         * @brief Release the mapping (no-op if nothing is mapped).
+         */
+        void unmap();
+
+        bool is_mapped() const { return data_ != nullptr; }
+        const char* data() const { return data_; }
+        uint64_t size() const { return size_; }
+
+        /**
+         * @brief View of [offset, offset + length), clamped to the file.
+         */
+        std::string_view view(uint64_t offset, uint64_t length) const;
+
+        /**
+         * @brief Access-pattern hints (madvise); failures are ignored.
+         */
+        void advise_sequential() const;
+        void advise_random() const;
+        void will_need(uint64_t offset, uint64_t length) const;
+
+       private:
+        const char* data_ = nullptr;
+        uint64_t size_ = 0;
+    };
+
+}  // namespace vcd
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <vector>
+
+namespace vcd
+{
+
+    /**
+     * @brief Current value of every multi-bit slot, packed into one arena.
+     *
+     * Each slot owns a fixed region sized from its declared width, so a
+     * value change is an in-place memcpy rather than a std::string
+     * assignment. A value longer than its region (e.g. a real printed with
+     * many digits) moves the slot to a larger region at the end of the
+     * arena. Views returned by get() stay valid until the next set(), and
+     * set() must not be passed a view into the same arena.
+     */
+    class MultibitState
+    {
+       public:
+        /**
+         * @brief Lay out one region of `capacities[s]` bytes per slot and
+         * set every slot to `initial`.
+         */
+        void assign(const std::vector<uint32_t>& capacities,
+                    std::string_view initial);
+
+        void clear();
+
+        size_t size() const { return length_.size(); }
+
+        std::string_view get(size_t slot) const
+        {
+            return {arena_.data() + offset_[slot], length_[slot]};
+        }
+
+        void set(size_t slot, std::string_view value)
+        {
+            if (value.size() > capacity_[slot]) grow(slot, value.size());
+            if (!value.empty())
+                std::memcpy(arena_.data() + offset_[slot], value.data(),
+                            value.size());
+            length_[slot] = static_cast<uint32_t>(value.size());
+        }
+
+        size_t memory_usage() const
+        {
+            return arena_.capacity() + offset_.capacity() * sizeof(uint64_t) +
+                   (capacity_.capacity() + length_.capacity()) *
+                       sizeof(uint32_t);
+        }
+
+       private:
+        void grow(size_t slot, size_t needed);
+
+        std::vector<char> arena_;
+        std::vector<uint64_t> offset_;
+        std::vector<uint32_t> capacity_;
+        std::vector<uint32_t> length_;
+    };
+
+}  // namespace vcd
@@ -0,0 +1,221 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "lod_manager.h"
+#include "waveform_parser.h"
+
+namespace vcd
+{
+
+    /**
+     * @brief LRU cache of finished query results, per signal and resolution.
+     *
+     * Panning back and forth asks again for ranges the viewer just showed.
+     * Once a query completes, each signal's records (already reduced for
+     * its pixel_time_step) are kept as a covered time interval, merged with
+     * the cached intervals of the same signal and resolution that overlap
+     * or touch it. A later query at that resolution is then answered per
+     * signal:
+     *   - inside one interval: the records are copied out, no replay;
+     *   - overlapping an end of one: the cached part is spliced around a
+     *     replay of the uncovered gap, which all replayed signals share.
+     * With a pixel_time_step > 0, glitch detection makes records depend on
+     * where the query started and on the changes just past its end. Such
+     * an interval is therefore only served whole, to a query starting at
+     * its begin, and continued from the LodManager state saved at its end;
+     * a new one replaces those it overlaps instead of merging with them.
+     * The least recently used intervals are dropped once the cache exceeds
+     * its byte budget.
+     */
+    class QueryCache
+    {
+       public:
+        struct Stats
+        {
+            uint64_t hits = 0;          // signals served without replay
+            uint64_t partial_hits = 0;  // signals spliced around a gap
+            uint64_t misses = 0;        // signals replayed in full
+            size_t entries = 0;
+            size_t memory_usage = 0;
+        };
+
+        /// The running query's result vectors (as passed to LodManager),
+        /// last_index_* by slot of `slots`
+        struct Output
+        {
+            std::vector<Transition1Bit>& res_1bit;
+            std::vector<int64_t>& last_index_1bit;
+            std::vector<TransitionMultiBit>& res_multibit;
+            std::vector<int64_t>& last_index_multi;
+            std::string& string_pool;
+            const SignalSlots& slots;
+        };
+
+        /// Bytes the cache may hold; 0 disables it.
+        void set_budget(size_t bytes);
+        size_t budget() const { return budget_; }
+
+        void clear();
+        const Stats& stats() const { return stats_; }
+
+        /**
+         * @brief The trace grew past `time`: forget what is cached from
+         * there on. A signal's latest record is dropped as well, since
+         * new changes may still merge into it (see ResultSegments).
+         */
+        void truncate(uint64_t time);
+
+        /**
+         * @brief Start a query of `signals` over [begin, end]. Appends the
+         * records of fully cached signals and the cached prefixes of the
+         * others to `out`, and returns in `replay` the signals left to
+         * replay over [replay_begin, replay_end] (empty if none). `lod`
+         * must be reset for the query.
+         */
+        void begin(uint64_t begin, uint64_t end, float pixel_time_step,
+                   const std::vector<uint32_t>& signals,
+                   std::vector<uint32_t>& replay, uint64_t& replay_begin,
+                   uint64_t& replay_end, LodManager& lod, Output out);
+
+        /**
+         * @brief Instead of emitting the initial value of a replayed
+         * signal, continue its cached prefix. `v` is set to the value the
+         * prefix ends with, which the replay's changes apply to (for
+         * multi-bit signals, valid until `out` grows). False (emit as
+         * usual) if it has none.
+         */
+        bool resume_1bit(uint32_t sig, uint8_t& v, LodManager& lod,
+                         Output out);
+        bool resume_multibit(uint32_t sig, std::string_view& v,
+                             LodManager& lod, Output out);
+
+        /**
+         * @brief The replay is complete, but `lod` hasn't flushed its
+         * glitches yet: append the cached suffixes, then store every
+         * signal's records and state. Only the first call after begin()
+         * does anything.
+         */
+        void finish(const LodManager& lod, Output out);
+
+       private:
+        // Records of one signal in time order. The first one, at the
+        // interval's begin, holds the initial value. 1-bit values are a
+        // single byte.
+        struct Records
+        {
+            std::vector<uint64_t> times;
+            std::vector<uint32_t> value_ends;  // into values
+            std::string values;
+            bool multibit = false;
+            // The first record is also a change at its time, which an
+            // interval begun earlier would have too (see LodManager::
+            // changed_at_start)
+            bool first_changes = false;
+
+            size_t size() const { return times.size(); }
+            void clear()
+            {
+                times.clear();
+                value_ends.clear();
+                values.clear();
+                first_changes = false;
+            }
+            std::string_view value(size_t i) const
+            {
+                uint32_t b = i ? value_ends[i - 1] : 0;
+                return std::string_view(values).substr(b, value_ends[i] - b);
+            }
+            void add(uint64_t time, std::string_view value)
+            {
+                times.push_back(time);
+                values.append(value);
+                value_ends.push_back(static_cast<uint32_t>(values.size()));
+            }
+        };
+
+        struct Interval
+        {
+            uint64_t end = 0;
+            Records records;
+            // Reduced intervals: the state they continue from, before the
+            // glitches open at `end` were flushed
+            LodManager::SignalState state;
+            size_t bytes = 0;
+            std::list<std::pair<uint64_t, uint64_t>>::iterator position;
+        };
+
+        // Intervals of one (signal, resolution), disjoint and not touching,
+        // by begin time
+        using Intervals = std::map<uint64_t, Interval>;
+
+        // One replayed signal of the running query
+        struct Splice
+        {
+            uint32_t signal = 0;
+            uint32_t slot = 0;
+            int64_t prefix_last = -1;  // its last record in the output
+            bool prefix_first_changes = false;
+            LodManager::SignalState state;  // reduced prefixes continue it
+            bool multibit = false;
+            Records suffix;
+        };
+
+        static uint64_t key(uint32_t signal, float pixel_time_step);
+        // Whether records of `key` went through glitch detection
+        static bool reduced(uint64_t key);
+
+        // The interval of `key` containing `time`, or nullptr
+        Interval* find(uint64_t key, uint64_t time, uint64_t* begin);
+
+        // Records of `r` for [begin, end]: all those at `begin` (or one
+        // restating the value there, if there are none), then the ones
+        // after it
+        static void slice(const Records& r, uint64_t begin, uint64_t end,
+                          Records& into);
+        static size_t append(const Records& r, uint32_t signal, Output out);
+
+        void touch(Interval& iv);
+        void insert(uint64_t key, uint64_t begin, uint64_t end,
+                    Records&& records, LodManager::SignalState&& state = {});
+        // Adds one interval, no longer overlapping any other
+        void store(uint64_t key, uint64_t begin, uint64_t end,
+                   Records&& records, LodManager::SignalState&& state);
+        void erase(uint64_t key, Intervals::iterator it);
+        void evict();
+        static size_t bytes_of(const Records& r,
+                               const LodManager::SignalState& state);
+
+        size_t budget_ = 16 * 1024 * 1024;
+        std::unordered_map<uint64_t, Intervals> intervals_;
+        std::list<std::pair<uint64_t, uint64_t>> order_;  // (key, begin), MRU
+        Stats stats_;
+
+        // Running query
+        uint64_t query_begin_ = 0;
+        uint64_t query_end_ = 0;
+        uint64_t query_px_key_ = 0;
+        bool reduced_ = false;
+        std::vector<Splice> splices_;
+        std::vector<uint32_t> splice_of_;  // by slot, NONE if not replayed
+        bool finished_ = true;
+
+        // Scratch kept across queries, so serving from the cache doesn't
+        // allocate once these have grown
+        struct Ends
+        {
+            Interval* head = nullptr;  // contains the query's begin
+            Interval* tail = nullptr;  // contains its end
+        };
+        std::vector<Ends> ends_;
+        Records slice_;
+    };
+
+}  // namespace vcd
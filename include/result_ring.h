@@ -0,0 +1,69 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "columnar_result.h"
+#include "waveform_parser.h"
+
+namespace vcd
+{
+
+    /**
+     * @brief A small ring of columnar result arenas with explicit ownership.
+     *
+     * flush_query_binary() points into the parser's own vectors, which the
+     * next query step may reallocate, so a caller has to copy the result out
+     * at once. acquire() instead encodes the result into a free arena and
+     * hands out a handle; the arena's bytes stay put until release(), while
+     * later flushes fill the other arenas. Arenas keep their capacity, so a
+     * steady stream of similar results stops allocating after a few rounds.
+     */
+    class ResultRing
+    {
+       public:
+        static constexpr size_t SLOTS = 3;
+
+        struct Handle
+        {
+            uint32_t id = 0;  // 0 if every arena is still acquired
+            const uint8_t* data = nullptr;
+            size_t size = 0;
+        };
+
+        /**
+         * @brief Encode `res` (see ColumnarEncoder) into a free arena and
+         * mark it acquired. Fails with id 0 when all arenas are held.
+         */
+        Handle acquire(const QueryResultBinary& res,
+                       const std::vector<uint32_t>& signals, bool compressed);
+
+        /// Return an arena; false if `id` is unknown or already released.
+        bool release(uint32_t id);
+
+        /// Release every arena, e.g. when the file is closed.
+        void release_all();
+
+        /// Whether acquire() would fail, for callers whose result can't be
+        /// produced twice.
+        bool full() const;
+
+       private:
+        struct Slot
+        {
+            ColumnarEncoder encoder;
+            uint32_t generation = 0;
+            bool held = false;
+        };
+
+        // Ids carry the slot in the low bits and a generation above them,
+        // so releasing a stale id cannot free the arena's next tenant.
+        static constexpr uint32_t SLOT_BITS = 2;
+
+        std::array<Slot, SLOTS> slots_;
+        size_t next_ = 0;
+    };
+
+}  // namespace vcd
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "signal_slots.h"
+#include "waveform_parser.h"
+
+namespace vcd
+{
+
+    /**
+     * @brief Splits a growing query result into segments of final records.
+     *
+     * While a query runs, LodManager only ever rewrites the latest record of
+     * a signal (same-timestamp updates, glitch marking); every older record
+     * is final. take() returns the records appended since the previous call,
+     * holding back each signal's latest one until a newer record replaces
+     * it, so a segment never has to be revised once it has been drawn.
+     */
+    class ResultSegments
+    {
+       public:
+        /// Start over for a new query (the result vectors were cleared).
+        void reset();
+
+        /**
+         * @brief Records that became final since the last call. With
+         * `final`, everything not yet returned, held-back records included.
+         * The last_index vectors are indexed by the query's `slots`.
+         * The result points into this object and the parser's string pool,
+         * and is valid until the next call or query step.
+         */
+        QueryResultBinary take(const SignalSlots& slots,
+                               const std::vector<Transition1Bit>& res_1bit,
+                               const std::vector<int64_t>& last_index_1bit,
+                               const std::vector<TransitionMultiBit>& res_multi,
+                               const std::vector<int64_t>& last_index_multi,
+                               const std::string& string_pool, bool final);
+
+       private:
+        template <typename Record>
+        struct Stream
+        {
+            size_t published = 0;         // records examined so far
+            std::vector<uint32_t> held;   // latest records, ascending
+            std::vector<uint32_t> still;  // scratch for the next `held`
+            std::vector<Record> out;
+
+            void take(const SignalSlots& slots, const std::vector<Record>& res,
+                      const std::vector<int64_t>& last_index, bool final);
+        };
+
+        Stream<Transition1Bit> stream_1bit_;
+        Stream<TransitionMultiBit> stream_multi_;
+    };
+
+}  // namespace vcd
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+#include "waveform_parser.h"
+
+namespace vcd
+{
+
+    /**
+     * @brief Owns the scope, signal and id strings of one open file.
+     *
+     * Names are copied into large blocks that never move, so the views
+     * handed out stay valid until clear(). intern() stores each distinct
+     * name once: a design with a thousand instances of a block has its
+     * "clk" and "rst_n" once, where SignalDef used to hold a string per
+     * signal plus its full path.
+     */
+    class NamePool
+    {
+       public:
+        /// A view of `s` in the pool, shared with earlier equal names
+        std::string_view intern(std::string_view s);
+
+        /// A view of a copy of `s`, for strings rarely repeated (id codes)
+        std::string_view add(std::string_view s);
+
+        void clear();
+        size_t memory_usage() const;
+
+       private:
+        static constexpr size_t BLOCK_SIZE = 64 * 1024;
+
+        std::vector<std::unique_ptr<char[]>> blocks_;
+        size_t block_used_ = BLOCK_SIZE;  // in blocks_.back()
+        size_t bytes_ = 0;
+        std::unordered_set<std::string_view> interned_;
+    };
+
+    /**
+     * @brief Finds a signal by full path without storing full paths.
+     *
+     * A trie over path segments: each scope's children and signals sorted
+     * by name, flat in one table. find() walks down from the root one
+     * segment at a time. Names may themselves contain dots (escaped VCD
+     * identifiers), so every split point is tried. When several signals
+     * share a path the last declared one is returned.
+     */
+    class PathIndex
+    {
+       public:
+        static constexpr uint32_t NONE = UINT32_MAX;
+
+        /// Index the tree under `root` (nullptr leaves the index empty)
+        void build(const ScopeNode* root,
+                   const std::vector<SignalDef>& signals);
+        void clear();
+
+        /// Index of the signal at `full_path`, or NONE
+        uint32_t find(std::string_view full_path) const;
+
+        size_t memory_usage() const;
+
+       private:
+        static constexpr uint32_t SCOPE_BIT = 0x80000000u;
+
+        struct Entry
+        {
+            const char* name = nullptr;
+            uint32_t length = 0;
+            uint32_t target = 0;  // signal index, or scope | SCOPE_BIT
+
+            std::string_view view() const { return {name, length}; }
+        };
+
+        void search(uint32_t scope, std::string_view rest,
+                    uint32_t& best) const;
+
+        std::vector<uint32_t> first_;  // by scope, into entries_
+        std::vector<Entry> entries_;
+    };
+
+}  // namespace vcd
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace vcd
+{
+
+    /**
+     * @brief Dense local slots for the signals of one query.
+     *
+     * Query-local state (glitch tracking, each signal's latest record) is
+     * indexed by slot, so it is sized to the queried signals rather than to
+     * every signal in the file. Slots are handed out in query order; a
+     * signal listed twice keeps its first slot. The remap itself is kept
+     * across queries and only the previous query's entries are cleared, so
+     * reassigning costs O(queried signals) and allocates nothing once the
+     * buffers have grown.
+     */
+    class SignalSlots
+    {
+       public:
+        static constexpr uint32_t NONE = UINT32_MAX;
+
+        /// Map `signals` to slots; indices >= signal_count get none.
+        void assign(const std::vector<uint32_t>& signals, size_t signal_count);
+
+        void clear();
+
+        /// The slot of signal `sig`, or NONE if it isn't queried.
+        uint32_t operator[](uint32_t sig) const
+        {
+            return sig < slot_of_.size() ? slot_of_[sig] : NONE;
+        }
+
+        size_t size() const { return signals_.size(); }
+
+        /// The signal of each slot
+        const std::vector<uint32_t>& signals() const { return signals_; }
+
+        /// Whether no signal was listed twice
+        bool unique() const { return unique_; }
+
+       private:
+        std::vector<uint32_t> slot_of_;  // by signal index
+        std::vector<uint32_t> signals_;  // by slot
+        bool unique_ = true;
+    };
+
+}  // namespace vcd
@@ -0,0 +1,175 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "multibit_state.h"
+
+namespace vcd
+{
+
+    /**
+     * @brief Snapshot chain stored as keyframes plus sparse deltas.
+     *
+     * A keyframe holds the full packed 1-bit words and one interned value id
+     * per multi-bit slot. Every other snapshot stores only what differs from
+     * its keyframe: (word, xor) pairs for the 1-bit state and (slot, id)
+     * pairs for the multi-bit state. A new keyframe starts once a delta would
+     * outgrow half a keyframe, so restoring any snapshot is one keyframe copy
+     * plus at most that many patches, i.e. O(state size).
+     */
+    class SnapshotStore
+    {
+       public:
+        struct Entry
+        {
+            uint64_t time;         // Simulation time at snapshot
+            uint64_t file_offset;  // Byte offset of its '#' line
+            uint64_t word_begin;   // first 1-bit delta
+            uint64_t value_begin;  // first multi-bit delta
+            uint32_t keyframe;
+            uint32_t padding;
+        };
+
+        SnapshotStore() = default;
+        SnapshotStore(SnapshotStore&&) = default;
+        SnapshotStore& operator=(SnapshotStore&&) = default;
+        SnapshotStore(const SnapshotStore&) = delete;
+        SnapshotStore& operator=(const SnapshotStore&) = delete;
+
+        /**
+         * @brief Drop every snapshot and fix the state shape.
+         */
+        void reset(size_t words, size_t slots);
+
+        /**
+         * @brief Append the state at `time`, replayed from `file_offset`.
+         */
+        void push(uint64_t time, uint64_t file_offset,
+                  const std::vector<uint64_t>& state_1bit,
+                  const MultibitState& state_multi);
+
+        /**
+         * @brief Overwrite the given state with snapshot k.
+         */
+        void restore(size_t k, std::vector<uint64_t>& state_1bit,
+                     MultibitState& state_multi) const;
+
+        /**
+         * @brief One 1-bit word, or one multi-bit slot's value, of snapshot
+         * k without restoring the rest of the state.
+         */
+        uint64_t word_at(size_t k, size_t word) const;
+        std::string_view value_at(size_t k, size_t slot) const;
+
+        /**
+         * @brief Keep every other snapshot (0, 2, 4, ...), re-encoding them
+         * against fresh keyframes and dropping unreferenced values.
+         */
+        void thin();
+
+        size_t size() const { return entries_.size(); }
+        bool empty() const { return entries_.empty(); }
+        const Entry& operator[](size_t k) const { return entries_[k]; }
+        const Entry& front() const { return entries_.front(); }
+        const Entry& back() const { return entries_.back(); }
+        const std::vector<Entry>& entries() const { return entries_; }
+
+        /// Bytes held, including container slack and the value pool.
+        size_t memory_usage() const;
+
+        /**
+         * @brief Serialize through a writer with pod(), pod_vec() and str().
+         */
+        template <typename Writer>
+        void write(Writer& w) const;
+
+        /**
+         * @brief Counterpart of write(); validates every index against the
+         * shape given to reset() and `file_size`.
+         */
+        template <typename Reader>
+        bool read(Reader& r, uint64_t file_size);
+
+       private:
+        struct Keyframe
+        {
+            std::vector<uint64_t> words;
+            std::vector<uint32_t> values;  // value id per slot
+        };
+
+        uint32_t intern(std::string_view value);
+        bool valid(uint64_t file_size) const;
+
+        size_t keyframe_bytes() const
+        {
+            return words_ * sizeof(uint64_t) + slots_ * sizeof(uint32_t);
+        }
+
+        size_t words_ = 0;
+        size_t slots_ = 0;
+        std::vector<Entry> entries_;
+        std::vector<Keyframe> keyframes_;
+        std::vector<uint32_t> delta_word_;
+        std::vector<uint64_t> delta_xor_;
+        std::vector<uint32_t> delta_slot_;
+        std::vector<uint32_t> delta_value_;
+
+        // Interned multi-bit values by id. The map's keys view the deque's
+        // strings, which never move once appended (not even on a move of
+        // the store), so lookups don't allocate.
+        std::deque<std::string> values_;
+        std::unordered_map<std::string_view, uint32_t> value_ids_;
+        size_t value_bytes_ = 0;
+    };
+
+    template <typename Writer>
+    void SnapshotStore::write(Writer& w) const
+    {
+        w.pod_vec(entries_);
+        w.pod(static_cast<uint64_t>(keyframes_.size()));
+        for (const Keyframe& kf : keyframes_)
+        {
+            w.pod_vec(kf.words);
+            w.pod_vec(kf.values);
+        }
+        w.pod_vec(delta_word_);
+        w.pod_vec(delta_xor_);
+        w.pod_vec(delta_slot_);
+        w.pod_vec(delta_value_);
+        w.pod(static_cast<uint64_t>(values_.size()));
+        for (const std::string& v : values_) w.str(v);
+    }
+
+    template <typename Reader>
+    bool SnapshotStore::read(Reader& r, uint64_t file_size)
+    {
+        reset(words_, slots_);
+        uint64_t n = 0;
+        if (!r.pod_vec(entries_)) return false;
+        n = r.template pod<uint64_t>();
+        for (uint64_t i = 0; i < n && r.ok(); ++i)
+        {
+            Keyframe kf;
+            if (!r.pod_vec(kf.words) || !r.pod_vec(kf.values)) return false;
+            keyframes_.push_back(std::move(kf));
+        }
+        if (!r.pod_vec(delta_word_) || !r.pod_vec(delta_xor_) ||
+            !r.pod_vec(delta_slot_) || !r.pod_vec(delta_value_))
+            return false;
+        n = r.template pod<uint64_t>();
+        for (uint64_t i = 0; i < n && r.ok(); ++i)
+        {
+            std::string v = r.str();
+            if (value_ids_.count(v)) return false;  // ids must be unique
+            intern(v);
+        }
+        return r.ok() && valid(file_size);
+    }
+
+}  // namespace vcd
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "waveform_parser.h"
+
+namespace vcd
+{
+
+    /**
+     * @brief The ParserStats of one parser, and its trace-event timeline.
+     *
+     * Counters are plain increments on the parser's hot paths and run
+     * whether or not stats are enabled; enabling zeroes them and makes them
+     * visible. Only Span reads the clock, and only while enabled, so a
+     * disabled recorder costs a branch per entry point.
+     */
+    class StatsRecorder
+    {
+       public:
+        /// Start over; `trace` also records a Span per call.
+        void enable(bool enabled, bool trace);
+        bool enabled() const { return enabled_; }
+
+        /// The counters bumped by the parser; Span adds the phase timings
+        ParserStats& counts() { return counts_; }
+
+        /// counts(), all zero while disabled
+        ParserStats stats() const
+        {
+            return enabled_ ? counts_ : ParserStats();
+        }
+
+        /// Times one call of a phase, nested spans included in their parent
+        class Span
+        {
+           public:
+            Span(StatsRecorder& recorder, ParserPhase phase)
+                : recorder_(recorder.enabled_ ? &recorder : nullptr),
+                  phase_(phase),
+                  begin_(recorder_ ? recorder_->now() : 0)
+            {
+            }
+            ~Span()
+            {
+                if (recorder_) recorder_->record(phase_, begin_);
+            }
+            Span(const Span&) = delete;
+            Span& operator=(const Span&) = delete;
+
+           private:
+            StatsRecorder* recorder_;
+            ParserPhase phase_;
+            uint64_t begin_;
+        };
+
+        /// Chrome trace-event JSON of the recorded spans, with `stats`
+        /// (normally the parser's stats()) as metadata
+        std::string trace_json(const ParserStats& stats) const;
+
+       private:
+        struct Event
+        {
+            uint64_t begin_ns;
+            uint64_t duration_ns;
+            ParserPhase phase;
+        };
+        // 24 MB of events at most; later spans are counted as dropped
+        static constexpr size_t MAX_EVENTS = 1 << 20;
+
+        uint64_t now() const;
+        void record(ParserPhase phase, uint64_t begin_ns);
+
+        bool enabled_ = false;
+        bool trace_ = false;
+        std::chrono::steady_clock::time_point origin_;
+        ParserStats counts_;
+        std::vector<Event> events_;
+        uint64_t dropped_ = 0;
+    };
+
+}  // namespace vcd
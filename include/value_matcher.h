@@ -0,0 +1,42 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+#include "waveform_parser.h"
+
+namespace vcd
+{
+
+    /**
+     * @brief A SearchPredicate bound to one signal, tested per value change.
+     *
+     * Values are as the parsers keep them: one character for a 1-bit
+     * signal, otherwise binary digits without the 'b' prefix, possibly
+     * shorter than the signal (VCD drops leading digits that extension
+     * restores), or a real number as text.
+     */
+    class ValueMatcher
+    {
+       public:
+        ValueMatcher(const SignalDef& sig, const SearchPredicate& predicate);
+
+        /// False if the Equals value is neither binary nor hex, so
+        /// nothing can match
+        bool valid() const { return valid_; }
+
+        /// Whether the change from `old_v` to `new_v` is a match
+        bool matches(std::string_view old_v, std::string_view new_v) const;
+
+       private:
+        /// Equal once both are extended to the signal's width
+        bool same(std::string_view a, std::string_view b) const;
+
+        SearchKind kind_;
+        std::string target_;  // binary digits, unless real_
+        bool real_;
+        bool one_bit_;  // edges only exist on 1-bit signals
+        bool valid_ = true;
+    };
+
+}  // namespace vcd
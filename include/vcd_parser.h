@@ -1,5 +1,6 @@
 #pragma once
 
+#include "query_cache.h"
 #include "waveform_parser.h"
 
 namespace vcd
@@ -50,22 +51,101 @@ namespace vcd
 
         // --- Indexing Phase ---
 
-        /// Open a VCD file using standard fopen
+        /// Open a VCD file using standard fopen. A gzip-compressed file
+        /// (detected by its magic bytes) is decompressed as it is read;
+        /// indexing records restart points so queries needn't decompress
+        /// from the start. It is indexed and queried on one thread.
         bool open_file(const std::string& filepath) override;
 
         /// Close the currently opened file
         void close_file() override;
 
+        /// Number of threads used to scan the data section while indexing.
+        /// 1 (the default) keeps the serial path, 0 uses every hardware
+        /// thread. Ignored on builds without thread support (WASM).
+        void set_index_threads(unsigned threads);
+
+        /// Number of threads replaying a query. Each query_step splits its
+        /// range at '#' lines into one shard per thread; shards extract the
+        /// queried signals' changes in parallel and are applied in order,
+        /// so results match the serial replay. 1 (the default) keeps the
+        /// serial path, 0 uses every hardware thread. Ignored on builds
+        /// without thread support.
+        void set_query_threads(unsigned threads);
+
+        /// Also record, per signal, the snapshot intervals in which it
+        /// changes. Queries then replay only the intervals that touch the
+        /// requested signals instead of everything after the start snapshot.
+        /// Costs 4 bytes per (signal, interval) with a change. Takes effect
+        /// at the next begin_indexing().
+        void set_transition_index(bool enabled);
+
+        /// Keep per-signal LOD pyramids (power-of-two time buckets holding
+        /// the settled value and change count). A whole-trace query with
+        /// pixel_time_step > 0 builds them for the signals it replays; later
+        /// zoomed-out queries for those signals skip the replay and read the
+        /// coarsest level no wider than pixel_time_step.
+        void set_lod_pyramids(bool enabled);
+
+        /// Keep finished query results per signal and pixel_time_step, up
+        /// to `bytes` (0 disables the cache; defaults to 16 MB). A query
+        /// inside a cached range skips the replay, one overlapping the end
+        /// of a cached range only replays the part that isn't cached.
+        void set_query_cache_budget(size_t bytes);
+        const QueryCache::Stats& query_cache_stats() const;
+
+        /// Place snapshots every max_replay_bytes of data, widening the
+        /// spacing (and thinning the snapshots taken so far) whenever they
+        /// would exceed memory_budget. A sidecar whose snapshots exceed the
+        /// budget is rejected by load_index().
+        void set_snapshot_policy(const SnapshotPolicy& policy) override;
+
         /// Start indexing phase. Resets all internal state.
         void begin_indexing() override;
 
         /// Repeatedly call to read and process chunks of the file.
-        /// @return Number of bytes read in this step (0 means EOF or error)
+        /// @return Number of bytes read in this step (0 means EOF or error);
+        /// decompressed bytes for a gzip file
         size_t index_step(size_t chunk_size) override;
 
+        /// Bytes of the file on disk consumed so far, for progress. Equals
+        /// the bytes indexed unless the file is compressed.
+        uint64_t input_position() const;
+
         /// Finalize indexing. Creates a final snapshot if needed.
         void finish_indexing() override;
 
+        // --- Live Tail ---
+
+        /// Follow a file that a running simulation still appends to. Set
+        /// before begin_indexing(); the file is then indexed on one thread.
+        /// finish_indexing() leaves an incomplete last line pending and
+        /// takes no snapshot at the end, and time_end() is where the
+        /// complete lines stop. Turning it off afterwards finalizes the
+        /// index as finish_indexing() would have. Not for gzip input.
+        void set_follow(bool enabled);
+
+        /// Index up to `chunk_size` bytes appended since finish_indexing()
+        /// or the previous call, continuing the snapshot chain where it
+        /// stopped. Ends a running query. Cached results and LOD pyramids
+        /// reaching the old end are dropped, so a query near time_end()
+        /// only replays from the snapshot before it.
+        /// @return Bytes indexed; 0 once caught up, when not following, or
+        /// when the file shrank (i.e. was rewritten and needs re-indexing)
+        size_t follow_step(size_t chunk_size);
+
+        // --- Index Persistence ---
+
+        /// Write the snapshot index, hierarchy and header metadata to a
+        /// versioned sidecar, conventionally "<file>.vcd.wvidx". The file is
+        /// written to a temporary name and renamed into place.
+        bool save_index(const std::string& index_path) const override;
+
+        /// Load a sidecar written by save_index(). It is rejected when its
+        /// format version differs or when the VCD's size, mtime or header
+        /// bytes no longer match, in which case the caller re-indexes.
+        bool load_index(const std::string& index_path) override;
+
         // --- Query Phase ---
 
         /// Binary-search the snapshot list to find the best starting point
@@ -82,15 +162,35 @@ namespace vcd
 
         /// Extract the query results accumulated so far.
         QueryResultBinary flush_query_binary() override;
+        QueryResultBinary take_query_segment(bool final) override;
+
+        // --- Value Search ---
+
+        /// Replays the snapshot intervals from the one nearest `from_time`,
+        /// or with a transition index only those in which the signal
+        /// changes, looking up nothing but the signal's own id.
+        SearchResult find_next(uint32_t signal_index,
+                               const SearchPredicate& predicate,
+                               uint64_t from_time,
+                               SearchDirection direction) override;
 
         // --- Statistics ---
         size_t snapshot_count() const override;
         size_t index_memory_usage() const override;
+        /// The part of index_memory_usage() held by snapshots
+        size_t snapshot_memory_usage() const;
+
+        // --- Instrumentation ---
+        void set_stats_enabled(bool enabled, bool trace = false) override;
+        ParserStats stats() const override;
+        std::string trace_json() const override;
 
         /// Cancel an ongoing query
         void cancel_query() override;
 
        private:
+        size_t index_step_parallel(size_t chunk_size);
+
         struct Impl;
         std::unique_ptr<Impl> impl_;
     };
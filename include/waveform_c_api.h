@@ -0,0 +1,121 @@
+#pragma once
+
+/*
+ * C interface to the parsers, for hosts that cannot call C++ directly
+ * (the Tauri backend links it from Rust). It mirrors the Embind wrapper in
+ * wasm_bindings.cpp: one handle per open file, either a VcdParser or an
+ * FstParser, chosen by the file's extension.
+ *
+ * Buffers and strings returned by a function belong to the handle and stay
+ * valid until the same function is called again on it, or the handle is
+ * closed. A handle may be used from one thread at a time, except for
+ * wv_cancel_query(), which may be called while a query step runs.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    typedef struct wv_parser wv_parser;
+
+    /* NULL if the file can't be opened. */
+    wv_parser* wv_open(const char* path);
+    void wv_close(wv_parser* p);
+
+    /* --- Options, before indexing (see VcdParser; VCD only unless noted) */
+    void wv_set_snapshot_policy(wv_parser* p, uint64_t memory_budget,
+                                uint64_t max_replay_bytes); /* both */
+    void wv_set_index_threads(wv_parser* p, unsigned threads);
+    void wv_set_query_threads(wv_parser* p, unsigned threads); /* both */
+    void wv_set_transition_index(wv_parser* p, int enabled);
+    void wv_set_lod_pyramids(wv_parser* p, int enabled);
+
+    /* --- Indexing --- */
+    int wv_load_index(wv_parser* p, const char* index_path);
+    int wv_save_index(const wv_parser* p, const char* index_path);
+    void wv_begin_indexing(wv_parser* p);
+    size_t wv_index_step(wv_parser* p, size_t chunk_size);
+    void wv_finish_indexing(wv_parser* p);
+    /* Bytes of the file consumed so far, for progress (VCD; 0 for FST) */
+    uint64_t wv_input_position(const wv_parser* p);
+    int wv_is_open(const wv_parser* p);
+
+    /* --- Metadata --- */
+    const char* wv_date(const wv_parser* p);
+    const char* wv_version(const wv_parser* p);
+    int wv_timescale_magnitude(const wv_parser* p);
+    const char* wv_timescale_unit(const wv_parser* p); /* "s" ... "fs" */
+    uint64_t wv_time_begin(const wv_parser* p);
+    uint64_t wv_time_end(const wv_parser* p);
+    uint32_t wv_signal_count(const wv_parser* p);
+    uint32_t wv_snapshot_count(const wv_parser* p);
+    uint64_t wv_index_memory_usage(const wv_parser* p);
+
+    /* Same JSON as the WASM getSignalsJSON / getHierarchyJSON */
+    const char* wv_signals_json(wv_parser* p);
+    const char* wv_hierarchy_json(wv_parser* p);
+
+    /* Paged hierarchy, layouts in hierarchy_pages.h */
+    uint32_t wv_scope_count(wv_parser* p);
+    uint32_t wv_name_count(wv_parser* p);
+    const uint8_t* wv_scope_page(wv_parser* p, uint32_t scope,
+                                 uint32_t child_offset, uint32_t child_limit,
+                                 uint32_t signal_offset, uint32_t signal_limit,
+                                 size_t* size);
+    const uint8_t* wv_name_page(wv_parser* p, uint32_t first, uint32_t count,
+                                size_t* size);
+
+    /* Signal index of a full path, -1 if there is none */
+    int64_t wv_find_signal(const wv_parser* p, const char* full_path);
+
+    /* --- Instrumentation (see ParserStats), off until enabled --- */
+    void wv_set_stats_enabled(wv_parser* p, int enabled, int trace);
+    /* Same JSON as the WASM getStatsJSON */
+    const char* wv_stats_json(wv_parser* p);
+    /* Chrome trace-event JSON, for chrome://tracing or Perfetto */
+    const char* wv_trace_json(wv_parser* p);
+
+    /* --- Queries --- */
+
+    /* Plans from the snapshot before `start_time` and starts the query */
+    void wv_begin_query(wv_parser* p, uint64_t start_time, uint64_t end_time,
+                        const uint32_t* signals, size_t count,
+                        float pixel_time_step);
+    int wv_query_step(wv_parser* p, size_t chunk_size);
+    void wv_cancel_query(wv_parser* p);
+
+    /*
+     * Records finalized since the previous call (see take_query_segment),
+     * in the compressed columnar layout of columnar_result.h with one run
+     * per queried signal. Pass `final` after the last wv_query_step.
+     */
+    const uint8_t* wv_take_query_frame(wv_parser* p, int final, size_t* size);
+
+    /* --- Value search (see IWaveformParser::find_next) --- */
+
+    /* wv_find_next() kinds, as vcd::SearchKind */
+    enum
+    {
+        WV_SEARCH_ANY_CHANGE = 0,
+        WV_SEARCH_RISING = 1,
+        WV_SEARCH_FALLING = 2,
+        WV_SEARCH_EQUALS = 3
+    };
+
+    /*
+     * 1 and the change's time in *time if `signal` has a change matching
+     * `kind` (and `value`, binary or "0x"/"h" hex digits, for
+     * WV_SEARCH_EQUALS) after `from_time`, or before it when `backward`;
+     * otherwise 0. -1 if `value` is neither binary nor hex.
+     */
+    int wv_find_next(wv_parser* p, uint32_t signal, int kind,
+                     const char* value, uint64_t from_time, int backward,
+                     uint64_t* time);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <string>
+
+#include "waveform_parser.h"
+
+namespace vcd
+{
+
+    /// Lower-case VCD keyword of `type` ("wire", "reg", ...).
+    const char* var_type_name(VarType type);
+
+    /// Unit of a timescale ("s" ... "fs").
+    const char* time_unit_name(TimeUnit unit);
+
+    /// Short name of a phase ("open", "index", ...).
+    const char* parser_phase_name(ParserPhase phase);
+
+    /// The signal table as a JSON array of
+    /// { name, fullPath, idCode, width, index, type[, msb, lsb] }.
+    std::string signals_json(const IWaveformParser& parser);
+
+    /// The scope tree as nested { name, fullPath[, signals][, children] },
+    /// "{}" before a header was parsed.
+    std::string hierarchy_json(const IWaveformParser& parser);
+
+    /// ParserStats as { bytesScanned, linesParsed, idLookups,
+    /// changesApplied, changesEmitted, glitchesCollapsed, blocksDecoded,
+    /// phases: { <phase name>: { ms, calls } } }.
+    std::string stats_json(const ParserStats& stats);
+
+}  // namespace vcd
@@ -4,6 +4,7 @@
 #include <cstdint>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace vcd
@@ -56,12 +57,15 @@ namespace vcd
         FS
     };
 
-    /// Signal definition (from header)
+    struct ScopeNode;
+
+    /// Signal definition (from header). The names point into storage owned
+    /// by the parser and are valid while its file stays open.
     struct SignalDef
     {
-        std::string name;       // signal name (leaf)
-        std::string full_path;  // full hierarchical path, e.g. "top.cpu.clk"
-        std::string id_code;    // identifier code
+        std::string_view name;     // signal name (leaf), interned
+        std::string_view id_code;  // VCD identifier code, empty for FST
+        const ScopeNode* scope = nullptr;  // declaring scope
         VarType type = VarType::Unknown;
         int width = 1;  // bit width
         int msb = -1;   // bit range
@@ -71,18 +75,48 @@ namespace vcd
             UINT32_MAX;  // Index for 1-bit state (valid if width==1)
         uint32_t str_index =
             UINT32_MAX;  // Index for multi-bit state (valid if width>1)
+
+        /// Full hierarchical path, e.g. "top.cpu.clk", built on each call
+        std::string full_path() const;
     };
 
     /// Scope node for hierarchy tree
     struct ScopeNode
     {
-        std::string name;
-        std::string full_path;
+        std::string_view name;  // interned, see SignalDef
         ScopeNode* parent = nullptr;
         std::vector<std::unique_ptr<ScopeNode>> children;
         std::vector<uint32_t> signal_indices;  // indices into SignalDef array
+
+        /// Dotted path below the root ("" for the root itself)
+        std::string full_path() const
+        {
+            size_t length = 0;
+            for (const ScopeNode* s = this; s->parent; s = s->parent)
+                length += s->name.size() + 1;
+            if (length == 0) return {};
+
+            // Fill from the back, innermost name last
+            std::string path(length - 1, '.');
+            size_t end = path.size();
+            for (const ScopeNode* s = this; s->parent; s = s->parent)
+            {
+                end -= s->name.size();
+                path.replace(end, s->name.size(), s->name);
+                if (end) --end;
+            }
+            return path;
+        }
     };
 
+    inline std::string SignalDef::full_path() const
+    {
+        std::string path = scope ? scope->full_path() : std::string();
+        if (!path.empty()) path += '.';
+        path.append(name);
+        return path;
+    }
+
     /// Timescale info
     struct Timescale
     {
@@ -94,15 +128,15 @@ namespace vcd
     // Sparse Indexing & Snapshot Structures
     // ============================================================================
 
-    /// Compressed snapshot of the simulation state at a specific time.
-    struct Snapshot
+    /// Snapshot placement limits applied while indexing. When both can't be
+    /// met, the memory budget wins and replays get longer.
+    struct SnapshotPolicy
     {
-        uint64_t time;         // Simulation time at snapshot
-        uint64_t file_offset;  // Byte offset in the original file
-        std::vector<uint64_t>
-            packed_1bit_states;  // Bit-packed states (2 bits per value: 00=0,
-                                 // 01=1, 10=x, 11=z)
-        std::vector<std::string> multibit_states;
+        /// Upper bound on the memory held by snapshots, 0 for unlimited.
+        size_t memory_budget = 0;
+        /// Bytes replayed at most between a snapshot and the next one, i.e.
+        /// the worst-case scan of a query. 0 keeps the default (10 MB).
+        uint64_t max_replay_bytes = 0;
     };
 
     /// Tells the caller where to seek in the file and provides the snapshot
@@ -150,6 +184,80 @@ namespace vcd
         size_t string_pool_size;
     };
 
+    // ============================================================================
+    // Value Search
+    // ============================================================================
+
+    /// What IWaveformParser::find_next() looks for
+    enum class SearchKind : uint8_t
+    {
+        AnyChange,  // the value differs from the previous one
+        Rising,     // 1-bit: changes to '1'
+        Falling,    // 1-bit: changes to '0'
+        Equals      // changes to SearchPredicate::value
+    };
+
+    struct SearchPredicate
+    {
+        SearchKind kind = SearchKind::AnyChange;
+        /// For Equals: binary digits ('b' prefix optional) or hex ("0x" or
+        /// 'h' prefix), x/z allowed, extended to the signal's width the
+        /// way VCD extends short values. A real signal's value is compared
+        /// as text. Anything else fails with SearchResult::invalid_value.
+        std::string value;
+    };
+
+    enum class SearchDirection : uint8_t
+    {
+        Forward,
+        Backward
+    };
+
+    struct SearchResult
+    {
+        bool found = false;
+        uint64_t time = 0;  // of the matching change
+        /// SearchPredicate::value can't be read: nothing was searched
+        bool invalid_value = false;
+    };
+
+    // ============================================================================
+    // Instrumentation
+    // ============================================================================
+
+    /// Parser entry points timed by ParserStats
+    enum class ParserPhase : uint8_t
+    {
+        Open,
+        Index,  // index_step and finish_indexing
+        LoadIndex,
+        BeginQuery,
+        SnapshotRestore,  // part of BeginQuery
+        QueryStep,
+        Flush,  // flush_query_binary
+        Search,
+        Count
+    };
+
+    /// Hot-path counters since the stats were enabled, see
+    /// IWaveformParser::set_stats_enabled(). Counters that don't apply to
+    /// a format stay 0.
+    struct ParserStats
+    {
+        static constexpr size_t PHASES =
+            static_cast<size_t>(ParserPhase::Count);
+
+        uint64_t bytes_scanned = 0;       // FST: estimated per block decoded
+        uint64_t lines_parsed = 0;        // VCD, non-empty lines
+        uint64_t id_lookups = 0;          // VCD id code hash lookups
+        uint64_t changes_applied = 0;     // value changes applied to state
+        uint64_t changes_emitted = 0;     // records returned by queries
+        uint64_t glitches_collapsed = 0;  // glitch runs merged by LOD
+        uint64_t blocks_decoded = 0;      // FST value-change blocks
+        uint64_t phase_ns[PHASES] = {};   // wall time per ParserPhase
+        uint64_t phase_calls[PHASES] = {};
+    };
+
     // ============================================================================
     // IWaveformParser Interface
     // ============================================================================
@@ -181,12 +289,23 @@ namespace vcd
             const std::string& full_path) const = 0;
 
         // --- Indexing Phase ---
+        /// Takes effect at the next begin_indexing() / load_index().
+        virtual void set_snapshot_policy(const SnapshotPolicy& policy) = 0;
         virtual bool open_file(const std::string& filepath) = 0;
         virtual void close_file() = 0;
         virtual void begin_indexing() = 0;
         virtual size_t index_step(size_t chunk_size) = 0;
         virtual void finish_indexing() = 0;
 
+        // --- Index Persistence ---
+        /// Write the index built by finish_indexing() to `index_path`.
+        virtual bool save_index(const std::string& index_path) const = 0;
+
+        /// Restore an index written by save_index() for the opened file,
+        /// replacing the begin/step/finish_indexing sequence. Returns false
+        /// if the index is missing, incompatible or stale.
+        virtual bool load_index(const std::string& index_path) = 0;
+
         // --- Query Phase ---
         virtual QueryPlan get_query_plan(uint64_t start_time) const = 0;
 
@@ -197,11 +316,39 @@ namespace vcd
 
         virtual bool query_step(size_t chunk_size) = 0;
         virtual QueryResultBinary flush_query_binary() = 0;
+
+        /// Records that became final since the previous call, for drawing a
+        /// query while it runs (see ResultSegments). Pass `final` after the
+        /// last query_step to also get the rest, completed as by
+        /// flush_query_binary(). Unlike a mid-query flush_query_binary(),
+        /// this never closes a glitch early.
+        virtual QueryResultBinary take_query_segment(bool final) = 0;
         virtual void cancel_query() = 0;
 
+        // --- Value Search ---
+        /// The first change of `signal_index` after `from_time` (Forward),
+        /// or the last one before it (Backward), that satisfies
+        /// `predicate`. Changes at time_begin() only set initial values and
+        /// never match. Only the signal's own changes are decoded, without
+        /// producing query results; a running query is not disturbed.
+        virtual SearchResult find_next(uint32_t signal_index,
+                                       const SearchPredicate& predicate,
+                                       uint64_t from_time,
+                                       SearchDirection direction) = 0;
+
         // --- Statistics ---
         virtual size_t snapshot_count() const = 0;
         virtual size_t index_memory_usage() const = 0;
+
+        // --- Instrumentation (off by default) ---
+        /// Collect ParserStats from now on, and with `trace` a timeline of
+        /// the phases for trace_json(). Every call starts from zero.
+        virtual void set_stats_enabled(bool enabled, bool trace = false) = 0;
+        /// All zero while disabled
+        virtual ParserStats stats() const = 0;
+        /// Chrome trace-event JSON (chrome://tracing, Perfetto) of the
+        /// phases traced so far, with stats() attached as metadata
+        virtual std::string trace_json() const = 0;
     };
 
 }  // namespace vcd
@@ -0,0 +1,76 @@
+#include "block_cache.h"
+
+namespace vcd
+{
+
+    void BlockCache::set_budget(size_t bytes)
+    {
+        budget_ = bytes;
+        while (stats_.memory_usage > budget_ && !order_.empty())
+            erase(map_.find(order_.back()));
+    }
+
+    void BlockCache::clear()
+    {
+        map_.clear();
+        order_.clear();
+        stats_ = {};
+    }
+
+    const BlockCache::Entry* BlockCache::find(uint32_t tile, uint32_t handle)
+    {
+        auto it = map_.find(key(tile, handle));
+        if (it == map_.end())
+        {
+            ++stats_.misses;
+            return nullptr;
+        }
+        ++stats_.hits;
+        order_.splice(order_.begin(), order_, it->second.position);
+        return &it->second.entry;
+    }
+
+    void BlockCache::insert(uint32_t tile, uint32_t handle, Entry&& entry)
+    {
+        uint64_t k = key(tile, handle);
+        auto old = map_.find(k);
+        if (old != map_.end()) erase(old);
+
+        entry.times.shrink_to_fit();
+        entry.value_ends.shrink_to_fit();
+        entry.values.shrink_to_fit();
+        size_t bytes = bytes_of(entry);
+        if (bytes > budget_) return;
+
+        order_.push_front(k);
+        Node& node = map_[k];
+        node.entry = std::move(entry);
+        node.bytes = bytes;
+        node.position = order_.begin();
+        stats_.memory_usage += bytes;
+        stats_.entries = map_.size();
+
+        while (stats_.memory_usage > budget_)
+            erase(map_.find(order_.back()));
+    }
+
+    void BlockCache::erase(std::unordered_map<uint64_t, Node>::iterator it)
+    {
+        stats_.memory_usage -= it->second.bytes;
+        order_.erase(it->second.position);
+        map_.erase(it);
+        stats_.entries = map_.size();
+    }
+
+    size_t BlockCache::bytes_of(const Entry& e)
+    {
+        // Entry data, plus the map node and list node holding it
+        size_t b = e.times.capacity() * sizeof(uint64_t) +
+                   e.value_ends.capacity() * sizeof(uint32_t) +
+                   sizeof(Node) + 4 * sizeof(void*) + sizeof(uint64_t);
+        if (e.values.capacity() > std::string().capacity())
+            b += e.values.capacity() + 1;
+        return b;
+    }
+
+}  // namespace vcd
@@ -0,0 +1,166 @@
+#include "columnar_result.h"
+
+namespace vcd
+{
+
+    namespace
+    {
+        constexpr uint32_t NO_RUN = UINT32_MAX;
+    }
+
+    // Stable counting sort of the records by run
+    template <typename Record>
+    void ColumnarEncoder::group(const Record* records, size_t count,
+                                Grouping& g)
+    {
+        size_t runs = g.begin.size() - 1;
+        auto run_of = [&](const Record& rec)
+        {
+            return rec.signal_index < run_of_signal_.size()
+                       ? run_of_signal_[rec.signal_index]
+                       : NO_RUN;
+        };
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            uint32_t r = run_of(records[i]);
+            if (r != NO_RUN) ++g.begin[r + 1];
+        }
+        for (size_t r = 0; r < runs; ++r) g.begin[r + 1] += g.begin[r];
+
+        g.order.resize(g.begin[runs]);
+        g.cursor.assign(g.begin.begin(), g.begin.end() - 1);
+        for (size_t i = 0; i < count; ++i)
+        {
+            uint32_t r = run_of(records[i]);
+            if (r != NO_RUN)
+                g.order[g.cursor[r]++] = static_cast<uint32_t>(i);
+        }
+    }
+
+    const std::vector<uint8_t>& ColumnarEncoder::encode(
+        const QueryResultBinary& res, const std::vector<uint32_t>& signals,
+        bool compressed)
+    {
+        const size_t runs = signals.size();
+
+        // A signal listed twice gets its records in the first run only
+        run_of_signal_.clear();
+        for (size_t r = 0; r < runs; ++r)
+        {
+            uint32_t s = signals[r];
+            if (s >= run_of_signal_.size())
+                run_of_signal_.resize(static_cast<size_t>(s) + 1, NO_RUN);
+            if (run_of_signal_[s] == NO_RUN)
+                run_of_signal_[s] = static_cast<uint32_t>(r);
+        }
+        group_1bit_.begin.assign(runs + 1, 0);
+        group_multi_.begin.assign(runs + 1, 0);
+        group(res.transitions_1bit, res.count_1bit, group_1bit_);
+        group(res.transitions_multibit, res.count_multibit, group_multi_);
+
+        out_.assign(HEADER_SIZE + runs * ENTRY_SIZE, 0);
+        put_u32(0, static_cast<uint32_t>(runs));
+        put_u32(4, compressed ? COMPRESSED : 0);
+
+        for (size_t r = 0; r < runs; ++r)
+        {
+            // A signal's records are all 1-bit or all multi-bit
+            bool multi = group_multi_.begin[r + 1] > group_multi_.begin[r];
+            const Grouping& g = multi ? group_multi_ : group_1bit_;
+            const uint32_t* idx = g.order.data() + g.begin[r];
+            size_t count = g.begin[r + 1] - g.begin[r];
+            auto time_of = [&](size_t k)
+            {
+                return multi ? res.transitions_multibit[idx[k]].timestamp
+                             : res.transitions_1bit[idx[k]].timestamp;
+            };
+
+            uint32_t flags = multi ? MULTIBIT : 0;
+            if (!multi)
+            {
+                for (size_t k = 0; k < count; ++k)
+                    if (res.transitions_1bit[idx[k]].value > 3)
+                    {
+                        flags |= WIDE_VALUES;
+                        break;
+                    }
+            }
+
+            size_t entry = HEADER_SIZE + r * ENTRY_SIZE;
+            put_u32(entry, signals[r]);
+            put_u32(entry + 4, static_cast<uint32_t>(count));
+            put_u32(entry + 8, flags);
+
+            // Times within a run never decrease, so deltas are unsigned
+            if (!compressed) align(8);
+            put_u32(entry + 12, static_cast<uint32_t>(out_.size()));
+            uint64_t prev = 0;
+            for (size_t k = 0; k < count; ++k)
+            {
+                uint64_t t = time_of(k);
+                if (compressed)
+                    append_varint(t - prev);
+                else
+                    append_u64(t);
+                prev = t;
+            }
+
+            put_u32(entry + 16, static_cast<uint32_t>(out_.size()));
+            if (multi)
+            {
+                for (size_t k = 0; k < count; ++k)
+                {
+                    const TransitionMultiBit& t =
+                        res.transitions_multibit[idx[k]];
+                    append_varint(t.string_length);
+                    const char* s = res.string_pool + t.string_offset;
+                    out_.insert(out_.end(), s, s + t.string_length);
+                }
+            }
+            else
+            {
+                unsigned bits = (flags & WIDE_VALUES) ? 4 : 2;
+                uint8_t mask = static_cast<uint8_t>((1u << bits) - 1);
+                size_t at = out_.size();
+                out_.resize(at + (count * bits + 7) / 8, 0);
+                for (size_t k = 0; k < count; ++k)
+                {
+                    size_t bit = k * bits;
+                    out_[at + bit / 8] |= static_cast<uint8_t>(
+                        (res.transitions_1bit[idx[k]].value & mask)
+                        << (bit % 8));
+                }
+            }
+        }
+        return out_;
+    }
+
+    void ColumnarEncoder::put_u32(size_t at, uint32_t v)
+    {
+        for (int i = 0; i < 4; ++i)
+            out_[at + i] = static_cast<uint8_t>(v >> (8 * i));
+    }
+
+    void ColumnarEncoder::append_u64(uint64_t v)
+    {
+        for (int i = 0; i < 8; ++i)
+            out_.push_back(static_cast<uint8_t>(v >> (8 * i)));
+    }
+
+    void ColumnarEncoder::append_varint(uint64_t v)
+    {
+        while (v >= 0x80)
+        {
+            out_.push_back(static_cast<uint8_t>(v | 0x80));
+            v >>= 7;
+        }
+        out_.push_back(static_cast<uint8_t>(v));
+    }
+
+    void ColumnarEncoder::align(size_t to)
+    {
+        out_.resize((out_.size() + to - 1) / to * to, 0);
+    }
+
+}  // namespace vcd
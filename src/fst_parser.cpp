@@ -1,48 +1,189 @@
 #include "fst_parser.h"
 
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include <algorithm>
+#include <atomic>
 #include <cstring>
-#include <unordered_map>
 
+#if WAVEFORM_HAVE_THREADS
+#include <thread>
+#endif
+
+#include "block_cache.h"
 #include "fstapi.h"
 #include "lod_manager.h"
+#include "multibit_state.h"
+#include "query_cache.h"
+#include "result_segments.h"
+#include "signal_names.h"
+#include "signal_slots.h"
+#include "stats_recorder.h"
+#include "value_matcher.h"
 
 namespace vcd
 {
+    namespace
+    {
+        uint64_t file_size_of(const std::string& path)
+        {
+#if defined(_WIN32)
+            struct _stat64 st;
+            if (_stat64(path.c_str(), &st) != 0) return 0;
+#else
+            struct stat st;
+            if (::stat(path.c_str(), &st) != 0) return 0;
+#endif
+            return static_cast<uint64_t>(st.st_size);
+        }
+    }  // namespace
+
     struct FstParser::Impl
     {
         fstReaderContext* ctx = nullptr;
+        std::string file_path;
         std::vector<SignalDef> signals;
         std::unique_ptr<ScopeNode> root_scope;
-        std::unordered_map<std::string, uint32_t> sig_map;
-        std::unordered_map<fstHandle, uint32_t> handle_to_sig;
+        PathIndex path_index;
+        NamePool names;  // of the scopes and signals
 
-        std::vector<uint8_t> current_state_1bit;
-        std::vector<std::string> current_state_multi;
+        // Signals declared on each handle (several when nets are aliased)
+        // are handle_signals[handle_offsets[h] .. handle_offsets[h + 1]).
+        // FST handles are dense from 1, so this is a flat lookup.
+        std::vector<uint32_t> handle_offsets;
+        std::vector<uint32_t> handle_signals;
+        std::vector<fstHandle> signal_handle;  // by signal index
+
+        // Query-local state is by slot of query_slots, sized to the queried
+        // signals and kept (with its capacity) across queries
+        SignalSlots query_slots;
+        std::vector<uint8_t> current_state_1bit;  // by slot
+        MultibitState current_state_multi;        // by slot
 
         std::vector<Transition1Bit> res_1bit;
         std::vector<TransitionMultiBit> res_multi;
         std::string string_pool;
 
         LodManager lod_manager;
-        std::vector<int64_t> last_index_1bit;
-        std::vector<int64_t> last_index_multi;
+        ResultSegments segments;
+        QueryCache query_cache;
+        std::vector<int64_t> last_index_1bit;   // by slot
+        std::vector<int64_t> last_index_multi;  // by slot
+
+        // Scratch of begin_query and query_step
+        std::vector<uint32_t> query_widths;
+        std::vector<uint32_t> query_replay;
+        std::vector<char> val_buf = std::vector<char>(65536);
+        std::vector<fstHandle> misses;
 
         uint64_t query_t_begin = 0;
         uint64_t query_t_end = 0;
         bool query_done = false;
+        std::atomic<bool> query_cancel_flag{false};
+
+        // A query is replayed one time window at a time. Each window holds
+        // roughly as many value-change blocks as fit in the step's chunk
+        // size, and values are only accepted inside the current window, so
+        // a block straddling two windows isn't emitted twice.
+        uint64_t file_size = 0;
+        uint64_t section_count = 0;
+        uint64_t window_begin = 0;
+        uint64_t window_end = 0;
+
+        // Decoded changes are cached per time tile of about one block
+        // (tile_width time units, the last tile open-ended). A step replays
+        // tiles [step_tile, step_tile + capture_tiles): handles cached for
+        // all of them come from block_cache, the rest are decoded by libfst
+        // over [decode_begin, decode_end], captured tile by tile, then
+        // replayed the same way.
+        BlockCache block_cache;
+        uint64_t dump_begin = 0;
+        uint64_t tile_width = 1;
+        uint32_t last_tile = 0;
+        uint32_t step_tile = 0;
+        uint32_t capture_tiles = 0;
+        uint64_t decode_begin = 0;
+        uint64_t decode_end = 0;
+        std::vector<int32_t> capture_slot;  // by handle, -1 if cached
+        std::vector<BlockCache::Entry> captured;
+
+        // Handles left to decode are split across query_threads readers:
+        // ctx plus worker_ctx, extra contexts opened on the same file. Each
+        // only writes the captured entries of its own handles.
+        unsigned query_threads = 1;
+        std::vector<fstReaderContext*> worker_ctx;
+
+        uint32_t tile_of(uint64_t time) const
+        {
+            if (time <= dump_begin) return 0;
+            uint64_t k = (time - dump_begin) / tile_width;
+            return k < last_tile ? static_cast<uint32_t>(k) : last_tile;
+        }
+        uint64_t tile_first(uint32_t k) const
+        {
+            return k == 0 ? 0 : dump_begin + k * tile_width;
+        }
+        uint64_t tile_last(uint32_t k) const
+        {
+            return k >= last_tile ? UINT64_MAX
+                                  : dump_begin + (k + 1) * tile_width - 1;
+        }
+
+        // Value of each handle over a time range it is known not to change
+        // in, learned from earlier queries. fstReaderGetValueFromHandleAtTime
+        // re-decodes a handle's chain from its block on every call, so when
+        // the next view starts inside [from, until] the initial value comes
+        // from here instead. An entry is "open" while the current query
+        // hasn't yet seen its handle change, and `until` grows with every
+        // replayed window.
+        struct KnownValue
+        {
+            uint64_t from = 0;
+            uint64_t until = 0;
+            std::string value;
+            bool valid = false;
+            bool open = false;
+        };
+        std::vector<KnownValue> known_values;  // by handle
+        std::vector<fstHandle> query_handles;
+        // Only the previous query's entries are cleared on the next one
+        std::vector<uint8_t> in_query;       // by signal index
+        std::vector<uint8_t> handle_listed;  // by handle, in query_handles
 
         Timescale timescale_info;
 
+        // --- Instrumentation (set_stats_enabled) ---
+        StatsRecorder stats;
+        uint64_t glitch_base = 0;    // lod_manager.glitch_count() at enable
+        size_t results_counted = 0;  // of this query, in changes_emitted
+
+        // Blocks are assumed evenly sized, as for the tiles
+        void count_blocks(uint64_t blocks)
+        {
+            ParserStats& counts = stats.counts();
+            counts.blocks_decoded += blocks;
+            counts.bytes_scanned +=
+                blocks * (file_size / std::max<uint64_t>(1, section_count));
+        }
+
         ~Impl()
         {
+            close_workers();
             if (ctx) fstReaderClose(ctx);
         }
 
+        void close_workers()
+        {
+            for (fstReaderContext* w : worker_ctx) fstReaderClose(w);
+            worker_ctx.clear();
+        }
+
         static void fst_callback(void* user_data, uint64_t time,
                                  fstHandle facidx, const unsigned char* value)
         {
             auto* self = static_cast<FstParser::Impl*>(user_data);
-            self->handle_value(time, facidx, value, 0);
+            self->capture_value(time, facidx, value, 0);
         }
 
         static void fst_callback_varlen(void* user_data, uint64_t time,
@@ -51,27 +192,278 @@ namespace vcd
                                         uint32_t len)
         {
             auto* self = static_cast<FstParser::Impl*>(user_data);
-            self->handle_value(time, facidx, value, len);
+            self->capture_value(time, facidx, value, len);
+        }
+
+        // A value as libfst hands it to the callbacks (`len` 0 unless
+        // variable-length), spelled as the query results do
+        static std::string_view value_token(const SignalDef& sig,
+                                            const unsigned char* value,
+                                            uint32_t len)
+        {
+            // Fixed-width values are exactly `width` characters; only reals
+            // (printed by libfst) and unknown types need measuring.
+            if (len == 0)
+                len = sig.type == VarType::Real ||
+                              sig.type == VarType::Unknown || sig.width == 0
+                          ? static_cast<uint32_t>(std::strlen(
+                                reinterpret_cast<const char*>(value)))
+                          : sig.width;
+            std::string_view val_tok(reinterpret_cast<const char*>(value),
+                                     len);
+            if (sig.width == 1)
+                val_tok = val_tok.substr(0, 1);
+            else if (!val_tok.empty() && (value[0] == 'b' || value[0] == 'B'))
+                val_tok.remove_prefix(1);
+            return val_tok;
         }
 
-        void handle_value(uint64_t time, fstHandle facidx,
-                          const unsigned char* value, uint32_t len)
+        // Runs on the decoding threads: touches nothing but the captured
+        // entries of `facidx`.
+        void capture_value(uint64_t time, fstHandle facidx,
+                           const unsigned char* value, uint32_t len)
         {
-            if (time < query_t_begin || time > query_t_end) return;
+            if (time < decode_begin || time > decode_end) return;
+            if (facidx + size_t(1) >= handle_offsets.size()) return;
+            uint32_t first = handle_offsets[facidx];
+            if (first == handle_offsets[facidx + 1]) return;
+            const SignalDef& sig = signals[handle_signals[first]];
 
-            auto it = handle_to_sig.find(facidx);
-            if (it == handle_to_sig.end()) return;
-            uint32_t sig_idx = it->second;
-            const SignalDef& sig = signals[sig_idx];
+            int32_t slot = capture_slot[facidx];
+            if (slot >= 0)
+                captured[slot * capture_tiles + (tile_of(time) - step_tile)]
+                    .add(time, value_token(sig, value, len));
+        }
 
-            if (len == 0)
-                len = static_cast<uint32_t>(
-                    std::strlen(reinterpret_cast<const char*>(value)));
+        // --- Value search (find_next) ---
+        // The changes of search_handle in [search_begin, search_end],
+        // decoded on ctx. Masks and time range are set again by every
+        // decode, so a search between two query steps doesn't disturb them.
+        fstHandle search_handle = 0;
+        uint64_t search_begin = 0;
+        uint64_t search_end = 0;
+        BlockCache::Entry search_changes;
+
+        static void search_callback(void* user_data, uint64_t time,
+                                    fstHandle facidx,
+                                    const unsigned char* value)
+        {
+            static_cast<FstParser::Impl*>(user_data)->capture_search(
+                time, facidx, value, 0);
+        }
+
+        static void search_callback_varlen(void* user_data, uint64_t time,
+                                           fstHandle facidx,
+                                           const unsigned char* value,
+                                           uint32_t len)
+        {
+            static_cast<FstParser::Impl*>(user_data)->capture_search(
+                time, facidx, value, len);
+        }
+
+        void capture_search(uint64_t time, fstHandle facidx,
+                            const unsigned char* value, uint32_t len)
+        {
+            if (facidx != search_handle || time < search_begin ||
+                time > search_end)
+                return;
+            const SignalDef& sig =
+                signals[handle_signals[handle_offsets[facidx]]];
+            search_changes.add(time, value_token(sig, value, len));
+        }
+
+        void decode_search(fstHandle handle, uint64_t begin, uint64_t end)
+        {
+            search_changes = BlockCache::Entry();
+            search_handle = handle;
+            search_begin = begin;
+            search_end = end;
+            count_blocks(std::min<uint64_t>(
+                std::max<uint64_t>(1, section_count),
+                (end - begin) / tile_width + 1));
+            fstReaderClrFacProcessMaskAll(ctx);
+            fstReaderSetFacProcessMask(ctx, handle);
+            fstReaderSetLimitTimeRange(ctx, begin, end);
+            fstReaderIterBlocks2(ctx, search_callback, search_callback_varlen,
+                                 this, nullptr);
+        }
+
+        // Value of `idx` at `time` straight from libfst, leaving
+        // known_values to the queries
+        std::string search_value_at(uint32_t idx, uint64_t time)
+        {
+            size_t width = static_cast<size_t>(signals[idx].width);
+            if (width + 1 > val_buf.size()) val_buf.resize(width + 1);
+            count_blocks(1);
+            const char* v = fstReaderGetValueFromHandleAtTime(
+                ctx, time, signal_handle[idx], val_buf.data());
+            if (!v) return {};
+            const unsigned char* u = reinterpret_cast<const unsigned char*>(v);
+            return std::string(
+                value_token(signals[idx], u,
+                            static_cast<uint32_t>(std::strlen(v))));
+        }
+
+        // on_change(time, old_v, new_v) per timestamp in search_changes
+        // until it returns false, `prev` being the value before the first.
+        // A timestamp's last value is the one queries report.
+        template <typename Fn>
+        void for_each_search_change(std::string& prev, Fn&& on_change)
+        {
+            const BlockCache::Entry& c = search_changes;
+            for (size_t i = 0; i < c.size(); ++i)
+            {
+                if (i + 1 < c.size() && c.times[i + 1] == c.times[i]) continue;
+                std::string_view v = c.value(i);
+                bool more = on_change(c.times[i], prev, v);
+                prev.assign(v.data(), v.size());
+                if (!more) return;
+            }
+        }
+
+        // Search windows start about one block wide and double, so a
+        // nearby match costs a block or two and a distant one a
+        // logarithmic number of decodes.
+        static uint64_t next_search_width(uint64_t width)
+        {
+            return width > UINT64_MAX / 2 ? UINT64_MAX : width * 2;
+        }
+
+        SearchResult search_forward(uint32_t idx, const ValueMatcher& matcher,
+                                    uint64_t from)
+        {
+            uint64_t begin = fstReaderGetStartTime(ctx);
+            uint64_t end = fstReaderGetEndTime(ctx);
+            uint64_t start = std::max(from, begin);
+            if (start >= end) return {};
+
+            std::string prev = search_value_at(idx, start);
+            uint64_t width = tile_width;
+            for (uint64_t lo = start + 1;; lo = search_end + 1)
+            {
+                decode_search(signal_handle[idx], lo,
+                              lo + std::min(width - 1, end - lo));
+                SearchResult found;
+                for_each_search_change(
+                    prev,
+                    [&](uint64_t t, std::string_view old_v,
+                        std::string_view new_v)
+                    {
+                        if (matcher.matches(old_v, new_v)) found = {true, t};
+                        return !found.found;
+                    });
+                if (found.found || search_end >= end) return found;
+                width = next_search_width(width);
+            }
+        }
+
+        SearchResult search_backward(uint32_t idx,
+                                     const ValueMatcher& matcher,
+                                     uint64_t from)
+        {
+            uint64_t begin = fstReaderGetStartTime(ctx);
+            uint64_t end = fstReaderGetEndTime(ctx);
+            if (from <= begin) return {};
+            uint64_t hi = std::min(from - 1, end);
+            if (hi <= begin) return {};  // changes at begin never match
+
+            uint64_t width = tile_width;
+            for (;;)
+            {
+                uint64_t lo = hi - std::min(width - 1, hi - (begin + 1));
+                std::string prev = search_value_at(idx, lo - 1);
+                decode_search(signal_handle[idx], lo, hi);
 
+                SearchResult found;
+                for_each_search_change(
+                    prev,
+                    [&](uint64_t t, std::string_view old_v,
+                        std::string_view new_v)
+                    {
+                        if (matcher.matches(old_v, new_v)) found = {true, t};
+                        return true;
+                    });
+                if (found.found || lo == begin + 1) return found;
+                hi = lo - 1;
+                width = next_search_width(width);
+            }
+        }
+
+        // Decode `handles` over [decode_begin, decode_end] into captured
+        void decode(const std::vector<fstHandle>& handles)
+        {
+            size_t workers = std::min<size_t>(query_threads, handles.size());
+#if WAVEFORM_HAVE_THREADS
+            while (worker_ctx.size() + 1 < workers)
+            {
+                fstReaderContext* w = fstReaderOpen(file_path.c_str());
+                if (!w) break;
+                worker_ctx.push_back(w);
+            }
+            workers = std::min(workers, worker_ctx.size() + 1);
+#else
+            workers = 1;
+#endif
+            // Each reader decodes every block of the range
+            count_blocks(workers * uint64_t(capture_tiles));
+            auto run = [&](fstReaderContext* c, size_t w)
+            {
+                fstReaderClrFacProcessMaskAll(c);
+                for (size_t i = w; i < handles.size(); i += workers)
+                    fstReaderSetFacProcessMask(c, handles[i]);
+                fstReaderSetLimitTimeRange(c, decode_begin, decode_end);
+                fstReaderIterBlocks2(c, fst_callback, fst_callback_varlen,
+                                     this, nullptr);
+            };
+#if WAVEFORM_HAVE_THREADS
+            std::vector<std::thread> threads;
+            threads.reserve(workers - 1);
+            for (size_t w = 1; w < workers; ++w)
+                threads.emplace_back(run, worker_ctx[w - 1], w);
+            run(ctx, 0);
+            for (std::thread& t : threads) t.join();
+#else
+            run(ctx, 0);
+#endif
+        }
+
+        // Feed the changes of `handle` in `e` that fall in the window
+        void replay(fstHandle handle, const BlockCache::Entry& e)
+        {
+            for (size_t i = 0; i < e.size(); ++i)
+                if (e.times[i] >= window_begin && e.times[i] <= window_end)
+                    apply_handle(handle, e.times[i], e.value(i));
+        }
+
+        // A change of `handle` applies to every queried signal aliasing it
+        void apply_handle(fstHandle handle, uint64_t time,
+                          std::string_view val_tok)
+        {
+            KnownValue& known = known_values[handle];
+            if (known.open && time > query_t_begin)
+            {
+                known.until = std::max(known.until, time - 1);
+                known.open = false;
+            }
+
+            for (uint32_t i = handle_offsets[handle];
+                 i < handle_offsets[handle + 1]; ++i)
+            {
+                uint32_t sig_idx = handle_signals[i];
+                if (in_query[sig_idx]) apply_value(sig_idx, time, val_tok);
+            }
+        }
+
+        void apply_value(uint32_t sig_idx, uint64_t time,
+                         std::string_view val_tok)
+        {
+            const SignalDef& sig = signals[sig_idx];
+            uint32_t slot = query_slots[sig_idx];
+            ++stats.counts().changes_applied;
             if (sig.width == 1)
             {
                 uint8_t v;
-                uint8_t val_char = value[0];
+                uint8_t val_char = val_tok.empty() ? '0' : val_tok[0];
                 if (val_char == '0')
                     v = 0;
                 else if (val_char == '1')
@@ -83,29 +475,55 @@ namespace vcd
                 else
                     v = 0;
 
-                uint8_t old_v = current_state_1bit[sig_idx];
+                uint8_t old_v = current_state_1bit[slot];
                 lod_manager.process_1bit(time, sig_idx, v, old_v, res_1bit,
                                          last_index_1bit);
-                current_state_1bit[sig_idx] = v;
+                current_state_1bit[slot] = v;
             }
             else
             {
-                std::string val_tok;
-                if (value[0] == 'b' || value[0] == 'B')
-                {
-                    val_tok = std::string(
-                        reinterpret_cast<const char*>(value + 1), len - 1);
-                }
-                else
-                {
-                    val_tok =
-                        std::string(reinterpret_cast<const char*>(value), len);
-                }
-
                 lod_manager.process_multibit(
-                    time, sig_idx, val_tok, current_state_multi[sig_idx],
+                    time, sig_idx, val_tok, current_state_multi.get(slot),
                     res_multi, last_index_multi, string_pool);
-                current_state_multi[sig_idx] = val_tok;
+                current_state_multi.set(slot, val_tok);
+            }
+        }
+
+        // The value of signal `idx` at `time`, from known_values if its
+        // handle's entry covers `time`, otherwise from libfst. Reopens the
+        // entry for this query.
+        const char* value_at(uint32_t idx, uint64_t time,
+                             std::vector<char>& buf)
+        {
+            fstHandle handle = signal_handle[idx];
+            KnownValue& known = known_values[handle];
+            if (known.valid && known.from <= time && time <= known.until)
+            {
+                known.open = true;
+                return known.value.c_str();
+            }
+
+            size_t width = static_cast<size_t>(signals[idx].width);
+            if (width + 1 > buf.size()) buf.resize(width + 1);
+            count_blocks(1);
+            const char* v = fstReaderGetValueFromHandleAtTime(ctx, time, handle,
+                                                              buf.data());
+            known.valid = v != nullptr;
+            known.open = known.valid;
+            known.from = known.until = time;
+            known.value = v ? v : "";
+            return v;
+        }
+
+        // Everything up to window_end has been replayed: handles that
+        // haven't changed yet keep their value at least that long.
+        void extend_known_values()
+        {
+            for (fstHandle h : query_handles)
+            {
+                KnownValue& known = known_values[h];
+                if (known.open)
+                    known.until = std::max(known.until, window_end);
             }
         }
     };
@@ -120,10 +538,25 @@ namespace vcd
 
     bool FstParser::open_file(const std::string& filepath)
     {
+        StatsRecorder::Span span(impl_->stats, ParserPhase::Open);
         close_file();
         impl_->ctx = fstReaderOpen(filepath.c_str());
         if (impl_->ctx)
         {
+            impl_->file_path = filepath;
+            impl_->file_size = file_size_of(filepath);
+            impl_->section_count =
+                fstReaderGetValueChangeSectionCount(impl_->ctx);
+            impl_->dump_begin = fstReaderGetStartTime(impl_->ctx);
+            uint64_t dump_span =
+                fstReaderGetEndTime(impl_->ctx) - impl_->dump_begin;
+            impl_->tile_width =
+                impl_->section_count > 1
+                    ? std::max<uint64_t>(1,
+                                         dump_span / impl_->section_count)
+                    : UINT64_MAX;
+            impl_->last_tile = static_cast<uint32_t>(std::min<uint64_t>(
+                dump_span / impl_->tile_width, UINT32_MAX - 1));
             int ts = fstReaderGetTimescale(impl_->ctx);
             // Simple mapping for now, similar to what was in wasm_bindings.cpp
             if (ts >= -3)
@@ -167,10 +600,22 @@ namespace vcd
             fstReaderClose(impl_->ctx);
             impl_->ctx = nullptr;
         }
+        impl_->close_workers();
+        impl_->file_path.clear();
         impl_->signals.clear();
         impl_->root_scope.reset();
-        impl_->sig_map.clear();
-        impl_->handle_to_sig.clear();
+        impl_->path_index.clear();
+        impl_->names.clear();
+        impl_->handle_offsets.clear();
+        impl_->handle_signals.clear();
+        impl_->signal_handle.clear();
+        impl_->known_values.clear();
+        impl_->query_handles.clear();
+        impl_->in_query.clear();
+        impl_->handle_listed.clear();
+        impl_->query_slots.clear();
+        impl_->block_cache.clear();
+        impl_->query_cache.clear();
     }
 
     void FstParser::begin_indexing() {}
@@ -179,9 +624,9 @@ namespace vcd
     void FstParser::finish_indexing()
     {
         if (!impl_->ctx) return;
+        StatsRecorder::Span span(impl_->stats, ParserPhase::Index);
         impl_->root_scope = std::make_unique<ScopeNode>();
-        impl_->root_scope->name = "__root__";
-        impl_->root_scope->full_path = "";
+        impl_->root_scope->name = impl_->names.intern("__root__");
 
         std::vector<ScopeNode*> stack;
         stack.push_back(impl_->root_scope.get());
@@ -194,13 +639,9 @@ namespace vcd
                 case FST_HT_SCOPE:
                 {
                     auto scope = std::make_unique<ScopeNode>();
-                    scope->name =
-                        std::string(h->u.scope.name, h->u.scope.name_length);
+                    scope->name = impl_->names.intern(std::string_view(
+                        h->u.scope.name, h->u.scope.name_length));
                     scope->parent = stack.back();
-                    scope->full_path =
-                        scope->parent->full_path.empty()
-                            ? scope->name
-                            : scope->parent->full_path + "." + scope->name;
                     ScopeNode* raw_ptr = scope.get();
                     stack.back()->children.push_back(std::move(scope));
                     stack.push_back(raw_ptr);
@@ -213,12 +654,12 @@ namespace vcd
                 }
                 case FST_HT_VAR:
                 {
-                    if (h->u.var.is_alias) break;
+                    // Aliases share their handle's value changes
                     SignalDef sig;
-                    sig.name = std::string(h->u.var.name, h->u.var.name_length);
-                    sig.full_path = stack.back()->full_path + "." + sig.name;
+                    sig.name = impl_->names.intern(
+                        std::string_view(h->u.var.name, h->u.var.name_length));
+                    sig.scope = stack.back();
                     sig.width = h->u.var.length;
-                    sig.id_code = std::to_string(h->u.var.handle);
                     sig.index = static_cast<uint32_t>(impl_->signals.size());
 
                     switch (h->u.var.typ)
@@ -243,14 +684,31 @@ namespace vcd
                             break;
                     }
 
-                    impl_->handle_to_sig[h->u.var.handle] = sig.index;
+                    impl_->signal_handle.push_back(h->u.var.handle);
                     impl_->signals.push_back(std::move(sig));
                     stack.back()->signal_indices.push_back(sig.index);
-                    impl_->sig_map[sig.full_path] = sig.index;
                     break;
                 }
             }
         }
+
+        // Group signals by handle (counting sort keeps declaration order)
+        fstHandle max_handle = 0;
+        for (fstHandle h : impl_->signal_handle)
+            max_handle = std::max(max_handle, h);
+        std::vector<uint32_t>& offsets = impl_->handle_offsets;
+        offsets.assign(size_t(max_handle) + 2, 0);
+        for (fstHandle h : impl_->signal_handle) ++offsets[h + 1];
+        for (size_t h = 1; h < offsets.size(); ++h)
+            offsets[h] += offsets[h - 1];
+        impl_->handle_signals.resize(impl_->signals.size());
+        std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+        for (uint32_t i = 0; i < impl_->signal_handle.size(); ++i)
+            impl_->handle_signals[fill[impl_->signal_handle[i]]++] = i;
+
+        impl_->path_index.build(impl_->root_scope.get(), impl_->signals);
+        impl_->known_values.assign(size_t(max_handle) + 1, {});
+        impl_->capture_slot.assign(size_t(max_handle) + 1, -1);
     }
 
     const Timescale& FstParser::timescale() const
@@ -289,9 +747,8 @@ namespace vcd
     }
     const SignalDef* FstParser::find_signal(const std::string& full_path) const
     {
-        auto it = impl_->sig_map.find(full_path);
-        if (it != impl_->sig_map.end()) return &impl_->signals[it->second];
-        return nullptr;
+        uint32_t idx = impl_->path_index.find(full_path);
+        return idx != PathIndex::NONE ? &impl_->signals[idx] : nullptr;
     }
 
     QueryPlan FstParser::get_query_plan(uint64_t start_time) const
@@ -308,52 +765,97 @@ namespace vcd
                                 size_t snapshot_index, float pixel_time_step)
     {
         if (!impl_->ctx) return;
-        impl_->query_t_begin = start_time;
-        impl_->query_t_end = end_time;
+        StatsRecorder::Span span(impl_->stats, ParserPhase::BeginQuery);
 
-        fstReaderSetLimitTimeRange(impl_->ctx, start_time, end_time);
         fstReaderClrFacProcessMaskAll(impl_->ctx);
 
-        size_t n_sigs = impl_->signals.size();
-        impl_->lod_manager.reset(n_sigs, pixel_time_step);
-        impl_->last_index_1bit.assign(n_sigs, -1);
-        impl_->last_index_multi.assign(n_sigs, -1);
-        impl_->current_state_1bit.assign(n_sigs, 2);  // default 'x'
-        impl_->current_state_multi.assign(n_sigs, "x");
+        Impl& s = *impl_;
+        size_t n_sigs = s.signals.size();
+
+        // Close entries left open by a query that was abandoned midway, and
+        // unmark the previous query's signals and handles
+        for (fstHandle h : s.query_handles)
+        {
+            s.known_values[h].open = false;
+            s.handle_listed[h] = 0;
+        }
+        s.query_handles.clear();
+        for (uint32_t idx : s.query_slots.signals()) s.in_query[idx] = 0;
+        if (s.in_query.size() != n_sigs) s.in_query.assign(n_sigs, 0);
+        if (s.handle_listed.size() != s.known_values.size())
+            s.handle_listed.assign(s.known_values.size(), 0);
+
+        s.query_slots.assign(signal_indices, n_sigs);
+        size_t n_slots = s.query_slots.size();
+        s.lod_manager.reset(s.query_slots, pixel_time_step);
+        s.last_index_1bit.assign(n_slots, -1);
+        s.last_index_multi.assign(n_slots, -1);
+        s.current_state_1bit.assign(n_slots, 2);  // default 'x'
+        s.query_widths.assign(n_slots, 0);
+        for (size_t slot = 0; slot < n_slots; ++slot)
+        {
+            uint32_t width = s.signals[s.query_slots.signals()[slot]].width;
+            if (width > 1) s.query_widths[slot] = width;
+        }
+        s.current_state_multi.assign(s.query_widths, "x");
+
+        s.res_1bit.clear();
+        s.res_multi.clear();
+        s.string_pool.clear();
+        s.results_counted = 0;
+        s.segments.reset();
+        s.query_cancel_flag.store(false);
 
-        impl_->res_1bit.clear();
-        impl_->res_multi.clear();
-        impl_->string_pool.clear();
-        impl_->query_done = false;
+        // Cached results leave one gap to replay
+        QueryCache::Output out{s.res_1bit, s.last_index_1bit, s.res_multi,
+                               s.last_index_multi, s.string_pool,
+                               s.query_slots};
+        std::vector<uint32_t>& replay = s.query_replay;
+        s.query_cache.begin(start_time, end_time, pixel_time_step,
+                            signal_indices, replay, s.query_t_begin,
+                            s.query_t_end, s.lod_manager, out);
+        uint64_t t0 = s.query_t_begin;
+        s.window_begin = t0;
+        s.window_end = t0;
+        s.query_done = replay.empty() || s.query_t_end < t0;
 
-        std::vector<char> val_buf(65536);
-        for (uint32_t idx : signal_indices)
+        // Process masks are set per step, for the handles not cached
+        for (uint32_t idx : replay)
         {
-            if (idx < impl_->signals.size())
+            if (idx < n_sigs && !s.in_query[idx])
             {
-                fstHandle handle = std::stoull(impl_->signals[idx].id_code);
-                fstReaderSetFacProcessMask(impl_->ctx, handle);
-                uint32_t width = impl_->signals[idx].width;
-                if (width + 1 > val_buf.size()) val_buf.resize(width + 1);
-                char* v = fstReaderGetValueFromHandleAtTime(
-                    impl_->ctx, start_time, handle, val_buf.data());
+                s.in_query[idx] = 1;
+                uint32_t slot = s.query_slots[idx];
+                uint32_t width = s.signals[idx].width;
+                fstHandle handle = s.signal_handle[idx];
+                if (!s.handle_listed[handle])
+                {
+                    s.handle_listed[handle] = 1;
+                    s.query_handles.push_back(handle);
+                }
+                // A cached prefix is continued instead, and the changes
+                // from t0 on apply to the value it ends with
+                const char* v = s.value_at(idx, t0, s.val_buf);
                 if (v)
                 {
                     std::string_view val_sv(v);
                     if (width == 1)
                     {
                         uint8_t val = (v[0] == '1') ? 1 : (v[0] == '0' ? 0 : 2);
-                        impl_->lod_manager.emit_initial_1bit(
-                            start_time, idx, val, impl_->res_1bit,
-                            impl_->last_index_1bit);
-                        impl_->current_state_1bit[idx] = val;
+                        if (!s.query_cache.resume_1bit(idx, val, s.lod_manager,
+                                                       out))
+                            s.lod_manager.emit_initial_1bit(
+                                t0, idx, val, s.res_1bit, s.last_index_1bit);
+                        s.current_state_1bit[slot] = val;
                     }
                     else
                     {
-                        impl_->lod_manager.emit_initial_multibit(
-                            start_time, idx, val_sv, impl_->res_multi,
-                            impl_->last_index_multi, impl_->string_pool);
-                        impl_->current_state_multi[idx] = std::string(val_sv);
+                        if (!s.query_cache.resume_multibit(
+                                idx, val_sv, s.lod_manager, out))
+                            s.lod_manager.emit_initial_multibit(
+                                t0, idx, val_sv, s.res_multi,
+                                s.last_index_multi, s.string_pool);
+                        s.current_state_multi.set(slot, val_sv);
                     }
                 }
             }
@@ -363,14 +865,89 @@ namespace vcd
     bool FstParser::query_step(size_t chunk_size)
     {
         if (!impl_->ctx || impl_->query_done) return false;
-        fstReaderIterBlocks2(impl_->ctx, Impl::fst_callback,
-                             Impl::fst_callback_varlen, impl_.get(), nullptr);
-        impl_->query_done = true;
-        return false;
+        if (impl_->query_cancel_flag.load()) return false;
+
+        Impl& s = *impl_;
+        StatsRecorder::Span span(s.stats, ParserPhase::QueryStep);
+
+        // libfst doesn't expose per-block time ranges, so tiles assume
+        // blocks are evenly spread over the file and the dump's time span:
+        // a step covers chunk_size / (file_size / sections) tiles.
+        uint64_t tiles = 1;
+        if (s.section_count > 1)
+            tiles = std::max<uint64_t>(
+                1, chunk_size / std::max<uint64_t>(
+                                    1, s.file_size / s.section_count));
+        uint32_t first = s.tile_of(s.window_begin);
+        uint32_t last = static_cast<uint32_t>(std::min<uint64_t>(
+            s.tile_of(s.query_t_end), first + tiles - 1));
+        s.window_end = std::min(s.query_t_end, s.tile_last(last));
+        s.step_tile = first;
+        s.capture_tiles = last - first + 1;
+
+        // Replay handles cached for every tile of the step; decode the rest
+        std::vector<fstHandle>& misses = s.misses;
+        misses.clear();
+        for (fstHandle h : s.query_handles)
+        {
+            bool cached = true;
+            for (uint32_t k = first; k <= last && cached; ++k)
+                cached = s.block_cache.contains(k, h);
+            if (!cached)
+            {
+                s.block_cache.note_misses(s.capture_tiles);
+                s.capture_slot[h] = static_cast<int32_t>(misses.size());
+                misses.push_back(h);
+                continue;
+            }
+            for (uint32_t k = first; k <= last; ++k)
+                s.replay(h, *s.block_cache.find(k, h));
+        }
+
+        if (!misses.empty())
+        {
+            s.captured.assign(misses.size() * s.capture_tiles, {});
+            s.decode_begin = s.tile_first(first);
+            s.decode_end = s.tile_last(last);
+            s.decode(misses);
+
+            for (size_t m = 0; m < misses.size(); ++m)
+            {
+                fstHandle h = misses[m];
+                for (uint32_t j = 0; j < s.capture_tiles; ++j)
+                {
+                    BlockCache::Entry& e = s.captured[m * s.capture_tiles + j];
+                    s.replay(h, e);
+                    s.block_cache.insert(first + j, h, std::move(e));
+                }
+                s.capture_slot[h] = -1;
+            }
+            s.captured.clear();
+        }
+        s.extend_known_values();
+
+        if (impl_->window_end >= impl_->query_t_end)
+        {
+            impl_->query_done = true;
+            return false;
+        }
+        impl_->window_begin = impl_->window_end + 1;
+        return !impl_->query_cancel_flag.load();
     }
 
     QueryResultBinary FstParser::flush_query_binary()
     {
+        StatsRecorder::Span span(impl_->stats, ParserPhase::Flush);
+
+        // Cached with the glitches still open, so a later query can
+        // continue them
+        if (impl_->query_done && !impl_->query_cancel_flag.load())
+            impl_->query_cache.finish(
+                impl_->lod_manager,
+                {impl_->res_1bit, impl_->last_index_1bit, impl_->res_multi,
+                 impl_->last_index_multi, impl_->string_pool,
+                 impl_->query_slots});
+
         // Flush any open glitches at the end of the query range
         impl_->lod_manager.flush_glitches(
             impl_->res_1bit, impl_->last_index_1bit, impl_->res_multi,
@@ -383,10 +960,116 @@ namespace vcd
         res.count_multibit = impl_->res_multi.size();
         res.string_pool = impl_->string_pool.data();
         res.string_pool_size = impl_->string_pool.size();
+
+        size_t results = res.count_1bit + res.count_multibit;
+        impl_->stats.counts().changes_emitted +=
+            results - impl_->results_counted;
+        impl_->results_counted = results;
         return res;
     }
 
-    void FstParser::cancel_query() { impl_->query_done = true; }
+    QueryResultBinary FstParser::take_query_segment(bool final)
+    {
+        if (final) flush_query_binary();
+        return impl_->segments.take(impl_->query_slots, impl_->res_1bit,
+                                    impl_->last_index_1bit, impl_->res_multi,
+                                    impl_->last_index_multi,
+                                    impl_->string_pool, final);
+    }
+
+    void FstParser::cancel_query() { impl_->query_cancel_flag.store(true); }
+
+    SearchResult FstParser::find_next(uint32_t signal_index,
+                                      const SearchPredicate& predicate,
+                                      uint64_t from_time,
+                                      SearchDirection direction)
+    {
+        if (!impl_->ctx || signal_index >= impl_->signal_handle.size())
+            return {};
+        StatsRecorder::Span span(impl_->stats, ParserPhase::Search);
+
+        ValueMatcher matcher(impl_->signals[signal_index], predicate);
+        if (!matcher.valid())
+        {
+            SearchResult invalid;
+            invalid.invalid_value = true;
+            return invalid;
+        }
+        if (direction == SearchDirection::Forward)
+            return impl_->search_forward(signal_index, matcher, from_time);
+        return impl_->search_backward(signal_index, matcher, from_time);
+    }
+
+    bool FstParser::save_index(const std::string& /*index_path*/) const
+    {
+        return false;
+    }
+    bool FstParser::load_index(const std::string& /*index_path*/)
+    {
+        return false;
+    }
+
+    void FstParser::set_query_threads(unsigned threads)
+    {
+#if WAVEFORM_HAVE_THREADS
+        if (threads == 0) threads = std::thread::hardware_concurrency();
+        impl_->query_threads = std::max(1u, threads);
+#else
+        (void)threads;
+        impl_->query_threads = 1;
+#endif
+    }
+
+    void FstParser::set_block_cache_budget(size_t bytes)
+    {
+        impl_->block_cache.set_budget(bytes);
+    }
+    const BlockCache::Stats& FstParser::block_cache_stats() const
+    {
+        return impl_->block_cache.stats();
+    }
+
+    void FstParser::set_query_cache_budget(size_t bytes)
+    {
+        impl_->query_cache.set_budget(bytes);
+    }
+    const QueryCache::Stats& FstParser::query_cache_stats() const
+    {
+        return impl_->query_cache.stats();
+    }
+
     size_t FstParser::snapshot_count() const { return 0; }
-    size_t FstParser::index_memory_usage() const { return 0; }
+    size_t FstParser::index_memory_usage() const
+    {
+        size_t b = impl_->block_cache.stats().memory_usage +
+                   impl_->known_values.capacity() * sizeof(Impl::KnownValue) +
+                   impl_->names.memory_usage() +
+                   impl_->path_index.memory_usage();
+        for (const Impl::KnownValue& k : impl_->known_values)
+            if (k.value.capacity() > std::string().capacity())
+                b += k.value.capacity() + 1;
+        return b;
+    }
+
+    void FstParser::set_stats_enabled(bool enabled, bool trace)
+    {
+        impl_->stats.enable(enabled, trace);
+        impl_->glitch_base = impl_->lod_manager.glitch_count();
+        impl_->results_counted =
+            impl_->res_1bit.size() + impl_->res_multi.size();
+    }
+
+    ParserStats FstParser::stats() const
+    {
+        ParserStats s = impl_->stats.stats();
+        if (impl_->stats.enabled())
+            s.glitches_collapsed =
+                impl_->lod_manager.glitch_count() - impl_->glitch_base;
+        return s;
+    }
+
+    std::string FstParser::trace_json() const
+    {
+        return impl_->stats.trace_json(stats());
+    }
 }  // namespace vcd
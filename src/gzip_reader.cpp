@@ -0,0 +1,249 @@
+#include "gzip_reader.h"
+
+#include <cstring>
+#include <iterator>
+
+#if !defined(_WIN32)
+#include <sys/types.h>
+#endif
+
+namespace vcd
+{
+
+    namespace
+    {
+        // zlib window bits: raw deflate, or a gzip header first
+        constexpr int RAW_DEFLATE = -15;
+        constexpr int GZIP_STREAM = 15 + 16;
+
+        void seek_to(std::FILE* f, uint64_t offset)
+        {
+#if defined(_WIN32)
+            _fseeki64(f, static_cast<__int64>(offset), SEEK_SET);
+#else
+            fseeko(f, static_cast<off_t>(offset), SEEK_SET);
+#endif
+        }
+    }  // namespace
+
+    GzipReader::~GzipReader() { close(); }
+
+    bool GzipReader::is_gzip(std::FILE* f)
+    {
+        unsigned char magic[2] = {0, 0};
+        size_t n = std::fread(magic, 1, 2, f);
+        seek_to(f, 0);
+        return n == 2 && magic[0] == 0x1f && magic[1] == 0x8b;
+    }
+
+    bool GzipReader::open(std::FILE* f, uint64_t file_size)
+    {
+        close();
+        std::memset(&strm_, 0, sizeof(strm_));
+        if (inflateInit2(&strm_, GZIP_STREAM) != Z_OK) return false;
+        strm_ready_ = true;
+        file_ = f;
+        file_size_ = file_size;
+        input_.resize(INPUT_SIZE);
+        window_.assign(WINDOW_SIZE, 0);
+        return restart(nullptr);
+    }
+
+    void GzipReader::close()
+    {
+        if (strm_ready_) inflateEnd(&strm_);
+        strm_ready_ = false;
+        file_ = nullptr;
+        file_size_ = 0;
+        raw_ = at_end_ = false;
+        in_pos_ = out_pos_ = 0;
+        size_ = UINT64_MAX;
+        input_.clear();
+        input_.shrink_to_fit();
+        window_.clear();
+        window_.shrink_to_fit();
+        skip_.clear();
+        skip_.shrink_to_fit();
+        checkpoints_.clear();
+    }
+
+    bool GzipReader::restart(const Checkpoint* at)
+    {
+        uint64_t in = at ? at->in - (at->bits ? 1 : 0) : 0;
+        seek_to(file_, in);
+        in_pos_ = in;
+        strm_.avail_in = 0;
+        strm_.next_in = input_.data();
+        at_end_ = false;
+
+        if (!at)
+        {
+            out_pos_ = 0;
+            raw_ = false;
+            return inflateReset2(&strm_, GZIP_STREAM) == Z_OK;
+        }
+
+        raw_ = true;
+        out_pos_ = at->out;
+        if (inflateReset2(&strm_, RAW_DEFLATE) != Z_OK) return false;
+        if (at->bits)
+        {
+            int byte = std::fgetc(file_);
+            if (byte == EOF) return false;
+            ++in_pos_;
+            inflatePrime(&strm_, static_cast<int>(at->bits),
+                         byte >> (8 - at->bits));
+        }
+        if (inflateSetDictionary(&strm_, at->window.data(),
+                                 static_cast<uInt>(at->window.size())) !=
+            Z_OK)
+            return false;
+
+        // The ring must match the output before `out` for later checkpoints
+        uint64_t first = at->out - at->window.size();
+        for (size_t i = 0; i < at->window.size(); ++i)
+            window_[(first + i) % WINDOW_SIZE] = at->window[i];
+        return true;
+    }
+
+    bool GzipReader::fill_input()
+    {
+        size_t n = std::fread(input_.data(), 1, input_.size(), file_);
+        strm_.next_in = input_.data();
+        strm_.avail_in = static_cast<uInt>(n);
+        in_pos_ += n;
+        return n > 0;
+    }
+
+    // At the end of a member: skip its trailer when inflate didn't read it
+    // and start on the next member, if there is one.
+    bool GzipReader::next_member()
+    {
+        for (size_t trailer = raw_ ? 8 : 0; trailer > 0;)
+        {
+            if (strm_.avail_in == 0 && !fill_input()) return false;
+            size_t k = std::min<size_t>(trailer, strm_.avail_in);
+            strm_.next_in += k;
+            strm_.avail_in -= static_cast<uInt>(k);
+            trailer -= k;
+        }
+        if (strm_.avail_in == 0 && !fill_input()) return false;
+        if (strm_.next_in[0] != 0x1f) return false;  // trailing garbage
+        raw_ = false;
+        return inflateReset2(&strm_, GZIP_STREAM) == Z_OK;
+    }
+
+    void GzipReader::remember(const uint8_t* data, size_t n)
+    {
+        if (n > WINDOW_SIZE)
+        {
+            data += n - WINDOW_SIZE;
+            out_pos_ += n - WINDOW_SIZE;
+            n = WINDOW_SIZE;
+        }
+        size_t at = static_cast<size_t>(out_pos_ % WINDOW_SIZE);
+        size_t first = std::min(n, WINDOW_SIZE - at);
+        std::memcpy(&window_[at], data, first);
+        std::memcpy(&window_[0], data + first, n - first);
+        out_pos_ += n;
+    }
+
+    void GzipReader::add_checkpoint()
+    {
+        Checkpoint c;
+        c.out = out_pos_;
+        c.in = input_position();
+        c.bits = static_cast<uint32_t>(strm_.data_type & 7);
+        size_t n =
+            static_cast<size_t>(std::min<uint64_t>(out_pos_, WINDOW_SIZE));
+        c.window.resize(n);
+        size_t start = static_cast<size_t>((out_pos_ - n) % WINDOW_SIZE);
+        size_t first = std::min(n, WINDOW_SIZE - start);
+        std::memcpy(c.window.data(), &window_[start], first);
+        std::memcpy(c.window.data() + first, &window_[0], n - first);
+        checkpoints_.push_back(std::move(c));
+    }
+
+    size_t GzipReader::read(uint8_t* buf, size_t n)
+    {
+        size_t got = 0;
+        while (got < n && !at_end_ && file_)
+        {
+            // At the end of the file inflate may still have output pending
+            if (strm_.avail_in == 0) fill_input();
+
+            strm_.next_out = buf + got;
+            strm_.avail_out = static_cast<uInt>(
+                std::min<size_t>(n - got, UINT32_MAX));
+            int ret = inflate(&strm_, Z_BLOCK);
+            size_t produced =
+                static_cast<size_t>(strm_.next_out - (buf + got));
+            remember(buf + got, produced);
+            got += produced;
+
+            if (ret == Z_STREAM_END)
+            {
+                if (!next_member())
+                {
+                    at_end_ = true;
+                    size_ = out_pos_;
+                }
+            }
+            else if (ret == Z_BUF_ERROR && produced == 0)
+            {
+                at_end_ = true;  // truncated: keep what was decoded
+            }
+            else if (ret != Z_OK && ret != Z_BUF_ERROR)
+            {
+                at_end_ = true;  // corrupt data
+            }
+            else if ((strm_.data_type & 128) && !(strm_.data_type & 64))
+            {
+                // Block boundary, not in the member's last block. Only
+                // the frontier adds checkpoints, which keeps them ordered.
+                uint64_t last =
+                    checkpoints_.empty() ? 0 : checkpoints_.back().out;
+                if (out_pos_ > last && out_pos_ - last >= span_)
+                    add_checkpoint();
+            }
+        }
+        return got;
+    }
+
+    bool GzipReader::seek(uint64_t offset)
+    {
+        if (!file_) return false;
+        if (size_known() && offset > size_) return false;
+
+        // Restart at the last checkpoint at or before `offset` unless
+        // reading on from here is closer
+        auto it = std::upper_bound(
+            checkpoints_.begin(), checkpoints_.end(), offset,
+            [](uint64_t o, const Checkpoint& c) { return o < c.out; });
+        const Checkpoint* at =
+            it == checkpoints_.begin() ? nullptr : &*std::prev(it);
+        uint64_t from = at ? at->out : 0;
+        if (offset < out_pos_ || from > out_pos_ || at_end_)
+        {
+            if (!restart(at)) return false;
+        }
+
+        skip_.resize(INPUT_SIZE);
+        while (out_pos_ < offset)
+        {
+            size_t want = static_cast<size_t>(
+                std::min<uint64_t>(offset - out_pos_, skip_.size()));
+            if (read(skip_.data(), want) == 0) return false;
+        }
+        return true;
+    }
+
+    size_t GzipReader::memory_usage() const
+    {
+        size_t b = input_.capacity() + window_.capacity() + skip_.capacity() +
+                   checkpoints_.capacity() * sizeof(Checkpoint);
+        for (const Checkpoint& c : checkpoints_) b += c.window.capacity();
+        return b;
+    }
+
+}  // namespace vcd
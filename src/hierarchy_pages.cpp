@@ -0,0 +1,163 @@
+#include "hierarchy_pages.h"
+
+#include <algorithm>
+#include <string_view>
+#include <unordered_map>
+
+namespace vcd
+{
+
+    void HierarchyPages::build(const ScopeNode* root,
+                               const std::vector<SignalDef>& signals)
+    {
+        clear();
+        if (!root) return;
+        signals_ = &signals;
+
+        // Names are keyed by views into the tree and signal table, which
+        // outlive the build
+        std::unordered_map<std::string_view, uint32_t> ids;
+        auto intern = [&](std::string_view name)
+        {
+            auto it = ids.find(name);
+            if (it != ids.end()) return it->second;
+            uint32_t id = static_cast<uint32_t>(name_ends_.size());
+            names_.append(name);
+            name_ends_.push_back(static_cast<uint32_t>(names_.size()));
+            ids.emplace(name, id);
+            return id;
+        };
+
+        // Breadth-first, so every scope's children are consecutive
+        Scope top;
+        top.name = intern(root->name);
+        top.node = root;
+        scopes_.push_back(top);
+        for (size_t i = 0; i < scopes_.size(); ++i)
+        {
+            const ScopeNode* node = scopes_[i].node;
+            scopes_[i].first_child = static_cast<uint32_t>(scopes_.size());
+            scopes_[i].child_count =
+                static_cast<uint32_t>(node->children.size());
+            for (const auto& child : node->children)
+            {
+                Scope s;
+                s.parent = static_cast<uint32_t>(i);
+                s.name = intern(child->name);
+                s.node = child.get();
+                scopes_.push_back(s);
+            }
+        }
+
+        // Children come after their parent, so a reverse pass sums totals
+        for (size_t i = scopes_.size(); i-- > 0;)
+        {
+            Scope& s = scopes_[i];
+            s.total_signals +=
+                static_cast<uint32_t>(s.node->signal_indices.size());
+            if (s.parent != NONE)
+                scopes_[s.parent].total_signals += s.total_signals;
+        }
+
+        signal_names_.resize(signals.size());
+        for (size_t i = 0; i < signals.size(); ++i)
+            signal_names_[i] = intern(signals[i].name);
+    }
+
+    void HierarchyPages::clear()
+    {
+        scopes_.clear();
+        signal_names_.clear();
+        signals_ = nullptr;
+        names_.clear();
+        name_ends_.clear();
+        out_.clear();
+    }
+
+    void HierarchyPages::put_u32(uint32_t v)
+    {
+        for (int i = 0; i < 4; ++i)
+            out_.push_back(static_cast<uint8_t>(v >> (8 * i)));
+    }
+
+    const std::vector<uint8_t>& HierarchyPages::scope_page(
+        uint32_t scope, uint32_t child_offset, uint32_t child_limit,
+        uint32_t signal_offset, uint32_t signal_limit)
+    {
+        out_.clear();
+        if (scope >= scopes_.size()) return out_;
+        const Scope& s = scopes_[scope];
+        const std::vector<uint32_t>& sigs = s.node->signal_indices;
+        uint32_t signal_count = static_cast<uint32_t>(sigs.size());
+
+        child_offset = std::min(child_offset, s.child_count);
+        uint32_t children =
+            std::min(child_limit, s.child_count - child_offset);
+        signal_offset = std::min(signal_offset, signal_count);
+        uint32_t in_page =
+            std::min(signal_limit, signal_count - signal_offset);
+
+        out_.reserve(SCOPE_HEADER_SIZE + children * CHILD_ENTRY_SIZE +
+                     in_page * SIGNAL_ENTRY_SIZE);
+        put_u32(scope);
+        put_u32(s.parent);
+        put_u32(s.name);
+        put_u32(s.child_count);
+        put_u32(signal_count);
+        put_u32(s.total_signals);
+        put_u32(child_offset);
+        put_u32(children);
+        put_u32(signal_offset);
+        put_u32(in_page);
+
+        for (uint32_t i = 0; i < children; ++i)
+        {
+            uint32_t c = s.first_child + child_offset + i;
+            const Scope& child = scopes_[c];
+            put_u32(c);
+            put_u32(child.name);
+            put_u32(child.child_count);
+            put_u32(
+                static_cast<uint32_t>(child.node->signal_indices.size()));
+            put_u32(child.total_signals);
+        }
+
+        for (uint32_t i = 0; i < in_page; ++i)
+        {
+            uint32_t idx = sigs[signal_offset + i];
+            put_u32(idx);
+            if (idx >= signal_names_.size())
+            {
+                out_.insert(out_.end(), SIGNAL_ENTRY_SIZE - 4, 0);
+                continue;
+            }
+            const SignalDef& def = (*signals_)[idx];
+            put_u32(signal_names_[idx]);
+            put_u32(static_cast<uint32_t>(def.width));
+            put_u32(static_cast<uint32_t>(def.type));
+            put_u32(static_cast<uint32_t>(def.msb));
+            put_u32(static_cast<uint32_t>(def.lsb));
+        }
+        return out_;
+    }
+
+    const std::vector<uint8_t>& HierarchyPages::name_page(uint32_t first,
+                                                          uint32_t count)
+    {
+        out_.clear();
+        uint32_t total = static_cast<uint32_t>(name_ends_.size());
+        first = std::min(first, total);
+        count = std::min(count, total - first);
+
+        uint32_t begin = first ? name_ends_[first - 1] : 0;
+        uint32_t end = count ? name_ends_[first + count - 1] : begin;
+        out_.reserve(4 * (count + 2) + (end - begin));
+        put_u32(count);
+        put_u32(0);
+        for (uint32_t i = 0; i < count; ++i)
+            put_u32(name_ends_[first + i] - begin);
+        out_.insert(out_.end(), names_.begin() + begin, names_.begin() + end);
+        return out_;
+    }
+
+}  // namespace vcd
@@ -0,0 +1,173 @@
+#include "id_table.h"
+
+#include <algorithm>
+#include <numeric>
+
+namespace vcd
+{
+
+    void IdTable::clear()
+    {
+        direct_ = true;
+        entries_.clear();
+        aliases_.clear();
+        seeds_.clear();
+        key_offsets_.clear();
+        keys_.clear();
+    }
+
+    void IdTable::build(const std::vector<SignalDef>& signals)
+    {
+        clear();
+
+        // Group the signals by id; aliases_ holds each group contiguously.
+        aliases_.resize(signals.size());
+        std::iota(aliases_.begin(), aliases_.end(), 0u);
+        std::stable_sort(aliases_.begin(), aliases_.end(),
+                         [&](uint32_t a, uint32_t b)
+                         { return signals[a].id_code < signals[b].id_code; });
+
+        std::vector<std::string_view> ids;
+        std::vector<Entry> groups;
+        for (uint32_t i = 0; i < aliases_.size(); ++i)
+        {
+            std::string_view id = signals[aliases_[i]].id_code;
+            if (ids.empty() || ids.back() != id)
+            {
+                ids.push_back(id);
+                groups.push_back({i, 0});
+            }
+            groups.back().count++;
+        }
+
+        // Direct indexing needs every id in the printable code space; allow
+        // three-character ids only when they fill a good part of it.
+        size_t max_len = 0;
+        bool printable = true;
+        for (std::string_view id : ids)
+        {
+            max_len = std::max(max_len, id.size());
+            printable = printable && direct_code(id) != SIZE_MAX;
+        }
+        size_t space = 0;
+        for (size_t l = 0, span = RADIX; l < max_len; ++l, span *= RADIX)
+            space += span;
+        direct_ = printable && (max_len <= 2 || space <= 8 * ids.size());
+
+        if (direct_)
+        {
+            entries_.assign(ids.empty() ? 0 : space, Entry{});
+            for (size_t i = 0; i < ids.size(); ++i)
+                entries_[direct_code(ids[i])] = groups[i];
+            return;
+        }
+
+        std::vector<size_t> slots = build_hashed(ids);
+        std::vector<std::string_view> slot_keys(entries_.size());
+        for (size_t i = 0; i < ids.size(); ++i)
+        {
+            entries_[slots[i]] = groups[i];
+            slot_keys[slots[i]] = ids[i];
+        }
+        key_offsets_.reserve(entries_.size() + 1);
+        for (std::string_view key : slot_keys)
+        {
+            key_offsets_.push_back(static_cast<uint32_t>(keys_.size()));
+            keys_.append(key);
+        }
+        key_offsets_.push_back(static_cast<uint32_t>(keys_.size()));
+    }
+
+    std::vector<size_t> IdTable::build_hashed(
+        const std::vector<std::string_view>& ids)
+    {
+        const size_t n = ids.size();
+        std::vector<uint64_t> hashes(n);
+        for (size_t i = 0; i < n; ++i) hashes[i] = hash(ids[i]);
+
+        // Hash and displace: about two ids per bucket; the largest buckets
+        // search for a seed placing all their ids in free slots, singletons
+        // then take the remaining slots directly. A bucket that finds no
+        // seed (vanishingly rare) restarts with a slightly larger table.
+        size_t m = n;
+        for (;;)
+        {
+            // Bucket members, flat: bucket b is members[start[b], start[b+1])
+            const size_t r = std::max<size_t>(1, n / 2);
+            std::vector<uint32_t> start(r + 1, 0);
+            for (uint32_t i = 0; i < n; ++i)
+                start[reduce(hashes[i] >> 32, r) + 1]++;
+            std::partial_sum(start.begin(), start.end(), start.begin());
+            std::vector<uint32_t> members(n);
+            std::vector<uint32_t> fill(start.begin(), start.end() - 1);
+            for (uint32_t i = 0; i < n; ++i)
+                members[fill[reduce(hashes[i] >> 32, r)]++] = i;
+            auto size_of = [&](uint32_t b) { return start[b + 1] - start[b]; };
+
+            std::vector<uint32_t> order(r);
+            std::iota(order.begin(), order.end(), 0u);
+            std::stable_sort(order.begin(), order.end(),
+                             [&](uint32_t a, uint32_t b)
+                             { return size_of(a) > size_of(b); });
+
+            seeds_.assign(r, 0);
+            std::vector<size_t> slots(n);
+            std::vector<bool> taken(m, false);
+            size_t free_slot = 0;
+            bool placed = true;
+            for (uint32_t b : order)
+            {
+                const uint32_t* bucket = members.data() + start[b];
+                const size_t count = size_of(b);
+                if (count == 0) break;
+                if (count == 1)
+                {
+                    while (taken[free_slot]) ++free_slot;
+                    taken[free_slot] = true;
+                    slots[bucket[0]] = free_slot;
+                    seeds_[b] = SINGLE_SLOT | static_cast<uint32_t>(free_slot);
+                    continue;
+                }
+
+                placed = false;
+                for (uint32_t seed = 0; seed < (1u << 20) && !placed; ++seed)
+                {
+                    size_t k = 0;
+                    for (; k < count; ++k)
+                    {
+                        size_t s = reduce(mix(hashes[bucket[k]], seed), m);
+                        if (taken[s]) break;
+                        taken[s] = true;
+                        slots[bucket[k]] = s;
+                    }
+                    if (k == count)
+                    {
+                        seeds_[b] = seed;
+                        placed = true;
+                    }
+                    else
+                    {
+                        while (k-- > 0) taken[slots[bucket[k]]] = false;
+                    }
+                }
+                if (!placed) break;
+            }
+            if (placed)
+            {
+                entries_.assign(m, Entry{});
+                return slots;
+            }
+            m += m / 16 + 1;
+        }
+    }
+
+    size_t IdTable::memory_usage() const
+    {
+        return entries_.capacity() * sizeof(Entry) +
+               (aliases_.capacity() + seeds_.capacity() +
+                key_offsets_.capacity()) *
+                   sizeof(uint32_t) +
+               keys_.capacity();
+    }
+
+}  // namespace vcd
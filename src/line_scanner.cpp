@@ -0,0 +1,75 @@
+#include "line_scanner.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__wasm_simd128__)
+#include <wasm_simd128.h>
+#endif
+
+namespace vcd
+{
+
+    void LineScanner::scan(std::string_view buf)
+    {
+        const unsigned char* p =
+            reinterpret_cast<const unsigned char*>(buf.data());
+        const size_t n = buf.size();
+        data_ = buf.data();
+        size_ = n;
+        newline_.assign((n + 63) / 64, 0);
+        blank_.assign(newline_.size(), 0);
+
+        size_t i = 0;
+#if defined(__AVX2__)
+        const __m256i nl = _mm256_set1_epi8('\n');
+        const __m256i sp = _mm256_set1_epi8(' ');
+        for (; i + 32 <= n; i += 32)
+        {
+            __m256i v =
+                _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+            // Unsigned v <= ' ' is min(v, ' ') == v
+            uint64_t is_nl = static_cast<uint32_t>(
+                _mm256_movemask_epi8(_mm256_cmpeq_epi8(v, nl)));
+            uint64_t is_blank = static_cast<uint32_t>(_mm256_movemask_epi8(
+                _mm256_cmpeq_epi8(_mm256_min_epu8(v, sp), v)));
+            newline_[i / 64] |= is_nl << (i % 64);
+            blank_[i / 64] |= is_blank << (i % 64);
+        }
+#elif defined(__SSE2__)
+        const __m128i nl = _mm_set1_epi8('\n');
+        const __m128i sp = _mm_set1_epi8(' ');
+        for (; i + 16 <= n; i += 16)
+        {
+            __m128i v =
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+            // Unsigned v <= ' ' is min(v, ' ') == v
+            uint64_t is_nl = static_cast<uint32_t>(
+                _mm_movemask_epi8(_mm_cmpeq_epi8(v, nl)));
+            uint64_t is_blank = static_cast<uint32_t>(
+                _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_min_epu8(v, sp), v)));
+            newline_[i / 64] |= is_nl << (i % 64);
+            blank_[i / 64] |= is_blank << (i % 64);
+        }
+#elif defined(__wasm_simd128__)
+        const v128_t nl = wasm_i8x16_splat('\n');
+        const v128_t sp = wasm_i8x16_splat(' ');
+        for (; i + 16 <= n; i += 16)
+        {
+            v128_t v = wasm_v128_load(p + i);
+            uint64_t is_nl = wasm_i8x16_bitmask(wasm_i8x16_eq(v, nl));
+            uint64_t is_blank = wasm_i8x16_bitmask(wasm_u8x16_le(v, sp));
+            newline_[i / 64] |= is_nl << (i % 64);
+            blank_[i / 64] |= is_blank << (i % 64);
+        }
+#endif
+        for (; i < n; ++i)
+        {
+            uint64_t bit = uint64_t(1) << (i % 64);
+            if (p[i] == '\n') newline_[i / 64] |= bit;
+            if (p[i] <= ' ') blank_[i / 64] |= bit;
+        }
+    }
+
+}  // namespace vcd
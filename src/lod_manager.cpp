@@ -5,21 +5,24 @@
 namespace vcd
 {
 
-    void LodManager::reset(size_t signal_count, float pixel_time_step)
+    void LodManager::reset(const SignalSlots& slots, float pixel_time_step)
     {
+        // assign() keeps capacity, so a query no larger than the previous
+        // one allocates nothing here
+        size_t n = slots.size();
+        slots_ = &slots;
         pixel_time_step_ = pixel_time_step;
-        last_emitted_time_.assign(signal_count,
-                                  std::numeric_limits<uint64_t>::max());
-        signal_is_glitch_.assign(signal_count, false);
+        last_emitted_time_.assign(n, std::numeric_limits<uint64_t>::max());
+        signal_is_glitch_.assign(n, false);
+        start_changed_.assign(n, false);
 
-        last_transition_time_.assign(signal_count,
-                                     std::numeric_limits<uint64_t>::max());
-        last_value_1bit_.assign(signal_count, 0);
-        last_value_multi_offset_.assign(signal_count, 0);
-        last_value_multi_length_.assign(signal_count, 0);
+        last_transition_time_.assign(n, std::numeric_limits<uint64_t>::max());
+        last_value_1bit_.assign(n, 0);
+        last_value_multi_offset_.assign(n, 0);
+        last_value_multi_length_.assign(n, 0);
 
-        glitch_end_multi_offset_.assign(signal_count, 0);
-        glitch_end_multi_length_.assign(signal_count, 0);
+        glitch_end_multi_offset_.assign(n, 0);
+        glitch_end_multi_length_.assign(n, 0);
 
         glitch_string_offset_ = static_cast<uint32_t>(-1);
     }
@@ -29,73 +32,76 @@ namespace vcd
                                   std::vector<Transition1Bit>& res_1bit,
                                   std::vector<int64_t>& last_index_1bit)
     {
-        if (current_time == last_emitted_time_[sig_idx])
+        uint32_t s = (*slots_)[sig_idx];
+        if (current_time == last_emitted_time_[s])
         {
             // Same timestamp: just update the value of the existing transition
-            int64_t last_idx = last_index_1bit[sig_idx];
+            if (current_time == start_time_ && v != old_v)
+                start_changed_[s] = true;
+            int64_t last_idx = last_index_1bit[s];
             if (last_idx >= 0)
             {
                 res_1bit[last_idx].value = v;
             }
         }
         else if (pixel_time_step_ > 0.0f &&
-                 last_transition_time_[sig_idx] !=
+                 last_transition_time_[s] !=
                      std::numeric_limits<uint64_t>::max() &&
-                 (current_time - last_transition_time_[sig_idx]) <
+                 (current_time - last_transition_time_[s]) <
                      static_cast<uint64_t>(pixel_time_step_))
         {
             // Glitch detected: mark the PREVIOUS transition as GLITCH if value
             // changed
-            if (v != old_v && !signal_is_glitch_[sig_idx])
+            if (v != old_v && !signal_is_glitch_[s])
             {
-                int64_t last_idx = last_index_1bit[sig_idx];
+                int64_t last_idx = last_index_1bit[s];
                 if (last_idx >= 0)
                 {
                     res_1bit[last_idx].value = 4;  // GLITCH
                 }
-                signal_is_glitch_[sig_idx] = true;
+                signal_is_glitch_[s] = true;
+                ++glitch_count_;
             }
         }
-        else if (v != old_v || signal_is_glitch_[sig_idx])
+        else if (v != old_v || signal_is_glitch_[s])
         {
             // Close the glitch at the last known transition time,
             // if we are currently glitching.
-            if (signal_is_glitch_[sig_idx])
+            if (signal_is_glitch_[s])
             {
-                last_index_1bit[sig_idx] =
-                    static_cast<int64_t>(res_1bit.size());
-                res_1bit.push_back({last_transition_time_[sig_idx],
-                                    sig_idx,
-                                    old_v,
-                                    {0, 0, 0}});
-                last_emitted_time_[sig_idx] = last_transition_time_[sig_idx];
-                signal_is_glitch_[sig_idx] = false;
+                last_index_1bit[s] = static_cast<int64_t>(res_1bit.size());
+                res_1bit.push_back(
+                    {last_transition_time_[s], sig_idx, old_v, {0, 0, 0}});
+                last_emitted_time_[s] = last_transition_time_[s];
+                signal_is_glitch_[s] = false;
             }
 
             // Only append the new transition if the value actually changed
             if (v != old_v)
             {
-                last_index_1bit[sig_idx] =
-                    static_cast<int64_t>(res_1bit.size());
+                last_index_1bit[s] = static_cast<int64_t>(res_1bit.size());
                 res_1bit.push_back({current_time, sig_idx, v, {0, 0, 0}});
-                last_emitted_time_[sig_idx] = current_time;
+                last_emitted_time_[s] = current_time;
             }
         }
 
         // Always track the actual transition time and value
-        last_transition_time_[sig_idx] = current_time;
-        last_value_1bit_[sig_idx] = v;
+        last_transition_time_[s] = current_time;
+        last_value_1bit_[s] = v;
     }
 
     void LodManager::process_multibit(
         uint64_t current_time, uint32_t sig_idx, std::string_view val_tok,
-        const std::string& old_v, std::vector<TransitionMultiBit>& res_multibit,
+        std::string_view old_v, std::vector<TransitionMultiBit>& res_multibit,
         std::vector<int64_t>& last_index_multi, std::string& query_string_pool)
     {
-        if (current_time == last_emitted_time_[sig_idx])
+        uint32_t s = (*slots_)[sig_idx];
+        if (current_time == last_emitted_time_[s])
         {
             // Same timestamp: update existing transition in multi-bit
-            int64_t last_idx = last_index_multi[sig_idx];
+            if (current_time == start_time_ && val_tok != old_v)
+                start_changed_[s] = true;
+            int64_t last_idx = last_index_multi[s];
             if (last_idx >= 0)
             {
                 uint32_t offset =
@@ -105,19 +111,19 @@ namespace vcd
                 res_multibit[last_idx].string_length =
                     static_cast<uint32_t>(val_tok.size());
                 // Keep shadow in sync with the updated transition
-                last_value_multi_offset_[sig_idx] = offset;
-                last_value_multi_length_[sig_idx] =
+                last_value_multi_offset_[s] = offset;
+                last_value_multi_length_[s] =
                     static_cast<uint32_t>(val_tok.size());
             }
         }
         else if (pixel_time_step_ > 0.0f &&
-                 last_transition_time_[sig_idx] !=
+                 last_transition_time_[s] !=
                      std::numeric_limits<uint64_t>::max() &&
-                 (current_time - last_transition_time_[sig_idx]) <
+                 (current_time - last_transition_time_[s]) <
                      static_cast<uint64_t>(pixel_time_step_))
         {
             // Glitch detected for multi-bit
-            if (val_tok != old_v && !signal_is_glitch_[sig_idx])
+            if (val_tok != old_v && !signal_is_glitch_[s])
             {
                 if (glitch_string_offset_ == static_cast<uint32_t>(-1))
                 {
@@ -127,12 +133,12 @@ namespace vcd
                 }
                 // Push GLITCH as a NEW transition instead of overwriting
                 // the previous one.
-                last_index_multi[sig_idx] =
-                    static_cast<int64_t>(res_multibit.size());
-                res_multibit.push_back({last_transition_time_[sig_idx], sig_idx,
+                last_index_multi[s] = static_cast<int64_t>(res_multibit.size());
+                res_multibit.push_back({last_transition_time_[s], sig_idx,
                                         glitch_string_offset_, 6, 0});
-                last_emitted_time_[sig_idx] = last_transition_time_[sig_idx];
-                signal_is_glitch_[sig_idx] = true;
+                last_emitted_time_[s] = last_transition_time_[s];
+                signal_is_glitch_[s] = true;
+                ++glitch_count_;
             }
 
             // Track the actual current value during the glitch so the
@@ -144,33 +150,30 @@ namespace vcd
                 uint32_t offset =
                     static_cast<uint32_t>(query_string_pool.size());
                 query_string_pool.append(val_tok);
-                glitch_end_multi_offset_[sig_idx] = offset;
-                glitch_end_multi_length_[sig_idx] =
+                glitch_end_multi_offset_[s] = offset;
+                glitch_end_multi_length_[s] =
                     static_cast<uint32_t>(val_tok.size());
             }
         }
-        else if (val_tok != old_v || signal_is_glitch_[sig_idx])
+        else if (val_tok != old_v || signal_is_glitch_[s])
         {
             // Close the glitch at the last known transition time,
             // if we are currently glitching.
-            if (signal_is_glitch_[sig_idx])
+            if (signal_is_glitch_[s])
             {
                 // Use the actual last value seen during the glitch
                 // (glitch_end_*), NOT the pre-glitch shadow
                 // (last_value_multi_*).
-                last_index_multi[sig_idx] =
-                    static_cast<int64_t>(res_multibit.size());
-                res_multibit.push_back({last_transition_time_[sig_idx], sig_idx,
-                                        glitch_end_multi_offset_[sig_idx],
-                                        glitch_end_multi_length_[sig_idx], 0});
-                last_emitted_time_[sig_idx] = last_transition_time_[sig_idx];
-                signal_is_glitch_[sig_idx] = false;
+                last_index_multi[s] = static_cast<int64_t>(res_multibit.size());
+                res_multibit.push_back({last_transition_time_[s], sig_idx,
+                                        glitch_end_multi_offset_[s],
+                                        glitch_end_multi_length_[s], 0});
+                last_emitted_time_[s] = last_transition_time_[s];
+                signal_is_glitch_[s] = false;
 
                 // Update the shadow to the glitch-end value
-                last_value_multi_offset_[sig_idx] =
-                    glitch_end_multi_offset_[sig_idx];
-                last_value_multi_length_[sig_idx] =
-                    glitch_end_multi_length_[sig_idx];
+                last_value_multi_offset_[s] = glitch_end_multi_offset_[s];
+                last_value_multi_length_[s] = glitch_end_multi_length_[s];
             }
 
             // Only append the new transition if the value actually changed
@@ -179,22 +182,21 @@ namespace vcd
                 uint32_t offset =
                     static_cast<uint32_t>(query_string_pool.size());
                 query_string_pool.append(val_tok);
-                last_index_multi[sig_idx] =
-                    static_cast<int64_t>(res_multibit.size());
+                last_index_multi[s] = static_cast<int64_t>(res_multibit.size());
                 res_multibit.push_back({current_time, sig_idx, offset,
                                         static_cast<uint32_t>(val_tok.size()),
                                         0});
 
                 // Track the shadow value offsets
-                last_value_multi_offset_[sig_idx] = offset;
-                last_value_multi_length_[sig_idx] =
+                last_value_multi_offset_[s] = offset;
+                last_value_multi_length_[s] =
                     static_cast<uint32_t>(val_tok.size());
-                last_emitted_time_[sig_idx] = current_time;
+                last_emitted_time_[s] = current_time;
             }
         }
 
         // Always track the actual transition time
-        last_transition_time_[sig_idx] = current_time;
+        last_transition_time_[s] = current_time;
     }
 
     void LodManager::emit_initial_1bit(uint64_t start_time, uint32_t sig_idx,
@@ -202,12 +204,14 @@ namespace vcd
                                        std::vector<Transition1Bit>& res_1bit,
                                        std::vector<int64_t>& last_index_1bit)
     {
-        last_index_1bit[sig_idx] = static_cast<int64_t>(res_1bit.size());
+        uint32_t s = (*slots_)[sig_idx];
+        last_index_1bit[s] = static_cast<int64_t>(res_1bit.size());
         res_1bit.push_back({start_time, sig_idx, v, {0, 0, 0}});
-        last_emitted_time_[sig_idx] = start_time;
-        last_transition_time_[sig_idx] = start_time;
-        last_value_1bit_[sig_idx] = v;
-        signal_is_glitch_[sig_idx] = false;
+        start_time_ = start_time;
+        last_emitted_time_[s] = start_time;
+        last_transition_time_[s] = start_time;
+        last_value_1bit_[s] = v;
+        signal_is_glitch_[s] = false;
     }
 
     void LodManager::emit_initial_multibit(
@@ -215,17 +219,77 @@ namespace vcd
         std::vector<TransitionMultiBit>& res_multibit,
         std::vector<int64_t>& last_index_multi, std::string& query_string_pool)
     {
+        uint32_t s = (*slots_)[sig_idx];
         uint32_t offset = static_cast<uint32_t>(query_string_pool.size());
         query_string_pool.append(sv);
-        last_index_multi[sig_idx] = static_cast<int64_t>(res_multibit.size());
+        last_index_multi[s] = static_cast<int64_t>(res_multibit.size());
         res_multibit.push_back(
             {start_time, sig_idx, offset, static_cast<uint32_t>(sv.size()), 0});
 
-        last_emitted_time_[sig_idx] = start_time;
-        last_transition_time_[sig_idx] = start_time;
-        last_value_multi_offset_[sig_idx] = offset;
-        last_value_multi_length_[sig_idx] = static_cast<uint32_t>(sv.size());
-        signal_is_glitch_[sig_idx] = false;
+        start_time_ = start_time;
+        last_emitted_time_[s] = start_time;
+        last_transition_time_[s] = start_time;
+        last_value_multi_offset_[s] = offset;
+        last_value_multi_length_[s] = static_cast<uint32_t>(sv.size());
+        signal_is_glitch_[s] = false;
+    }
+
+    void LodManager::resume_1bit(uint64_t last_time, uint32_t sig_idx,
+                                 uint8_t v)
+    {
+        uint32_t s = (*slots_)[sig_idx];
+        last_emitted_time_[s] = last_time;
+        last_transition_time_[s] = last_time;
+        last_value_1bit_[s] = v;
+        signal_is_glitch_[s] = false;
+    }
+
+    void LodManager::resume_multibit(uint64_t last_time, uint32_t sig_idx,
+                                     uint32_t offset, uint32_t length)
+    {
+        uint32_t s = (*slots_)[sig_idx];
+        last_emitted_time_[s] = last_time;
+        last_transition_time_[s] = last_time;
+        last_value_multi_offset_[s] = offset;
+        last_value_multi_length_[s] = length;
+        signal_is_glitch_[s] = false;
+    }
+
+    LodManager::SignalState LodManager::save(
+        uint32_t sig_idx, std::string_view query_string_pool) const
+    {
+        uint32_t s = (*slots_)[sig_idx];
+        SignalState state;
+        state.last_emitted_time = last_emitted_time_[s];
+        state.last_transition_time = last_transition_time_[s];
+        state.glitch = signal_is_glitch_[s];
+        state.value_1bit = last_value_1bit_[s];
+        state.value_multi = query_string_pool.substr(
+            last_value_multi_offset_[s], last_value_multi_length_[s]);
+        state.glitch_end_multi = query_string_pool.substr(
+            glitch_end_multi_offset_[s], glitch_end_multi_length_[s]);
+        return state;
+    }
+
+    void LodManager::restore(uint32_t sig_idx, const SignalState& state,
+                             std::string& query_string_pool)
+    {
+        uint32_t s = (*slots_)[sig_idx];
+        last_emitted_time_[s] = state.last_emitted_time;
+        last_transition_time_[s] = state.last_transition_time;
+        signal_is_glitch_[s] = state.glitch;
+        last_value_1bit_[s] = state.value_1bit;
+
+        last_value_multi_offset_[s] =
+            static_cast<uint32_t>(query_string_pool.size());
+        last_value_multi_length_[s] =
+            static_cast<uint32_t>(state.value_multi.size());
+        query_string_pool.append(state.value_multi);
+        glitch_end_multi_offset_[s] =
+            static_cast<uint32_t>(query_string_pool.size());
+        glitch_end_multi_length_[s] =
+            static_cast<uint32_t>(state.glitch_end_multi.size());
+        query_string_pool.append(state.glitch_end_multi);
     }
 
     void LodManager::flush_glitches(
@@ -234,36 +298,31 @@ namespace vcd
         std::vector<TransitionMultiBit>& res_multibit,
         std::vector<int64_t>& last_index_multi, std::string& query_string_pool)
     {
-        for (size_t sig_idx = 0; sig_idx < signal_is_glitch_.size(); ++sig_idx)
+        for (size_t s = 0; s < signal_is_glitch_.size(); ++s)
         {
-            if (signal_is_glitch_[sig_idx])
+            if (signal_is_glitch_[s])
             {
-                if (sig_idx < last_value_1bit_.size() &&
-                    last_index_1bit[sig_idx] != -1)
+                uint32_t sig_idx = slots_->signals()[s];
+                if (last_index_1bit[s] != -1)
                 {
                     // 1-bit signal
-                    last_index_1bit[sig_idx] =
-                        static_cast<int64_t>(res_1bit.size());
-                    res_1bit.push_back({last_transition_time_[sig_idx],
-                                        static_cast<uint32_t>(sig_idx),
-                                        last_value_1bit_[sig_idx],
-                                        {0, 0, 0}});
+                    last_index_1bit[s] = static_cast<int64_t>(res_1bit.size());
+                    res_1bit.push_back({last_transition_time_[s], sig_idx,
+                                        last_value_1bit_[s], {0, 0, 0}});
                 }
-                else if (sig_idx < glitch_end_multi_offset_.size() &&
-                         last_index_multi[sig_idx] != -1)
+                else if (last_index_multi[s] != -1)
                 {
                     // Multi-bit signal: use glitch-end value (actual
                     // current value), not the pre-glitch shadow
-                    last_index_multi[sig_idx] =
+                    last_index_multi[s] =
                         static_cast<int64_t>(res_multibit.size());
-                    res_multibit.push_back({last_transition_time_[sig_idx],
-                                            static_cast<uint32_t>(sig_idx),
-                                            glitch_end_multi_offset_[sig_idx],
-                                            glitch_end_multi_length_[sig_idx],
-                                            0});
+                    res_multibit.push_back(
+                        {last_transition_time_[s], sig_idx,
+                         glitch_end_multi_offset_[s],
+                         glitch_end_multi_length_[s], 0});
                 }
-                signal_is_glitch_[sig_idx] = false;
-                last_emitted_time_[sig_idx] = last_transition_time_[sig_idx];
+                signal_is_glitch_[s] = false;
+                last_emitted_time_[s] = last_transition_time_[s];
             }
         }
     }
@@ -0,0 +1,90 @@
+#include "lod_pyramid.h"
+
+namespace vcd
+{
+
+    void LodPyramid::begin(uint64_t t_begin, uint64_t t_end,
+                           uint32_t initial_value)
+    {
+        origin_ = t_begin;
+        uint64_t span = t_end > t_begin ? t_end - t_begin : 0;
+        base_shift_ = 0;
+        while ((span >> base_shift_) >= MAX_FINE_BUCKETS) ++base_shift_;
+        initial_value_ = initial_value;
+        ready_ = false;
+        levels_.assign(1, {});
+    }
+
+    void LodPyramid::add(uint64_t time, uint32_t value)
+    {
+        time = std::max(time, origin_);
+        std::vector<Bucket>& fine = levels_.front();
+        if (!fine.empty() &&
+            bucket_of(fine.back(), 0) == ((time - origin_) >> base_shift_))
+        {
+            Bucket& last = fine.back();
+            if (time != last.last_time)
+            {
+                last.last_time = time;
+                last.count++;
+            }
+            last.value = value;
+            return;
+        }
+        fine.push_back({time, time, 1, value});
+    }
+
+    void LodPyramid::finish()
+    {
+        // Halve the resolution until a level fits in one bucket.
+        while (levels_.back().size() > 1 &&
+               base_shift_ + levels_.size() < 64)
+        {
+            const std::vector<Bucket>& prev = levels_.back();
+            size_t level = levels_.size();
+            std::vector<Bucket> next;
+            next.reserve(prev.size() / 2 + 1);
+            for (const Bucket& b : prev)
+            {
+                if (!next.empty() &&
+                    bucket_of(next.back(), level) == bucket_of(b, level))
+                {
+                    Bucket& merged = next.back();
+                    merged.last_time = b.last_time;
+                    merged.count += b.count;
+                    merged.value = b.value;
+                }
+                else
+                {
+                    next.push_back(b);
+                }
+            }
+            levels_.push_back(std::move(next));
+        }
+        for (auto& level : levels_) level.shrink_to_fit();
+        ready_ = true;
+    }
+
+    int LodPyramid::level_for(float pixel_time_step) const
+    {
+        if (!ready_ || pixel_time_step <= 0.0f) return -1;
+        auto width = [&](size_t level)
+        { return static_cast<double>(uint64_t(1) << (base_shift_ + level)); };
+        if (width(0) > pixel_time_step) return -1;
+
+        size_t level = 0;
+        while (level + 1 < levels_.size() &&
+               width(level + 1) <= pixel_time_step)
+            ++level;
+        return static_cast<int>(level);
+    }
+
+    size_t LodPyramid::memory_usage() const
+    {
+        size_t bytes = 0;
+        for (const auto& level : levels_)
+            bytes += level.size() * sizeof(Bucket);
+        return bytes;
+    }
+
+}  // namespace vcd
@@ -6,6 +6,7 @@
 #include <chrono>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <string>
 #include <vector>
@@ -37,14 +38,16 @@ static void print_scope(const vcd::ScopeNode* node, int depth,
                         const std::vector<vcd::SignalDef>& sigs)
 {
     for (int i = 0; i < depth; ++i) std::printf("  ");
-    std::printf("[scope] %s\n", node->name.c_str());
+    std::printf("[scope] %.*s\n", (int)node->name.size(), node->name.data());
 
     for (auto idx : node->signal_indices)
     {
         for (int i = 0; i < depth + 1; ++i) std::printf("  ");
-        std::printf("[signal] %s  (id=%s, width=%d, index=%u)\n",
-                    sigs[idx].name.c_str(), sigs[idx].id_code.c_str(),
-                    sigs[idx].width, sigs[idx].index);
+        const auto& sig = sigs[idx];
+        std::printf("[signal] %.*s  (id=%.*s, width=%d, index=%u)\n",
+                    (int)sig.name.size(), sig.name.data(),
+                    (int)sig.id_code.size(), sig.id_code.data(), sig.width,
+                    sig.index);
     }
 
     for (auto& child : node->children)
@@ -55,11 +58,54 @@ static void print_scope(const vcd::ScopeNode* node, int depth,
 
 int main(int argc, char* argv[])
 {
+    // Strip options so the positional arguments keep their indices.
+    //   -j <threads>      index the data section in parallel (0 = all cores)
+    //   --no-index-cache  ignore and don't write the <file>.wvidx sidecar
+    //   --transition-index  record per-signal change intervals so sparse
+    //                       queries skip intervals without changes
+    //   --snapshot-budget <mb>  cap the memory held by snapshots
+    unsigned index_threads = 1;
+    vcd::SnapshotPolicy snapshot_policy;
+    bool use_index_cache = true;
+    bool transition_index = false;
+    std::vector<char*> args;
+    for (int i = 0; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "-j") == 0 && i + 1 < argc)
+        {
+            index_threads =
+                static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+            continue;
+        }
+        if (std::strcmp(argv[i], "--no-index-cache") == 0)
+        {
+            use_index_cache = false;
+            continue;
+        }
+        if (std::strcmp(argv[i], "--transition-index") == 0)
+        {
+            transition_index = true;
+            continue;
+        }
+        if (std::strcmp(argv[i], "--snapshot-budget") == 0 && i + 1 < argc)
+        {
+            snapshot_policy.memory_budget =
+                std::strtoull(argv[++i], nullptr, 10) * 1024 * 1024;
+            continue;
+        }
+        args.push_back(argv[i]);
+    }
+    argc = static_cast<int>(args.size());
+    args.push_back(nullptr);
+    argv = args.data();
+
     if (argc < 2)
     {
         std::fprintf(stderr,
-                     "Usage: %s <file.vcd> [chunk_size_mb] [t_begin t_end "
-                     "signal_path...]\n",
+                     "Usage: %s [-j threads] [--no-index-cache] "
+                     "[--transition-index] [--snapshot-budget mb] "
+                     "<file.vcd> [chunk_size_mb] "
+                     "[t_begin t_end signal_path...]\n",
                      argv[0]);
         return 1;
     }
@@ -120,21 +166,37 @@ int main(int argc, char* argv[])
                      filepath);
         return 1;
     }
+    parser.set_index_threads(index_threads);
+    parser.set_transition_index(transition_index);
+    parser.set_snapshot_policy(snapshot_policy);
 
     // =====================================================================
     // Phase 1: Indexing
     //   Read the entire file in chunks, build the signal hierarchy, and
-    //   create sparse snapshots every ~10 MB.
+    //   create sparse snapshots every ~10 MB. With -j, each step hands one
+    //   chunk per thread to the index workers. A valid <file>.wvidx sidecar
+    //   from a previous run replaces the whole pass.
     // =====================================================================
+    const std::string index_path = path_str + ".wvidx";
     auto t0 = std::chrono::high_resolution_clock::now();
-    parser.begin_indexing();
-
-    while (parser.index_step(chunk_size_bytes) > 0)
+    bool index_cached = use_index_cache && parser.load_index(index_path);
+    if (!index_cached)
     {
-        // Keep stepping until EOF
-    }
+        parser.begin_indexing();
 
-    parser.finish_indexing();
+        while (parser.index_step(chunk_size_bytes) > 0)
+        {
+            // Keep stepping until EOF
+        }
+
+        parser.finish_indexing();
+        if (use_index_cache && parser.is_open() &&
+            !parser.save_index(index_path))
+        {
+            std::fprintf(stderr, "Warning: could not write index %s\n",
+                         index_path.c_str());
+        }
+    }
 
     auto t1 = std::chrono::high_resolution_clock::now();
     double parse_ms =
@@ -152,7 +214,8 @@ int main(int argc, char* argv[])
         std::printf("File size:        %lu bytes\n",
                     (unsigned long)file_total_size);
     }
-    std::printf("Index time:       %.2f ms\n", parse_ms);
+    std::printf("Index time:       %.2f ms%s\n", parse_ms,
+                index_cached ? " (loaded from sidecar)" : "");
     std::printf("Date:             %s\n", parser.date().c_str());
     std::printf("Version:          %s\n", parser.version().c_str());
     std::printf("Timescale:        %d%s\n", parser.timescale().magnitude,
@@ -239,7 +302,7 @@ int main(int argc, char* argv[])
                      : (tr.value == 2) ? 'x'
                                        : 'z';
             std::printf("    t=%lu  %s = %c\n", (unsigned long)tr.timestamp,
-                        sig.full_path.c_str(), v);
+                        sig.full_path().c_str(), v);
         }
 
         std::printf("  Multi-bit items: %zu\n", res.count_multibit);
@@ -250,7 +313,8 @@ int main(int argc, char* argv[])
             std::string_view sval(res.string_pool + tr.string_offset,
                                   tr.string_length);
             std::printf("    t=%lu  %s = %.*s\n", (unsigned long)tr.timestamp,
-                        sig.full_path.c_str(), (int)sval.size(), sval.data());
+                        sig.full_path().c_str(), (int)sval.size(),
+                        sval.data());
         }
     }
 
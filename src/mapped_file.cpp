@@ -0,0 +1,127 @@
+#include "mapped_file.h"
+
+#include <algorithm>
+#include <utility>
+
+#if (defined(__unix__) || defined(__APPLE__)) && !defined(__EMSCRIPTEN__)
+#define WAVEFORM_HAVE_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#define WAVEFORM_HAVE_MMAP 0
+#endif
+
+namespace vcd
+{
+
+#if WAVEFORM_HAVE_MMAP
+    namespace
+    {
+        // madvise wants a page-aligned start address.
+        void advise_range(const char* base, uint64_t size, uint64_t offset,
+                          uint64_t length, int advice)
+        {
+            if (!base || offset >= size) return;
+            length = std::min(length, size - offset);
+            static const uint64_t page =
+                static_cast<uint64_t>(::sysconf(_SC_PAGESIZE));
+            uint64_t aligned = offset - (offset % page);
+            ::madvise(const_cast<char*>(base) + aligned,
+                      static_cast<size_t>(length + (offset - aligned)),
+                      advice);
+        }
+    }  // namespace
+#endif
+
+    MappedFile::~MappedFile() { unmap(); }
+
+    MappedFile::MappedFile(MappedFile&& other) noexcept
+        : data_(std::exchange(other.data_, nullptr)),
+          size_(std::exchange(other.size_, 0))
+    {
+    }
+
+    MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+    {
+        if (this != &other)
+        {
+            unmap();
+            data_ = std::exchange(other.data_, nullptr);
+            size_ = std::exchange(other.size_, 0);
+        }
+        return *this;
+    }
+
+    bool MappedFile::map(const std::string& path)
+    {
+        unmap();
+#if WAVEFORM_HAVE_MMAP
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+
+        struct stat st;
+        if (::fstat(fd, &st) != 0 || st.st_size <= 0)
+        {
+            ::close(fd);
+            return false;
+        }
+
+        void* p = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ,
+                         MAP_PRIVATE, fd, 0);
+        // The mapping keeps its own reference to the file.
+        ::close(fd);
+        if (p == MAP_FAILED) return false;
+
+        data_ = static_cast<const char*>(p);
+        size_ = static_cast<uint64_t>(st.st_size);
+        return true;
+#else
+        (void)path;
+        return false;
+#endif
+    }
+
+    void MappedFile::unmap()
+    {
+#if WAVEFORM_HAVE_MMAP
+        if (data_)
+            ::munmap(const_cast<char*>(data_), static_cast<size_t>(size_));
+#endif
+        data_ = nullptr;
+        size_ = 0;
+    }
+
+    std::string_view MappedFile::view(uint64_t offset, uint64_t length) const
+    {
+        if (!data_ || offset >= size_) return {};
+        length = std::min(length, size_ - offset);
+        return std::string_view(data_ + offset, static_cast<size_t>(length));
+    }
+
+    void MappedFile::advise_sequential() const
+    {
+#if WAVEFORM_HAVE_MMAP
+        advise_range(data_, size_, 0, size_, MADV_SEQUENTIAL);
+#endif
+    }
+
+    void MappedFile::advise_random() const
+    {
+#if WAVEFORM_HAVE_MMAP
+        advise_range(data_, size_, 0, size_, MADV_RANDOM);
+#endif
+    }
+
+    void MappedFile::will_need(uint64_t offset, uint64_t length) const
+    {
+#if WAVEFORM_HAVE_MMAP
+        advise_range(data_, size_, offset, length, MADV_WILLNEED);
+#else
+        (void)offset;
+        (void)length;
+#endif
+    }
+
+}  // namespace vcd
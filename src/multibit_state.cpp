@@ -0,0 +1,48 @@
+#include "multibit_state.h"
+
+#include <algorithm>
+
+namespace vcd
+{
+
+    void MultibitState::assign(const std::vector<uint32_t>& capacities,
+                               std::string_view initial)
+    {
+        size_t n = capacities.size();
+        offset_.resize(n);
+        capacity_.resize(n);
+        length_.resize(n);
+
+        uint64_t total = 0;
+        for (size_t s = 0; s < n; ++s)
+        {
+            offset_[s] = total;
+            capacity_[s] = std::max<uint32_t>(
+                capacities[s], static_cast<uint32_t>(initial.size()));
+            total += capacity_[s];
+        }
+        arena_.assign(static_cast<size_t>(total), 0);
+        arena_.shrink_to_fit();
+        for (size_t s = 0; s < n; ++s) set(s, initial);
+    }
+
+    void MultibitState::clear()
+    {
+        arena_.clear();
+        offset_.clear();
+        capacity_.clear();
+        length_.clear();
+    }
+
+    void MultibitState::grow(size_t slot, size_t needed)
+    {
+        // The old region is abandoned; overflows are rare enough (values
+        // wider than their declaration) that compaction isn't worth it.
+        uint32_t cap = static_cast<uint32_t>(
+            std::max<size_t>(needed, size_t(capacity_[slot]) * 2));
+        offset_[slot] = arena_.size();
+        capacity_[slot] = cap;
+        arena_.resize(arena_.size() + cap);
+    }
+
+}  // namespace vcd
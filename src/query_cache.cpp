@@ -0,0 +1,526 @@
+#include "query_cache.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+
+namespace vcd
+{
+
+    namespace
+    {
+        // Whether [.., a_end] and [b_begin, ..] overlap or are adjacent
+        bool touches(uint64_t a_end, uint64_t b_begin)
+        {
+            return a_end >= b_begin || a_end + 1 == b_begin;
+        }
+    }  // namespace
+
+    void QueryCache::set_budget(size_t bytes)
+    {
+        budget_ = bytes;
+        evict();
+    }
+
+    void QueryCache::clear()
+    {
+        intervals_.clear();
+        order_.clear();
+        stats_ = {};
+        splices_.clear();
+        splice_of_.clear();
+        finished_ = true;
+    }
+
+    void QueryCache::truncate(uint64_t time)
+    {
+        // Intervals are disjoint, so only a key's last one can reach `time`
+        std::vector<uint64_t> keys;
+        for (const auto& [k, ivs] : intervals_)
+            if (!ivs.empty() && std::prev(ivs.end())->second.end >= time)
+                keys.push_back(k);
+
+        for (uint64_t k : keys)
+        {
+            Intervals& ivs = intervals_[k];
+            auto it = std::prev(ivs.end());
+            if (reduced(k))
+            {
+                // A reduced run can't be cut short (see begin())
+                erase(k, it);
+                if (ivs.empty()) intervals_.erase(k);
+                continue;
+            }
+            uint64_t begin = it->first;
+            const Records& r = it->second.records;
+            uint64_t cut = std::min(time, r.size() ? r.times.back() : begin);
+            Records kept;
+            if (cut > begin) slice(r, begin, cut - 1, kept);
+            erase(k, it);
+            if (kept.size())
+                insert(k, begin, cut - 1, std::move(kept));
+            else if (ivs.empty())
+                intervals_.erase(k);
+        }
+    }
+
+    uint64_t QueryCache::key(uint32_t signal, float pixel_time_step)
+    {
+        // Every step <= 0 means "no reduction", so they share results
+        if (!(pixel_time_step > 0.0f)) pixel_time_step = -1.0f;
+        uint32_t bits;
+        std::memcpy(&bits, &pixel_time_step, sizeof(bits));
+        return (static_cast<uint64_t>(signal) << 32) | bits;
+    }
+
+    bool QueryCache::reduced(uint64_t key)
+    {
+        return static_cast<uint32_t>(key) !=
+               static_cast<uint32_t>(QueryCache::key(0, -1.0f));
+    }
+
+    QueryCache::Interval* QueryCache::find(uint64_t key, uint64_t time,
+                                           uint64_t* begin)
+    {
+        auto m = intervals_.find(key);
+        if (m == intervals_.end()) return nullptr;
+        auto it = m->second.upper_bound(time);
+        if (it == m->second.begin()) return nullptr;
+        --it;
+        if (it->second.end < time) return nullptr;
+        *begin = it->first;
+        return &it->second;
+    }
+
+    void QueryCache::slice(const Records& r, uint64_t begin, uint64_t end,
+                           Records& into)
+    {
+        into.multibit = r.multibit;
+        auto from = std::lower_bound(r.times.begin(), r.times.end(), begin);
+        size_t i = static_cast<size_t>(from - r.times.begin());
+        if (i < r.size() && r.times[i] == begin)
+            into.first_changes = i > 0 || r.first_changes;
+        else if (i > 0)
+            into.add(begin, r.value(i - 1));
+        for (; i < r.size() && r.times[i] <= end; ++i)
+            into.add(r.times[i], r.value(i));
+    }
+
+    size_t QueryCache::append(const Records& r, uint32_t signal, Output out)
+    {
+        size_t last = 0;
+        for (size_t i = 0; i < r.size(); ++i)
+        {
+            std::string_view v = r.value(i);
+            if (r.multibit)
+            {
+                uint32_t offset =
+                    static_cast<uint32_t>(out.string_pool.size());
+                out.string_pool.append(v);
+                last = out.res_multibit.size();
+                out.res_multibit.push_back({r.times[i], signal, offset,
+                                            static_cast<uint32_t>(v.size()),
+                                            0});
+            }
+            else
+            {
+                last = out.res_1bit.size();
+                out.res_1bit.push_back({r.times[i], signal,
+                                        static_cast<uint8_t>(v[0]),
+                                        {0, 0, 0}});
+            }
+        }
+        return last;
+    }
+
+    void QueryCache::begin(uint64_t begin, uint64_t end, float pixel_time_step,
+                           const std::vector<uint32_t>& signals,
+                           std::vector<uint32_t>& replay,
+                           uint64_t& replay_begin, uint64_t& replay_end,
+                           LodManager& lod, Output out)
+    {
+        splices_.clear();
+        splice_of_.assign(out.slots.size(), SignalSlots::NONE);
+        replay_begin = begin;
+        replay_end = end;
+        // A signal listed twice gets its records twice, which a cached
+        // interval can't reproduce
+        finished_ = budget_ == 0 || end < begin || !out.slots.unique();
+        if (finished_)
+        {
+            replay = signals;
+            return;
+        }
+        query_begin_ = begin;
+        query_end_ = end;
+        query_px_key_ = key(0, pixel_time_step);
+        reduced_ = reduced(query_px_key_);
+
+        // Serve the signals held inside one interval; for the others, find
+        // the cached intervals holding either end of the window
+        ends_.clear();
+        uint64_t g0 = UINT64_MAX, g1 = 0;
+        replay.clear();
+        for (uint32_t sig : signals)
+        {
+            uint32_t slot = out.slots[sig];
+            if (slot == SignalSlots::NONE)
+            {
+                // Not a signal of this file: nothing to cache or splice
+                replay.push_back(sig);
+                continue;
+            }
+
+            uint64_t k = query_px_key_ | (static_cast<uint64_t>(sig) << 32);
+            uint64_t head_begin = 0, tail_begin = 0;
+            Ends e;
+            e.head = find(k, begin, &head_begin);
+            e.tail = find(k, end, &tail_begin);
+            if (reduced_)
+            {
+                // Only a run started at `begin` and not past `end` matches
+                // this query's records so far
+                if (e.head && (head_begin != begin || e.head->end > end))
+                    e.head = nullptr;
+                e.tail = e.head && e.head->end == end ? e.head : nullptr;
+            }
+            if (e.head && e.head == e.tail)
+            {
+                slice_.clear();
+                slice(e.head->records, begin, end, slice_);
+                size_t last = append(slice_, sig, out);
+                if (reduced_)
+                {
+                    // Its open glitch is flushed with the replayed ones
+                    lod.restore(sig, e.head->state, out.string_pool);
+                    (slice_.multibit ? out.last_index_multi
+                                     : out.last_index_1bit)[slot] =
+                        static_cast<int64_t>(last);
+                }
+                touch(*e.head);
+                ++stats_.hits;
+                continue;
+            }
+
+            g0 = std::min(g0, e.head ? e.head->end + 1 : begin);
+            g1 = std::max(g1, e.tail ? tail_begin - 1 : end);
+            splice_of_[slot] = static_cast<uint32_t>(splices_.size());
+            Splice s;
+            s.signal = sig;
+            s.slot = slot;
+            splices_.push_back(std::move(s));
+            ends_.push_back(e);
+            replay.push_back(sig);
+        }
+        if (splices_.empty()) return;
+
+        // A reduced prefix can't be cut, so every one must end where the
+        // gap begins
+        if (reduced_)
+            for (const Ends& e : ends_)
+                if (e.head && e.head->end + 1 != g0) g0 = begin;
+
+        // Replay the gap every remaining signal needs; cached records on
+        // either side of it are spliced in
+        replay_begin = g0;
+        replay_end = g1;
+        for (size_t i = 0; i < splices_.size(); ++i)
+        {
+            Splice& s = splices_[i];
+            const Ends& e = ends_[i];
+            bool partial = false;
+            if (e.head && g0 > begin)
+            {
+                slice_.clear();
+                slice(e.head->records, begin, g0 - 1, slice_);
+                s.multibit = slice_.multibit;
+                s.prefix_first_changes = slice_.first_changes;
+                if (reduced_) s.state = e.head->state;
+                s.prefix_last =
+                    static_cast<int64_t>(append(slice_, s.signal, out));
+                // Held back from segments until the replay continues it
+                (s.multibit ? out.last_index_multi
+                            : out.last_index_1bit)[s.slot] = s.prefix_last;
+                touch(*e.head);
+                partial = true;
+            }
+            if (e.tail && g1 < end)
+            {
+                slice(e.tail->records, g1 + 1, end, s.suffix);
+                s.multibit = s.suffix.multibit;
+                touch(*e.tail);
+                partial = true;
+            }
+            ++(partial ? stats_.partial_hits : stats_.misses);
+        }
+    }
+
+    bool QueryCache::resume_1bit(uint32_t sig, uint8_t& v, LodManager& lod,
+                                 Output out)
+    {
+        uint32_t slot = out.slots[sig];
+        if (slot >= splice_of_.size() || splice_of_[slot] == SignalSlots::NONE)
+            return false;
+        const Splice& s = splices_[splice_of_[slot]];
+        int64_t last = s.prefix_last;
+        if (last < 0) return false;
+        if (reduced_)
+        {
+            lod.restore(sig, s.state, out.string_pool);
+            v = s.state.value_1bit;
+        }
+        else
+        {
+            v = out.res_1bit[last].value;
+            lod.resume_1bit(out.res_1bit[last].timestamp, sig, v);
+        }
+        out.last_index_1bit[slot] = last;
+        return true;
+    }
+
+    bool QueryCache::resume_multibit(uint32_t sig, std::string_view& v,
+                                     LodManager& lod, Output out)
+    {
+        uint32_t slot = out.slots[sig];
+        if (slot >= splice_of_.size() || splice_of_[slot] == SignalSlots::NONE)
+            return false;
+        const Splice& s = splices_[splice_of_[slot]];
+        int64_t last = s.prefix_last;
+        if (last < 0) return false;
+        if (reduced_)
+        {
+            lod.restore(sig, s.state, out.string_pool);
+            // The latest value, which a glitch doesn't emit
+            v = s.state.glitch ? s.state.glitch_end_multi
+                               : s.state.value_multi;
+        }
+        else
+        {
+            const TransitionMultiBit& t = out.res_multibit[last];
+            v = std::string_view(out.string_pool)
+                    .substr(t.string_offset, t.string_length);
+            lod.resume_multibit(t.timestamp, sig, t.string_offset,
+                                t.string_length);
+        }
+        out.last_index_multi[slot] = last;
+        return true;
+    }
+
+    void QueryCache::finish(const LodManager& lod, Output out)
+    {
+        if (finished_) return;
+        finished_ = true;
+
+        // Cached suffixes, minus a first record restating the replay's end
+        // (one that is a change of its own is kept, even if two changes at
+        // that time left the value as it was)
+        for (Splice& s : splices_)
+        {
+            if (!s.suffix.size()) continue;
+            size_t from = 0;
+            if (s.suffix.first_changes)
+                ;
+            else if (s.multibit)
+            {
+                int64_t last = out.last_index_multi[s.slot];
+                if (last >= 0)
+                {
+                    const TransitionMultiBit& t = out.res_multibit[last];
+                    if (std::string_view(out.string_pool)
+                            .substr(t.string_offset, t.string_length) ==
+                        s.suffix.value(0))
+                        from = 1;
+                }
+            }
+            else
+            {
+                int64_t last = out.last_index_1bit[s.slot];
+                if (last >= 0 &&
+                    out.res_1bit[last].value ==
+                        static_cast<uint8_t>(s.suffix.value(0)[0]))
+                    from = 1;
+            }
+            Records rest;
+            rest.multibit = s.multibit;
+            for (size_t i = from; i < s.suffix.size(); ++i)
+                rest.add(s.suffix.times[i], s.suffix.value(i));
+            size_t at = append(rest, s.signal, out);
+            if (rest.size())
+                (s.multibit ? out.last_index_multi
+                            : out.last_index_1bit)[s.slot] =
+                    static_cast<int64_t>(at);
+            s.suffix = {};
+        }
+
+        // Every replayed signal's records now cover the whole window
+        std::vector<Records> records(splices_.size());
+        auto splice_of = [&](uint32_t sig)
+        {
+            uint32_t slot = out.slots[sig];
+            return slot < splice_of_.size() ? splice_of_[slot]
+                                            : SignalSlots::NONE;
+        };
+        for (const Transition1Bit& t : out.res_1bit)
+        {
+            uint32_t i = splice_of(t.signal_index);
+            if (i == SignalSlots::NONE) continue;
+            char v = static_cast<char>(t.value);
+            records[i].add(t.timestamp, std::string_view(&v, 1));
+        }
+        std::string_view pool(out.string_pool);
+        for (const TransitionMultiBit& t : out.res_multibit)
+        {
+            uint32_t i = splice_of(t.signal_index);
+            if (i == SignalSlots::NONE) continue;
+            records[i].multibit = true;
+            records[i].add(t.timestamp,
+                           pool.substr(t.string_offset, t.string_length));
+        }
+
+        for (size_t i = 0; i < splices_.size(); ++i)
+        {
+            const Splice& s = splices_[i];
+            Records& r = records[i];
+            if (!r.size() || r.times.front() != query_begin_ ||
+                !std::is_sorted(r.times.begin(), r.times.end()))
+                continue;
+            r.first_changes = s.prefix_last >= 0
+                                  ? s.prefix_first_changes
+                                  : lod.changed_at_start(s.signal);
+            LodManager::SignalState state;
+            if (reduced_) state = lod.save(s.signal, out.string_pool);
+            uint64_t k = query_px_key_ | (static_cast<uint64_t>(s.signal)
+                                          << 32);
+            insert(k, query_begin_, query_end_, std::move(r),
+                   std::move(state));
+        }
+        splices_.clear();
+        splice_of_.clear();
+        evict();
+    }
+
+    void QueryCache::touch(Interval& iv)
+    {
+        order_.splice(order_.begin(), order_, iv.position);
+    }
+
+    void QueryCache::insert(uint64_t key, uint64_t begin, uint64_t end,
+                            Records&& records,
+                            LodManager::SignalState&& state)
+    {
+        Intervals& ivs = intervals_[key];
+        if (reduced(key))
+        {
+            // Runs can't be joined: drop the ones overlapping this one
+            auto it = ivs.upper_bound(begin);
+            if (it != ivs.begin() && std::prev(it)->second.end >= begin)
+                --it;
+            while (it != ivs.end() && it->first <= end) erase(key, it++);
+            store(key, begin, end, std::move(records), std::move(state));
+            return;
+        }
+
+        // The intervals overlapping or touching [begin, end]
+        auto first = ivs.upper_bound(begin);
+        if (first != ivs.begin() &&
+            touches(std::prev(first)->second.end, begin))
+            --first;
+        auto last = first;
+        while (last != ivs.end() && touches(end, last->first)) ++last;
+
+        Records merged;
+        merged.multibit = records.multibit;
+        merged.first_changes = records.first_changes;
+        uint64_t merged_begin = begin, merged_end = end;
+        // A piece's first record is dropped if it only restates the value
+        // the previous piece ends with
+        auto add_from = [&merged](const Records& r)
+        {
+            size_t i = 0;
+            if (!r.first_changes && r.size() && merged.size() &&
+                merged.value(merged.size() - 1) == r.value(0))
+                ++i;
+            for (; i < r.size(); ++i) merged.add(r.times[i], r.value(i));
+        };
+
+        if (first != last && first->first < begin)
+        {
+            merged_begin = first->first;
+            const Records& r = first->second.records;
+            merged.first_changes = r.first_changes;
+            for (size_t i = 0; i < r.size() && r.times[i] < begin; ++i)
+                merged.add(r.times[i], r.value(i));
+        }
+        add_from(records);
+        if (first != last && std::prev(last)->second.end > end)
+        {
+            const Interval& tail = std::prev(last)->second;
+            merged_end = tail.end;
+            Records r;
+            slice(tail.records, end + 1, tail.end, r);
+            add_from(r);
+        }
+        while (first != last) erase(key, first++);
+
+        store(key, merged_begin, merged_end, std::move(merged), {});
+    }
+
+    void QueryCache::store(uint64_t key, uint64_t begin, uint64_t end,
+                           Records&& records, LodManager::SignalState&& state)
+    {
+        Intervals& ivs = intervals_[key];
+        records.times.shrink_to_fit();
+        records.value_ends.shrink_to_fit();
+        records.values.shrink_to_fit();
+        size_t bytes = bytes_of(records, state);
+        if (bytes > budget_)
+        {
+            if (ivs.empty()) intervals_.erase(key);
+            return;
+        }
+
+        order_.emplace_front(key, begin);
+        Interval& iv = ivs[begin];
+        iv.end = end;
+        iv.records = std::move(records);
+        iv.state = std::move(state);
+        iv.bytes = bytes;
+        iv.position = order_.begin();
+        stats_.memory_usage += bytes;
+        ++stats_.entries;
+    }
+
+    void QueryCache::erase(uint64_t key, Intervals::iterator it)
+    {
+        stats_.memory_usage -= it->second.bytes;
+        order_.erase(it->second.position);
+        intervals_[key].erase(it);
+        --stats_.entries;
+    }
+
+    void QueryCache::evict()
+    {
+        while (stats_.memory_usage > budget_ && !order_.empty())
+        {
+            auto [k, begin] = order_.back();
+            auto m = intervals_.find(k);
+            erase(k, m->second.find(begin));
+            if (m->second.empty()) intervals_.erase(m);
+        }
+    }
+
+    size_t QueryCache::bytes_of(const Records& r,
+                                const LodManager::SignalState& state)
+    {
+        // Record data, plus the map node and list node holding it
+        size_t b = r.times.capacity() * sizeof(uint64_t) +
+                   r.value_ends.capacity() * sizeof(uint32_t) +
+                   sizeof(Interval) + 6 * sizeof(void*) + 3 * sizeof(uint64_t);
+        for (const std::string* s :
+             {&r.values, &state.value_multi, &state.glitch_end_multi})
+            if (s->capacity() > std::string().capacity())
+                b += s->capacity() + 1;
+        return b;
+    }
+
+}  // namespace vcd
@@ -0,0 +1,55 @@
+#include "result_ring.h"
+
+namespace vcd
+{
+
+    ResultRing::Handle ResultRing::acquire(
+        const QueryResultBinary& res, const std::vector<uint32_t>& signals,
+        bool compressed)
+    {
+        // Round-robin, so the arena reused is the one released longest ago
+        for (size_t n = 0; n < SLOTS; ++n)
+        {
+            size_t s = (next_ + n) % SLOTS;
+            Slot& slot = slots_[s];
+            if (slot.held) continue;
+
+            const std::vector<uint8_t>& buf =
+                slot.encoder.encode(res, signals, compressed);
+            slot.held = true;
+            // Generation 0 never occurs, so no id is 0
+            if (++slot.generation >> (32 - SLOT_BITS)) slot.generation = 1;
+            next_ = (s + 1) % SLOTS;
+
+            Handle h;
+            h.id = (slot.generation << SLOT_BITS) | static_cast<uint32_t>(s);
+            h.data = buf.data();
+            h.size = buf.size();
+            return h;
+        }
+        return {};
+    }
+
+    bool ResultRing::release(uint32_t id)
+    {
+        size_t s = id & ((1u << SLOT_BITS) - 1);
+        if (s >= SLOTS) return false;
+        Slot& slot = slots_[s];
+        if (!slot.held || slot.generation != (id >> SLOT_BITS)) return false;
+        slot.held = false;
+        return true;
+    }
+
+    void ResultRing::release_all()
+    {
+        for (Slot& slot : slots_) slot.held = false;
+    }
+
+    bool ResultRing::full() const
+    {
+        for (const Slot& slot : slots_)
+            if (!slot.held) return false;
+        return true;
+    }
+
+}  // namespace vcd
@@ -0,0 +1,60 @@
+#include "result_segments.h"
+
+namespace vcd
+{
+
+    template <typename Record>
+    void ResultSegments::Stream<Record>::take(
+        const SignalSlots& slots, const std::vector<Record>& res,
+        const std::vector<int64_t>& last_index, bool final)
+    {
+        out.clear();
+        still.clear();
+        auto visit = [&](size_t i)
+        {
+            const Record& r = res[i];
+            uint32_t s = slots[r.signal_index];
+            // Held records are older than the new ones, so each signal's
+            // records still come out in order.
+            if (!final && s < last_index.size() &&
+                last_index[s] == static_cast<int64_t>(i))
+                still.push_back(static_cast<uint32_t>(i));
+            else
+                out.push_back(r);
+        };
+
+        for (uint32_t i : held) visit(i);
+        for (size_t i = published; i < res.size(); ++i) visit(i);
+        published = res.size();
+        held.swap(still);
+    }
+
+    void ResultSegments::reset()
+    {
+        stream_1bit_.published = 0;
+        stream_1bit_.held.clear();
+        stream_multi_.published = 0;
+        stream_multi_.held.clear();
+    }
+
+    QueryResultBinary ResultSegments::take(
+        const SignalSlots& slots, const std::vector<Transition1Bit>& res_1bit,
+        const std::vector<int64_t>& last_index_1bit,
+        const std::vector<TransitionMultiBit>& res_multi,
+        const std::vector<int64_t>& last_index_multi,
+        const std::string& string_pool, bool final)
+    {
+        stream_1bit_.take(slots, res_1bit, last_index_1bit, final);
+        stream_multi_.take(slots, res_multi, last_index_multi, final);
+
+        QueryResultBinary res;
+        res.transitions_1bit = stream_1bit_.out.data();
+        res.count_1bit = stream_1bit_.out.size();
+        res.transitions_multibit = stream_multi_.out.data();
+        res.count_multibit = stream_multi_.out.size();
+        res.string_pool = string_pool.data();
+        res.string_pool_size = string_pool.size();
+        return res;
+    }
+
+}  // namespace vcd
@@ -0,0 +1,165 @@
+#include "signal_names.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace vcd
+{
+
+    std::string_view NamePool::intern(std::string_view s)
+    {
+        auto it = interned_.find(s);
+        if (it != interned_.end()) return *it;
+        std::string_view stored = add(s);
+        interned_.insert(stored);
+        return stored;
+    }
+
+    std::string_view NamePool::add(std::string_view s)
+    {
+        if (s.empty()) return {};
+
+        char* dst;
+        if (s.size() > BLOCK_SIZE / 4)
+        {
+            // Own block, slotted in before the one being filled
+            auto block = std::make_unique<char[]>(s.size());
+            dst = block.get();
+            blocks_.insert(blocks_.end() - (blocks_.empty() ? 0 : 1),
+                           std::move(block));
+            bytes_ += s.size();
+        }
+        else
+        {
+            if (BLOCK_SIZE - block_used_ < s.size())
+            {
+                blocks_.push_back(std::make_unique<char[]>(BLOCK_SIZE));
+                block_used_ = 0;
+                bytes_ += BLOCK_SIZE;
+            }
+            dst = blocks_.back().get() + block_used_;
+            block_used_ += s.size();
+        }
+        std::memcpy(dst, s.data(), s.size());
+        return {dst, s.size()};
+    }
+
+    void NamePool::clear()
+    {
+        interned_.clear();
+        blocks_.clear();
+        block_used_ = BLOCK_SIZE;
+        bytes_ = 0;
+    }
+
+    size_t NamePool::memory_usage() const
+    {
+        // A node per interned name plus the bucket array
+        size_t node = sizeof(std::string_view) + 2 * sizeof(void*);
+        return bytes_ + interned_.size() * node +
+               interned_.bucket_count() * sizeof(void*);
+    }
+
+    namespace
+    {
+        struct ByName
+        {
+            template <typename E>
+            bool operator()(const E& a, std::string_view b) const
+            {
+                return a.view() < b;
+            }
+            template <typename E>
+            bool operator()(std::string_view a, const E& b) const
+            {
+                return a < b.view();
+            }
+        };
+    }  // namespace
+
+    void PathIndex::build(const ScopeNode* root,
+                          const std::vector<SignalDef>& signals)
+    {
+        clear();
+        if (!root) return;
+
+        // Breadth-first numbering: a scope's id is known once its parent
+        // lists it
+        std::vector<const ScopeNode*> order{root};
+        first_.push_back(0);
+        for (size_t i = 0; i < order.size(); ++i)
+        {
+            const ScopeNode* node = order[i];
+            size_t begin = entries_.size();
+            for (const auto& child : node->children)
+            {
+                entries_.push_back(
+                    {child->name.data(),
+                     static_cast<uint32_t>(child->name.size()),
+                     static_cast<uint32_t>(order.size()) | SCOPE_BIT});
+                order.push_back(child.get());
+            }
+            for (uint32_t idx : node->signal_indices)
+            {
+                if (idx >= signals.size()) continue;
+                std::string_view name = signals[idx].name;
+                entries_.push_back(
+                    {name.data(), static_cast<uint32_t>(name.size()), idx});
+            }
+            std::sort(entries_.begin() + begin, entries_.end(),
+                      [](const Entry& a, const Entry& b)
+                      {
+                          int c = a.view().compare(b.view());
+                          return c != 0 ? c < 0 : a.target < b.target;
+                      });
+            first_.push_back(static_cast<uint32_t>(entries_.size()));
+        }
+    }
+
+    void PathIndex::clear()
+    {
+        first_.clear();
+        entries_.clear();
+    }
+
+    uint32_t PathIndex::find(std::string_view full_path) const
+    {
+        uint32_t best = NONE;
+        if (!first_.empty()) search(0, full_path, best);
+        return best;
+    }
+
+    void PathIndex::search(uint32_t scope, std::string_view rest,
+                           uint32_t& best) const
+    {
+        auto lo = entries_.begin() + first_[scope];
+        auto hi = entries_.begin() + first_[scope + 1];
+        for (size_t dot = rest.find('.');; dot = rest.find('.', dot + 1))
+        {
+            auto range =
+                std::equal_range(lo, hi, rest.substr(0, dot), ByName{});
+            for (auto it = range.first; it != range.second; ++it)
+            {
+                bool is_scope = (it->target & SCOPE_BIT) != 0;
+                if (dot == std::string_view::npos)
+                {
+                    if (!is_scope && (best == NONE || it->target > best))
+                        best = it->target;
+                }
+                else if (is_scope)
+                {
+                    search(it->target & ~SCOPE_BIT, rest.substr(dot + 1),
+                           best);
+                }
+            }
+            if (dot == std::string_view::npos) break;
+        }
+    }
+
+    size_t PathIndex::memory_usage() const
+    {
+        return first_.capacity() * sizeof(uint32_t) +
+               entries_.capacity() * sizeof(Entry);
+    }
+
+}  // namespace vcd
@@ -0,0 +1,36 @@
+#include "signal_slots.h"
+
+namespace vcd
+{
+
+    void SignalSlots::assign(const std::vector<uint32_t>& signals,
+                             size_t signal_count)
+    {
+        if (slot_of_.size() != signal_count)
+            slot_of_.assign(signal_count, NONE);
+        else
+            for (uint32_t sig : signals_) slot_of_[sig] = NONE;
+
+        signals_.clear();
+        unique_ = true;
+        for (uint32_t sig : signals)
+        {
+            if (sig >= signal_count) continue;
+            if (slot_of_[sig] != NONE)
+            {
+                unique_ = false;
+                continue;
+            }
+            slot_of_[sig] = static_cast<uint32_t>(signals_.size());
+            signals_.push_back(sig);
+        }
+    }
+
+    void SignalSlots::clear()
+    {
+        slot_of_.clear();
+        signals_.clear();
+        unique_ = true;
+    }
+
+}  // namespace vcd
@@ -0,0 +1,198 @@
+#include "snapshot_store.h"
+
+namespace vcd
+{
+
+    void SnapshotStore::reset(size_t words, size_t slots)
+    {
+        words_ = words;
+        slots_ = slots;
+        entries_.clear();
+        keyframes_.clear();
+        delta_word_.clear();
+        delta_xor_.clear();
+        delta_slot_.clear();
+        delta_value_.clear();
+        value_ids_.clear();
+        values_.clear();
+        value_bytes_ = 0;
+    }
+
+    uint32_t SnapshotStore::intern(std::string_view value)
+    {
+        auto it = value_ids_.find(value);
+        if (it != value_ids_.end()) return it->second;
+
+        uint32_t id = static_cast<uint32_t>(values_.size());
+        const std::string& stored = values_.emplace_back(value);
+        value_ids_.emplace(stored, id);
+        // String, map node and any heap buffer beyond the inline capacity
+        value_bytes_ += sizeof(std::string) +
+                        sizeof(std::pair<std::string_view, uint32_t>) +
+                        2 * sizeof(void*);
+        if (stored.capacity() > std::string().capacity())
+            value_bytes_ += stored.capacity() + 1;
+        return id;
+    }
+
+    void SnapshotStore::push(uint64_t time, uint64_t file_offset,
+                             const std::vector<uint64_t>& state_1bit,
+                             const MultibitState& state_multi)
+    {
+        Entry e{time, file_offset, delta_word_.size(), delta_slot_.size(),
+                0, 0};
+
+        if (!keyframes_.empty())
+        {
+            const Keyframe& kf = keyframes_.back();
+            for (size_t w = 0; w < words_; ++w)
+            {
+                if (state_1bit[w] == kf.words[w]) continue;
+                delta_word_.push_back(static_cast<uint32_t>(w));
+                delta_xor_.push_back(state_1bit[w] ^ kf.words[w]);
+            }
+            for (size_t s = 0; s < slots_; ++s)
+            {
+                if (values_[kf.values[s]] == state_multi.get(s)) continue;
+                delta_slot_.push_back(static_cast<uint32_t>(s));
+                delta_value_.push_back(intern(state_multi.get(s)));
+            }
+
+            size_t delta_bytes =
+                (delta_word_.size() - e.word_begin) *
+                    (sizeof(uint32_t) + sizeof(uint64_t)) +
+                (delta_slot_.size() - e.value_begin) * 2 * sizeof(uint32_t);
+            if (delta_bytes * 2 <= keyframe_bytes())
+            {
+                e.keyframe = static_cast<uint32_t>(keyframes_.size() - 1);
+                entries_.push_back(e);
+                return;
+            }
+
+            // Too far from the keyframe: start a new one instead.
+            delta_word_.resize(e.word_begin);
+            delta_xor_.resize(e.word_begin);
+            delta_slot_.resize(e.value_begin);
+            delta_value_.resize(e.value_begin);
+        }
+
+        Keyframe kf;
+        kf.words = state_1bit;
+        kf.values.reserve(slots_);
+        for (size_t s = 0; s < slots_; ++s)
+            kf.values.push_back(intern(state_multi.get(s)));
+        e.keyframe = static_cast<uint32_t>(keyframes_.size());
+        keyframes_.push_back(std::move(kf));
+        entries_.push_back(e);
+    }
+
+    void SnapshotStore::restore(size_t k, std::vector<uint64_t>& state_1bit,
+                                MultibitState& state_multi) const
+    {
+        const Entry& e = entries_[k];
+        const Keyframe& kf = keyframes_[e.keyframe];
+        size_t word_end =
+            k + 1 < entries_.size() ? entries_[k + 1].word_begin
+                                    : delta_word_.size();
+        size_t value_end =
+            k + 1 < entries_.size() ? entries_[k + 1].value_begin
+                                    : delta_slot_.size();
+
+        state_1bit = kf.words;
+        for (size_t i = e.word_begin; i < word_end; ++i)
+            state_1bit[delta_word_[i]] ^= delta_xor_[i];
+
+        for (size_t s = 0; s < slots_; ++s)
+            state_multi.set(s, values_[kf.values[s]]);
+        for (size_t i = e.value_begin; i < value_end; ++i)
+            state_multi.set(delta_slot_[i], values_[delta_value_[i]]);
+    }
+
+    uint64_t SnapshotStore::word_at(size_t k, size_t word) const
+    {
+        const Entry& e = entries_[k];
+        size_t word_end =
+            k + 1 < entries_.size() ? entries_[k + 1].word_begin
+                                    : delta_word_.size();
+        uint64_t w = keyframes_[e.keyframe].words[word];
+        for (size_t i = e.word_begin; i < word_end; ++i)
+            if (delta_word_[i] == word) w ^= delta_xor_[i];
+        return w;
+    }
+
+    std::string_view SnapshotStore::value_at(size_t k, size_t slot) const
+    {
+        const Entry& e = entries_[k];
+        size_t value_end =
+            k + 1 < entries_.size() ? entries_[k + 1].value_begin
+                                    : delta_slot_.size();
+        uint32_t id = keyframes_[e.keyframe].values[slot];
+        for (size_t i = e.value_begin; i < value_end; ++i)
+            if (delta_slot_[i] == slot) id = delta_value_[i];
+        return values_[id];
+    }
+
+    void SnapshotStore::thin()
+    {
+        SnapshotStore kept;
+        kept.reset(words_, slots_);
+        std::vector<uint64_t> state_1bit;
+        MultibitState state_multi;
+        state_multi.assign(std::vector<uint32_t>(slots_, 0), {});
+        for (size_t k = 0; k < entries_.size(); k += 2)
+        {
+            restore(k, state_1bit, state_multi);
+            kept.push(entries_[k].time, entries_[k].file_offset, state_1bit,
+                      state_multi);
+        }
+        *this = std::move(kept);
+    }
+
+    size_t SnapshotStore::memory_usage() const
+    {
+        size_t b = entries_.capacity() * sizeof(Entry) +
+                   keyframes_.capacity() * sizeof(Keyframe) +
+                   delta_word_.capacity() * sizeof(uint32_t) +
+                   delta_xor_.capacity() * sizeof(uint64_t) +
+                   delta_slot_.capacity() * sizeof(uint32_t) +
+                   delta_value_.capacity() * sizeof(uint32_t) +
+                   value_ids_.bucket_count() * sizeof(void*) + value_bytes_;
+        for (const Keyframe& kf : keyframes_)
+            b += kf.words.capacity() * sizeof(uint64_t) +
+                 kf.values.capacity() * sizeof(uint32_t);
+        return b;
+    }
+
+    bool SnapshotStore::valid(uint64_t file_size) const
+    {
+        if (delta_word_.size() != delta_xor_.size() ||
+            delta_slot_.size() != delta_value_.size() ||
+            (!entries_.empty() && keyframes_.empty()))
+            return false;
+        for (const Keyframe& kf : keyframes_)
+        {
+            if (kf.words.size() != words_ || kf.values.size() != slots_)
+                return false;
+            for (uint32_t id : kf.values)
+                if (id >= values_.size()) return false;
+        }
+        for (uint32_t w : delta_word_)
+            if (w >= words_) return false;
+        for (size_t i = 0; i < delta_slot_.size(); ++i)
+            if (delta_slot_[i] >= slots_ || delta_value_[i] >= values_.size())
+                return false;
+
+        uint64_t word_at = 0, value_at = 0;
+        for (const Entry& e : entries_)
+        {
+            if (e.keyframe >= keyframes_.size() || e.word_begin < word_at ||
+                e.value_begin < value_at || e.file_offset > file_size)
+                return false;
+            word_at = e.word_begin;
+            value_at = e.value_begin;
+        }
+        return word_at <= delta_word_.size() &&
+               value_at <= delta_slot_.size();
+    }
+
+}  // namespace vcd
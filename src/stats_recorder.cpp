@@ -0,0 +1,90 @@
+#include "stats_recorder.h"
+
+#include <cinttypes>
+#include <cstdio>
+
+#include "waveform_json.h"
+
+namespace vcd
+{
+
+    void StatsRecorder::enable(bool enabled, bool trace)
+    {
+        enabled_ = enabled;
+        trace_ = enabled && trace;
+        origin_ = std::chrono::steady_clock::now();
+        counts_ = ParserStats();
+        events_.clear();
+        events_.shrink_to_fit();
+        dropped_ = 0;
+    }
+
+    uint64_t StatsRecorder::now() const
+    {
+        return static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - origin_)
+                .count());
+    }
+
+    void StatsRecorder::record(ParserPhase phase, uint64_t begin_ns)
+    {
+        uint64_t duration = now() - begin_ns;
+        size_t p = static_cast<size_t>(phase);
+        counts_.phase_ns[p] += duration;
+        ++counts_.phase_calls[p];
+        if (!trace_) return;
+        if (events_.size() < MAX_EVENTS)
+            events_.push_back({begin_ns, duration, phase});
+        else
+            ++dropped_;
+    }
+
+    std::string StatsRecorder::trace_json(const ParserStats& stats) const
+    {
+        // Written by hand: a long session holds up to a million events
+        std::string out;
+        out.reserve(256 + events_.size() * 96);
+        char buf[160];
+
+        out +=
+            "{\"traceEvents\":[{\"name\":\"process_name\",\"ph\":\"M\","
+            "\"pid\":1,\"tid\":1,\"args\":{\"name\":\"waveform parser\"}}";
+        for (const Event& e : events_)
+        {
+            // Timestamps are in microseconds
+            std::snprintf(buf, sizeof(buf),
+                          ",\n{\"name\":\"%s\",\"cat\":\"parser\",\"ph\":\"X\","
+                          "\"pid\":1,\"tid\":1,\"ts\":%.3f,\"dur\":%.3f}",
+                          parser_phase_name(e.phase), e.begin_ns / 1e3,
+                          e.duration_ns / 1e3);
+            out += buf;
+        }
+        out += "],\n\"displayTimeUnit\":\"ms\",\n\"otherData\":{";
+
+        auto field = [&](const char* name, uint64_t value)
+        {
+            std::snprintf(buf, sizeof(buf), "\"%s\":%" PRIu64 ",", name,
+                          value);
+            out += buf;
+        };
+        field("bytes_scanned", stats.bytes_scanned);
+        field("lines_parsed", stats.lines_parsed);
+        field("id_lookups", stats.id_lookups);
+        field("changes_applied", stats.changes_applied);
+        field("changes_emitted", stats.changes_emitted);
+        field("glitches_collapsed", stats.glitches_collapsed);
+        field("blocks_decoded", stats.blocks_decoded);
+        for (size_t p = 0; p < ParserStats::PHASES; ++p)
+        {
+            std::string name = parser_phase_name(static_cast<ParserPhase>(p));
+            field((name + "_ns").c_str(), stats.phase_ns[p]);
+            field((name + "_calls").c_str(), stats.phase_calls[p]);
+        }
+        field("dropped_events", dropped_);
+        out.back() = '}';
+        out += "}\n";
+        return out;
+    }
+
+}  // namespace vcd
@@ -0,0 +1,113 @@
+#include "value_matcher.h"
+
+#include <algorithm>
+
+namespace vcd
+{
+
+    namespace
+    {
+        char lower(char c) { return c >= 'A' && c <= 'Z' ? c - 'A' + 'a' : c; }
+
+        // Digit `i` from the right, extended past the left end as VCD does:
+        // with '0' after a '0' or '1', otherwise with the leftmost digit
+        char digit(std::string_view v, size_t i)
+        {
+            if (i < v.size()) return lower(v[v.size() - 1 - i]);
+            if (v.empty() || v[0] == '1') return '0';
+            return lower(v[0]);
+        }
+
+        std::string_view strip_prefix(std::string_view v, char a, char b)
+        {
+            if (!v.empty() && (v[0] == a || v[0] == b)) v.remove_prefix(1);
+            return v;
+        }
+
+        // A 1-bit value, which may come as a vector ("b1", "01"): its last
+        // digit
+        char bit(std::string_view v)
+        {
+            return digit(strip_prefix(v, 'b', 'B'), 0);
+        }
+
+        // `v` as binary digits: binary ('b' prefix optional) or hex after
+        // "0x" or 'h', whose x/z digits stand for four of them. False if
+        // it has no digits or one out of range.
+        bool to_binary(std::string_view v, std::string& out)
+        {
+            bool hex = v.size() > 1 && v[0] == '0' && lower(v[1]) == 'x';
+            if (hex)
+                v.remove_prefix(2);
+            else if (!v.empty() && lower(v[0]) == 'h')
+            {
+                hex = true;
+                v.remove_prefix(1);
+            }
+            else
+                v = strip_prefix(v, 'b', 'B');
+
+            out.clear();
+            for (char c : v)
+            {
+                c = lower(c);
+                if (c == 'x' || c == 'z')
+                    out.append(hex ? 4 : 1, c);
+                else if (!hex && (c == '0' || c == '1'))
+                    out += c;
+                else if (hex && ((c >= '0' && c <= '9') ||
+                                 (c >= 'a' && c <= 'f')))
+                {
+                    int d = c <= '9' ? c - '0' : c - 'a' + 10;
+                    for (int bit = 3; bit >= 0; --bit)
+                        out += (d >> bit) & 1 ? '1' : '0';
+                }
+                else
+                    return false;
+            }
+            return !out.empty();
+        }
+    }  // namespace
+
+    ValueMatcher::ValueMatcher(const SignalDef& sig,
+                               const SearchPredicate& predicate)
+        : kind_(predicate.kind),
+          real_(sig.type == VarType::Real),
+          one_bit_(sig.width == 1 && !real_)
+    {
+        if (kind_ != SearchKind::Equals) return;
+        if (real_)
+            target_.assign(strip_prefix(predicate.value, 'r', 'R'));
+        else
+            valid_ = to_binary(predicate.value, target_);
+    }
+
+    bool ValueMatcher::same(std::string_view a, std::string_view b) const
+    {
+        if (real_)
+            return strip_prefix(a, 'r', 'R') == strip_prefix(b, 'r', 'R');
+        a = strip_prefix(a, 'b', 'B');
+        b = strip_prefix(b, 'b', 'B');
+        for (size_t i = 0, n = std::max(a.size(), b.size()); i < n; ++i)
+            if (digit(a, i) != digit(b, i)) return false;
+        return true;
+    }
+
+    bool ValueMatcher::matches(std::string_view old_v,
+                               std::string_view new_v) const
+    {
+        switch (kind_)
+        {
+            case SearchKind::AnyChange:
+                return !same(old_v, new_v);
+            case SearchKind::Rising:
+                return one_bit_ && bit(new_v) == '1' && bit(old_v) != '1';
+            case SearchKind::Falling:
+                return one_bit_ && bit(new_v) == '0' && bit(old_v) != '0';
+            case SearchKind::Equals:
+                return same(new_v, target_) && !same(old_v, target_);
+        }
+        return false;
+    }
+
+}  // namespace vcd
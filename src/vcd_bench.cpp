@@ -0,0 +1,788 @@
+// vcd_bench: reproducible throughput benchmarks for the parsers.
+//
+// Generates a synthetic VCD (and the same trace as FST) from a seed, then
+// measures indexing throughput, query latency at several zoom levels,
+// LodManager throughput and snapshot memory. Results go out as JSON so
+// they can be compared across builds; the same options and seed always
+// produce the same files.
+
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "fst_parser.h"
+#include "fstapi.h"
+#include "lod_manager.h"
+#include "signal_slots.h"
+#include "vcd_parser.h"
+#include "waveform_json.h"
+
+namespace
+{
+
+    using json = nlohmann::ordered_json;
+    using Clock = std::chrono::steady_clock;
+
+    struct Options
+    {
+        // Generator
+        uint32_t signals = 1000;
+        uint32_t bus_width = 32;
+        double bus_fraction = 0.25;  // of the signals, the rest are 1-bit
+        double toggle_rate = 0.05;   // chance a signal changes per timestamp
+        uint64_t size_mb = 64;       // of the VCD
+        uint64_t seed = 1;
+        std::string dir = ".";
+        bool keep = false;
+        bool fst = true;
+
+        // Benchmarks
+        unsigned repeats = 3;
+        uint64_t chunk_mb = 32;
+        unsigned index_threads = 1;
+        unsigned query_threads = 1;
+        bool transition_index = true;
+        uint32_t query_signals = 32;
+        unsigned queries = 20;  // per zoom level
+        uint32_t pixels = 1920;
+        uint64_t lod_changes = 10000000;
+        std::string out;    // JSON file, stdout if empty
+        std::string trace;  // Chrome trace of an instrumented VCD pass
+    };
+
+    double ms_since(Clock::time_point t0)
+    {
+        return std::chrono::duration<double, std::milli>(Clock::now() - t0)
+            .count();
+    }
+
+    uint64_t file_size(const std::string& path)
+    {
+        struct stat st;
+        return ::stat(path.c_str(), &st) == 0
+                   ? static_cast<uint64_t>(st.st_size)
+                   : 0;
+    }
+
+    // Quantile of already sorted samples
+    double quantile(const std::vector<double>& sorted, double q)
+    {
+        if (sorted.empty()) return 0.0;
+        size_t i = static_cast<size_t>(q * (sorted.size() - 1) + 0.5);
+        return sorted[std::min(i, sorted.size() - 1)];
+    }
+
+    json summary(std::vector<double> samples)
+    {
+        std::sort(samples.begin(), samples.end());
+        return {{"min", quantile(samples, 0.0)},
+                {"median", quantile(samples, 0.5)},
+                {"p95", quantile(samples, 0.95)},
+                {"max", quantile(samples, 1.0)}};
+    }
+
+    // ================================================================
+    // Synthetic trace
+    // ================================================================
+
+    // SplitMix64: the same sequence on every platform, unlike the
+    // distributions of <random>
+    class Rng
+    {
+       public:
+        explicit Rng(uint64_t seed) : state_(seed) {}
+
+        uint64_t next()
+        {
+            uint64_t z = (state_ += 0x9E3779B97F4A7C15ULL);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+            return z ^ (z >> 31);
+        }
+
+        /// Uniform in (0, 1]
+        double unit() { return ((next() >> 11) + 1) * 0x1.0p-53; }
+
+       private:
+        uint64_t state_;
+    };
+
+    /**
+     * Value changes of the synthetic trace, one timestamp at a time. Each
+     * signal changes with probability toggle_rate per timestamp: the
+     * changed ones are found by geometric skips, so sparse traces with many
+     * signals cost no more than their changes. 1-bit signals toggle, buses
+     * take random values (printed at full width).
+     */
+    class TraceGenerator
+    {
+       public:
+        static constexpr uint64_t TIME_STEP = 10;
+        static constexpr uint32_t SCOPE_SIZE = 64;
+
+        explicit TraceGenerator(const Options& o)
+            : opts_(o), rng_(o.seed), value_(o.signals, 0)
+        {
+            width_.resize(o.signals);
+            for (uint32_t i = 0; i < o.signals; ++i)
+            {
+                // Buses spread evenly through the signals
+                bool bus =
+                    std::floor((i + 1) * o.bus_fraction) >
+                    std::floor(i * o.bus_fraction);
+                width_[i] = bus && o.bus_width > 1 ? o.bus_width : 1;
+            }
+            log_stay_ = o.toggle_rate < 1.0 ? std::log(1.0 - o.toggle_rate)
+                                            : 0.0;
+        }
+
+        uint32_t width(uint32_t sig) const { return width_[sig]; }
+
+        /// The timestamp next() generates
+        uint64_t time() const { return time_; }
+
+        /// Call `emit(sig, value)` for every signal changing at the next
+        /// timestamp and return that timestamp.
+        template <typename Emit>
+        uint64_t next(Emit&& emit)
+        {
+            uint64_t time = time_;
+            time_ += TIME_STEP;
+            if (opts_.toggle_rate <= 0.0) return time;
+            for (uint64_t sig = skip(); sig < opts_.signals; sig += 1 + skip())
+            {
+                uint32_t s = static_cast<uint32_t>(sig);
+                if (width_[s] == 1)
+                    value_[s] ^= 1;
+                else
+                    value_[s] = rng_.next();
+                emit(s, value_string(s));
+            }
+            return time;
+        }
+
+        /// The value of `sig`, '0'/'1' per bit, MSB first
+        const std::string& value_string(uint32_t sig)
+        {
+            uint32_t w = width_[sig];
+            text_.resize(w);
+            for (uint32_t b = 0; b < w; ++b)
+                text_[w - 1 - b] =
+                    (b < 64 && ((value_[sig] >> b) & 1)) ? '1' : '0';
+            return text_;
+        }
+
+       private:
+        // Signals skipped before the next change
+        uint64_t skip()
+        {
+            if (opts_.toggle_rate >= 1.0) return 0;
+            double k = std::floor(std::log(rng_.unit()) / log_stay_);
+            return k < static_cast<double>(opts_.signals)
+                       ? static_cast<uint64_t>(k)
+                       : opts_.signals;
+        }
+
+        const Options& opts_;
+        Rng rng_;
+        std::vector<uint32_t> width_;
+        std::vector<uint64_t> value_;
+        std::string text_;
+        double log_stay_ = 0.0;
+        uint64_t time_ = TIME_STEP;  // #0 holds the initial values
+    };
+
+    std::string id_code(uint32_t index)
+    {
+        std::string id;
+        do
+        {
+            id.push_back(static_cast<char>('!' + index % 94));
+            index /= 94;
+        } while (index);
+        return id;
+    }
+
+    std::string signal_name(uint32_t sig, uint32_t width)
+    {
+        return (width > 1 ? "bus" : "sig") + std::to_string(sig);
+    }
+
+    struct GeneratedTrace
+    {
+        std::string vcd_path;
+        std::string fst_path;
+        uint64_t timestamps = 0;
+        uint64_t changes = 0;
+        uint64_t time_end = 0;
+        double vcd_ms = 0.0;
+        double fst_ms = 0.0;
+    };
+
+    // Signals are grouped into scopes of SCOPE_SIZE under "top"
+    bool write_vcd(const Options& o, GeneratedTrace& g)
+    {
+        std::FILE* f = std::fopen(g.vcd_path.c_str(), "wb");
+        if (!f) return false;
+        auto t0 = Clock::now();
+
+        TraceGenerator gen(o);
+        std::string buf;
+        buf += "$date vcd_bench $end\n$version vcd_bench seed=" +
+               std::to_string(o.seed) + " $end\n$timescale 1ns $end\n";
+        buf += "$scope module top $end\n";
+        std::vector<std::string> ids(o.signals);
+        for (uint32_t i = 0; i < o.signals; ++i)
+        {
+            if (i % TraceGenerator::SCOPE_SIZE == 0)
+            {
+                if (i) buf += "$upscope $end\n";
+                buf += "$scope module blk" +
+                       std::to_string(i / TraceGenerator::SCOPE_SIZE) +
+                       " $end\n";
+            }
+            ids[i] = id_code(i);
+            uint32_t w = gen.width(i);
+            buf += "$var wire " + std::to_string(w) + " " + ids[i] + " " +
+                   signal_name(i, w) + " $end\n";
+        }
+        if (o.signals) buf += "$upscope $end\n";
+        buf += "$upscope $end\n$enddefinitions $end\n#0\n$dumpvars\n";
+        for (uint32_t i = 0; i < o.signals; ++i)
+        {
+            if (gen.width(i) == 1)
+                buf += "0" + ids[i] + "\n";
+            else
+                buf += "b" + gen.value_string(i) + " " + ids[i] + "\n";
+        }
+        buf += "$end\n";
+
+        uint64_t target = o.size_mb * 1024 * 1024;
+        uint64_t written = 0;
+        while (written + buf.size() < target)
+        {
+            size_t mark = buf.size();
+            bool any = false;
+            uint64_t time = gen.next(
+                [&](uint32_t sig, const std::string& v)
+                {
+                    if (gen.width(sig) == 1)
+                    {
+                        buf += v;
+                    }
+                    else
+                    {
+                        buf += 'b';
+                        buf += v;
+                        buf += ' ';
+                    }
+                    buf += ids[sig];
+                    buf += '\n';
+                    ++g.changes;
+                    any = true;
+                });
+            if (any)
+            {
+                std::string stamp = "#" + std::to_string(time) + "\n";
+                buf.insert(mark, stamp);
+                ++g.timestamps;
+                g.time_end = time;
+            }
+            if (buf.size() >= (1u << 20))
+            {
+                std::fwrite(buf.data(), 1, buf.size(), f);
+                written += buf.size();
+                buf.clear();
+            }
+        }
+        std::fwrite(buf.data(), 1, buf.size(), f);
+        bool ok = std::fclose(f) == 0;
+        g.vcd_ms = ms_since(t0);
+        return ok;
+    }
+
+    // The same trace as write_vcd(), up to the VCD's last timestamp
+    bool write_fst(const Options& o, GeneratedTrace& g)
+    {
+        fstWriterContext* ctx = fstWriterCreate(g.fst_path.c_str(), 1);
+        if (!ctx) return false;
+        auto t0 = Clock::now();
+
+        TraceGenerator gen(o);
+        fstWriterSetTimescale(ctx, -9);
+        fstWriterSetScope(ctx, FST_ST_VCD_MODULE, "top", nullptr);
+        std::vector<fstHandle> handles(o.signals);
+        for (uint32_t i = 0; i < o.signals; ++i)
+        {
+            if (i % TraceGenerator::SCOPE_SIZE == 0)
+            {
+                if (i) fstWriterSetUpscope(ctx);
+                std::string blk =
+                    "blk" + std::to_string(i / TraceGenerator::SCOPE_SIZE);
+                fstWriterSetScope(ctx, FST_ST_VCD_MODULE, blk.c_str(),
+                                  nullptr);
+            }
+            uint32_t w = gen.width(i);
+            handles[i] = fstWriterCreateVar(ctx, FST_VT_VCD_WIRE,
+                                            FST_VD_IMPLICIT, w,
+                                            signal_name(i, w).c_str(), 0);
+        }
+        if (o.signals) fstWriterSetUpscope(ctx);
+        fstWriterSetUpscope(ctx);
+
+        fstWriterEmitTimeChange(ctx, 0);
+        for (uint32_t i = 0; i < o.signals; ++i)
+            fstWriterEmitValueChange(ctx, handles[i],
+                                     gen.value_string(i).c_str());
+        while (gen.time() <= g.time_end)
+        {
+            uint64_t time = gen.time();
+            bool stamped = false;
+            gen.next(
+                [&](uint32_t sig, const std::string& v)
+                {
+                    if (!stamped) fstWriterEmitTimeChange(ctx, time);
+                    stamped = true;
+                    fstWriterEmitValueChange(ctx, handles[sig], v.c_str());
+                });
+        }
+        fstWriterClose(ctx);
+        g.fst_ms = ms_since(t0);
+        return true;
+    }
+
+    // ================================================================
+    // Benchmarks
+    // ================================================================
+
+    // Evenly spread over the signals, so buses and 1-bit signals mix as
+    // they do in the file
+    std::vector<uint32_t> pick_signals(size_t signal_count, uint32_t n)
+    {
+        std::vector<uint32_t> picked;
+        n = static_cast<uint32_t>(std::min<size_t>(n, signal_count));
+        for (uint32_t i = 0; i < n; ++i)
+            picked.push_back(static_cast<uint32_t>(i * signal_count / n));
+        return picked;
+    }
+
+    template <typename Parser>
+    bool open_and_index(Parser& parser, const std::string& path,
+                        const Options& o)
+    {
+        if (!parser.open_file(path)) return false;
+        parser.begin_indexing();
+        while (parser.index_step(o.chunk_mb * 1024 * 1024) > 0)
+        {
+        }
+        parser.finish_indexing();
+        return parser.is_open();
+    }
+
+    void configure(vcd::VcdParser& parser, const Options& o)
+    {
+        parser.set_index_threads(o.index_threads);
+        parser.set_query_threads(o.query_threads);
+        parser.set_transition_index(o.transition_index);
+        // Every query replays: the cache would measure lookups instead
+        parser.set_query_cache_budget(0);
+    }
+    void configure(vcd::FstParser& parser, const Options& o)
+    {
+        parser.set_query_threads(o.query_threads);
+        parser.set_query_cache_budget(0);
+    }
+
+    /// Latency of get_query_plan() through the last query_step() and
+    /// flush, for windows of 1, 1/10, 1/100 and 1/1000 of the trace
+    json bench_queries(vcd::IWaveformParser& parser, const Options& o)
+    {
+        json levels = json::array();
+        uint64_t t0 = parser.time_begin(), t1 = parser.time_end();
+        uint64_t range = t1 - t0;
+        std::vector<uint32_t> signals =
+            pick_signals(parser.signal_count(), o.query_signals);
+        size_t chunk = o.chunk_mb * 1024 * 1024;
+
+        for (uint64_t zoom : {1, 10, 100, 1000})
+        {
+            uint64_t span = std::max<uint64_t>(1, range / zoom);
+            float pixel_step = static_cast<float>(span) / o.pixels;
+            std::vector<double> latency;
+            uint64_t records = 0;
+            for (unsigned q = 0; q < o.queries; ++q)
+            {
+                uint64_t room = range - std::min(range, span);
+                uint64_t begin =
+                    t0 + (o.queries > 1 ? room * q / (o.queries - 1) : 0);
+                auto start = Clock::now();
+                vcd::QueryPlan plan = parser.get_query_plan(begin);
+                parser.begin_query(begin, begin + span, signals,
+                                   plan.snapshot_index, pixel_step);
+                while (parser.query_step(chunk))
+                {
+                }
+                vcd::QueryResultBinary r = parser.flush_query_binary();
+                latency.push_back(ms_since(start) * 1000.0);
+                records += r.count_1bit + r.count_multibit;
+            }
+            levels.push_back(
+                {{"zoom", zoom},
+                 {"span", span},
+                 {"pixel_time_step", pixel_step},
+                 {"latency_us", summary(latency)},
+                 {"records_avg",
+                  o.queries ? static_cast<double>(records) / o.queries : 0}});
+        }
+        return levels;
+    }
+
+    json bench_vcd(const Options& o, const std::string& path)
+    {
+        uint64_t bytes = file_size(path);
+        std::vector<double> ms;
+        vcd::VcdParser parser;
+        for (unsigned r = 0; r < std::max(1u, o.repeats); ++r)
+        {
+            parser = vcd::VcdParser();
+            configure(parser, o);
+            auto t0 = Clock::now();
+            if (!open_and_index(parser, path, o))
+                return {{"error", "index failed"}};
+            ms.push_back(ms_since(t0));
+        }
+
+        std::vector<double> mb_per_s;
+        for (double m : ms)
+            mb_per_s.push_back(bytes / (1024.0 * 1024.0) / (m / 1000.0));
+        std::sort(mb_per_s.begin(), mb_per_s.end());
+        json index_json = {
+            {"runs_ms", ms},
+            {"mb_per_s",
+             {{"best", mb_per_s.back()},
+              {"median", quantile(mb_per_s, 0.5)}}},
+            {"snapshot_count", parser.snapshot_count()},
+            {"snapshot_memory_bytes", parser.snapshot_memory_usage()},
+            {"index_memory_bytes", parser.index_memory_usage()}};
+
+        return {{"file_bytes", bytes},
+                {"index", index_json},
+                {"query", bench_queries(parser, o)}};
+    }
+
+    bool write_file(const std::string& path, const std::string& text)
+    {
+        std::FILE* f = std::fopen(path.c_str(), "w");
+        if (!f) return false;
+        bool ok = std::fputs(text.c_str(), f) >= 0;
+        return std::fclose(f) == 0 && ok;
+    }
+
+    /// One more VCD index and query sweep with ParserStats and tracing on,
+    /// apart from the timed runs so they don't pay for it. Returns the
+    /// stats; the trace goes to o.trace.
+    json trace_vcd(const Options& o, const std::string& path)
+    {
+        vcd::VcdParser parser;
+        configure(parser, o);
+        parser.set_stats_enabled(true, true);
+        if (!open_and_index(parser, path, o))
+            return {{"error", "index failed"}};
+        bench_queries(parser, o);
+        if (!write_file(o.trace, parser.trace_json()))
+            std::fprintf(stderr, "Failed to write %s\n", o.trace.c_str());
+        return json::parse(vcd::stats_json(parser.stats()));
+    }
+
+    json bench_fst(const Options& o, const std::string& path)
+    {
+        std::vector<double> ms;
+        vcd::FstParser parser;
+        for (unsigned r = 0; r < std::max(1u, o.repeats); ++r)
+        {
+            parser = vcd::FstParser();
+            configure(parser, o);
+            auto t0 = Clock::now();
+            if (!open_and_index(parser, path, o))
+                return {{"error", "open failed"}};
+            ms.push_back(ms_since(t0));
+        }
+        return {{"file_bytes", file_size(path)},
+                {"open", {{"runs_ms", ms}}},
+                {"query", bench_queries(parser, o)}};
+    }
+
+    /// Changes per second through LodManager alone, for one queried
+    /// signal set, with and without glitch reduction
+    json bench_lod_manager(const Options& o)
+    {
+        json runs = json::array();
+        uint32_t n = std::max<uint32_t>(1, o.query_signals);
+        std::vector<uint32_t> signals(n);
+        for (uint32_t i = 0; i < n; ++i) signals[i] = i;
+        vcd::SignalSlots slots;
+        slots.assign(signals, n);
+
+        const char* bus_values[] = {"0000", "0101", "1010", "1111"};
+        for (bool multibit : {false, true})
+        {
+            for (float pixel_step : {0.0f, 16.0f, 1024.0f})
+            {
+                vcd::LodManager lod;
+                lod.reset(slots, pixel_step);
+                std::vector<vcd::Transition1Bit> res_1bit;
+                std::vector<vcd::TransitionMultiBit> res_multi;
+                std::vector<int64_t> last_1bit(n, -1), last_multi(n, -1);
+                std::string pool;
+                std::vector<uint8_t> state(n, 0);
+                Rng rng(o.seed);
+                uint64_t emitted = 0;
+
+                auto t0 = Clock::now();
+                for (uint64_t c = 0; c < o.lod_changes; ++c)
+                {
+                    // Results are drained like segments are: only the
+                    // latest record of a signal stays referenced
+                    if (res_1bit.size() + res_multi.size() >= (1u << 20))
+                    {
+                        emitted += res_1bit.size() + res_multi.size();
+                        res_1bit.clear();
+                        res_multi.clear();
+                        pool.clear();
+                        std::fill(last_1bit.begin(), last_1bit.end(), -1);
+                        std::fill(last_multi.begin(), last_multi.end(), -1);
+                    }
+                    uint64_t r = rng.next();
+                    uint32_t sig = static_cast<uint32_t>(r % n);
+                    uint64_t time = c * 4 + ((r >> 32) & 3);
+                    uint8_t v = static_cast<uint8_t>((r >> 40) & 3);
+                    if (multibit)
+                        lod.process_multibit(time, sig, bus_values[v],
+                                             bus_values[state[sig]], res_multi,
+                                             last_multi, pool);
+                    else
+                        lod.process_1bit(time, sig, v & 1, state[sig],
+                                         res_1bit, last_1bit);
+                    state[sig] = multibit ? v : (v & 1);
+                }
+                lod.flush_glitches(res_1bit, last_1bit, res_multi, last_multi,
+                                   pool);
+                double ms = ms_since(t0);
+                emitted += res_1bit.size() + res_multi.size();
+
+                runs.push_back(
+                    {{"kind", multibit ? "multibit" : "1bit"},
+                     {"pixel_time_step", pixel_step},
+                     {"changes", o.lod_changes},
+                     {"records", emitted},
+                     {"mchanges_per_s",
+                      o.lod_changes / 1e6 / std::max(ms / 1000.0, 1e-9)}});
+            }
+        }
+        return runs;
+    }
+
+    void usage(const char* argv0)
+    {
+        std::fprintf(
+            stderr,
+            "Usage: %s [options]\n"
+            "Trace:\n"
+            "  --signals N          signals in the trace (1000)\n"
+            "  --bus-width W        width of multi-bit signals (32)\n"
+            "  --bus-fraction F     share of multi-bit signals (0.25)\n"
+            "  --toggle-rate R      change probability per timestamp (0.05)\n"
+            "  --size MB            VCD size (64)\n"
+            "  --seed S             generator seed (1)\n"
+            "  --dir PATH           where to write the trace (.)\n"
+            "  --keep               keep the generated files\n"
+            "  --no-fst             skip the FST trace\n"
+            "Benchmarks:\n"
+            "  --repeats N          indexing runs (3)\n"
+            "  --chunk MB           index_step/query_step chunk (32)\n"
+            "  -j N                 index threads (1, 0 = all cores)\n"
+            "  --query-threads N    query threads (1, 0 = all cores)\n"
+            "  --no-transition-index\n"
+            "  --query-signals N    signals per query (32)\n"
+            "  --queries N          queries per zoom level (20)\n"
+            "  --pixels N           view width for pixel_time_step (1920)\n"
+            "  --lod-changes N      LodManager changes per run (10000000)\n"
+            "  --out FILE           write the JSON here instead of stdout\n"
+            "  --trace FILE         also write a Chrome trace of one VCD pass\n"
+            "                       with stats enabled (adds vcd.stats)\n",
+            argv0);
+    }
+
+    bool parse_options(int argc, char* argv[], Options& o)
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            std::string a = argv[i];
+            auto value = [&]() -> const char*
+            { return i + 1 < argc ? argv[++i] : nullptr; };
+            auto text = [&](std::string& field)
+            {
+                const char* v = value();
+                if (v) field = v;
+                return v != nullptr;
+            };
+            auto number = [&](auto& field)
+            {
+                using T = std::remove_reference_t<decltype(field)>;
+                const char* v = value();
+                if (!v) return false;
+                if constexpr (std::is_floating_point_v<T>)
+                    field = std::strtod(v, nullptr);
+                else
+                    field = static_cast<T>(std::strtoull(v, nullptr, 10));
+                return true;
+            };
+
+            bool ok = true;
+            if (a == "--signals")
+                ok = number(o.signals);
+            else if (a == "--bus-width")
+                ok = number(o.bus_width);
+            else if (a == "--bus-fraction")
+                ok = number(o.bus_fraction);
+            else if (a == "--toggle-rate")
+                ok = number(o.toggle_rate);
+            else if (a == "--size")
+                ok = number(o.size_mb);
+            else if (a == "--seed")
+                ok = number(o.seed);
+            else if (a == "--dir")
+                ok = text(o.dir);
+            else if (a == "--keep")
+                o.keep = true;
+            else if (a == "--no-fst")
+                o.fst = false;
+            else if (a == "--repeats")
+                ok = number(o.repeats);
+            else if (a == "--chunk")
+                ok = number(o.chunk_mb);
+            else if (a == "-j")
+                ok = number(o.index_threads);
+            else if (a == "--query-threads")
+                ok = number(o.query_threads);
+            else if (a == "--no-transition-index")
+                o.transition_index = false;
+            else if (a == "--query-signals")
+                ok = number(o.query_signals);
+            else if (a == "--queries")
+                ok = number(o.queries);
+            else if (a == "--pixels")
+                ok = number(o.pixels);
+            else if (a == "--lod-changes")
+                ok = number(o.lod_changes);
+            else if (a == "--out")
+                ok = text(o.out);
+            else if (a == "--trace")
+                ok = text(o.trace);
+            else
+                ok = false;
+            if (!ok) return false;
+        }
+        o.bus_fraction = std::clamp(o.bus_fraction, 0.0, 1.0);
+        o.toggle_rate = std::clamp(o.toggle_rate, 0.0, 1.0);
+        o.chunk_mb = std::max<uint64_t>(1, o.chunk_mb);
+        o.pixels = std::max<uint32_t>(1, o.pixels);
+        return true;
+    }
+
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+    Options o;
+    if (!parse_options(argc, argv, o))
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    GeneratedTrace g;
+    std::string base = o.dir + "/vcd_bench_" + std::to_string(o.seed);
+    g.vcd_path = base + ".vcd";
+    g.fst_path = base + ".fst";
+    std::fprintf(stderr, "Generating %s...\n", g.vcd_path.c_str());
+    if (!write_vcd(o, g))
+    {
+        std::fprintf(stderr, "Failed to write %s\n", g.vcd_path.c_str());
+        return 1;
+    }
+    if (o.fst)
+    {
+        std::fprintf(stderr, "Generating %s...\n", g.fst_path.c_str());
+        if (!write_fst(o, g))
+        {
+            std::fprintf(stderr, "Failed to write %s\n", g.fst_path.c_str());
+            return 1;
+        }
+    }
+
+    json result;
+    result["version"] = 1;
+    result["config"] = {{"signals", o.signals},
+                        {"bus_width", o.bus_width},
+                        {"bus_fraction", o.bus_fraction},
+                        {"toggle_rate", o.toggle_rate},
+                        {"size_mb", o.size_mb},
+                        {"seed", o.seed},
+                        {"repeats", o.repeats},
+                        {"chunk_mb", o.chunk_mb},
+                        {"index_threads", o.index_threads},
+                        {"query_threads", o.query_threads},
+                        {"transition_index", o.transition_index},
+                        {"query_signals", o.query_signals},
+                        {"queries", o.queries},
+                        {"pixels", o.pixels}};
+    result["trace"] = {{"timestamps", g.timestamps},
+                       {"changes", g.changes},
+                       {"time_end", g.time_end},
+                       {"generate_vcd_ms", g.vcd_ms},
+                       {"generate_fst_ms", g.fst_ms}};
+
+    std::fprintf(stderr, "Benchmarking VCD...\n");
+    result["vcd"] = bench_vcd(o, g.vcd_path);
+    if (!o.trace.empty())
+    {
+        std::fprintf(stderr, "Tracing VCD into %s...\n", o.trace.c_str());
+        result["vcd"]["stats"] = trace_vcd(o, g.vcd_path);
+    }
+    if (o.fst)
+    {
+        std::fprintf(stderr, "Benchmarking FST...\n");
+        result["fst"] = bench_fst(o, g.fst_path);
+    }
+    std::fprintf(stderr, "Benchmarking LodManager...\n");
+    result["lod_manager"] = bench_lod_manager(o);
+
+    if (!o.keep)
+    {
+        std::remove(g.vcd_path.c_str());
+        std::remove((g.vcd_path + ".wvidx").c_str());
+        if (o.fst) std::remove(g.fst_path.c_str());
+    }
+
+    std::string text = result.dump(2) + "\n";
+    if (o.out.empty())
+    {
+        std::fputs(text.c_str(), stdout);
+        return 0;
+    }
+    if (!write_file(o.out, text))
+    {
+        std::fprintf(stderr, "Failed to write %s\n", o.out.c_str());
+        return 1;
+    }
+    return 0;
+}
@@ -1,15 +1,39 @@
 #include "vcd_parser.h"
 
+#include <sys/stat.h>
+#include <sys/types.h>
+
 #include <algorithm>
 #include <atomic>
-#include <cassert>
 #include <cstdint>
+#include <cstdio>
 #include <cstring>
 #include <string>
 #include <string_view>
 #include <unordered_map>
 
 #include "lod_manager.h"
+#include "gzip_reader.h"
+#include "id_table.h"
+#include "line_scanner.h"
+#include "lod_pyramid.h"
+#include "mapped_file.h"
+#include "multibit_state.h"
+#include "query_cache.h"
+#include "result_segments.h"
+#include "signal_names.h"
+#include "signal_slots.h"
+#include "snapshot_store.h"
+#include "stats_recorder.h"
+#include "value_matcher.h"
+
+#ifndef WAVEFORM_HAVE_THREADS
+#define WAVEFORM_HAVE_THREADS 0
+#endif
+
+#if WAVEFORM_HAVE_THREADS
+#include <thread>
+#endif
 
 namespace vcd
 {
@@ -50,15 +74,157 @@ namespace vcd
         return static_cast<uint8_t>((vec[word] >> shift) & 3);
     }
 
-    uint64_t encode_id(std::string_view id)
+    // Seek with 64-bit offsets; plain fseek wraps past 2 GB on some targets.
+    inline void seek_file(std::FILE* f, uint64_t offset)
+    {
+#if defined(_WIN32)
+        _fseeki64(f, static_cast<__int64>(offset), SEEK_SET);
+#else
+        fseeko(f, static_cast<off_t>(offset), SEEK_SET);
+#endif
+    }
+
+    // Size and modification time of `path`; used to detect stale sidecars.
+    inline bool stat_file(const std::string& path, uint64_t& size,
+                          int64_t& mtime)
+    {
+#if defined(_WIN32)
+        struct _stat64 st;
+        if (_stat64(path.c_str(), &st) != 0) return false;
+#else
+        struct stat st;
+        if (::stat(path.c_str(), &st) != 0) return false;
+#endif
+        size = static_cast<uint64_t>(st.st_size);
+        mtime = static_cast<int64_t>(st.st_mtime);
+        return true;
+    }
+
+    // 64-bit FNV-1a, continued from `h`.
+    inline uint64_t fnv1a(std::string_view data,
+                          uint64_t h = 0xcbf29ce484222325ULL)
+    {
+        for (unsigned char c : data)
+        {
+            h ^= c;
+            h *= 0x100000001b3ULL;
+        }
+        return h;
+    }
+
+    // ============================================================================
+    // Index Sidecar Serialization
+    // ============================================================================
+    //
+    // A sidecar is a flat host-byte-order dump (a byte-order mark is checked
+    // on load) of the header metadata, the signal table, the scope tree,
+    // the encoded snapshot store, the optional transition index and, for
+    // a gzip file, its decompression checkpoints.
+    // The id table and path index are rebuilt from the signal table.
+
+    static constexpr char INDEX_MAGIC[8] = {'W', 'V', 'I', 'D',
+                                            'X', '\n', '\x1a', '\0'};
+    static constexpr uint32_t INDEX_VERSION = 5;
+    static constexpr uint32_t INDEX_BYTE_ORDER = 0x01020304;
+
+    class IndexWriter
+    {
+       public:
+        explicit IndexWriter(std::FILE* f) : f_(f) {}
+
+        bool ok() const { return ok_; }
+
+        void bytes(const void* p, size_t n)
+        {
+            if (ok_ && n > 0 && std::fwrite(p, 1, n, f_) != n) ok_ = false;
+        }
+
+        template <typename T>
+        void pod(const T& v)
+        {
+            bytes(&v, sizeof(T));
+        }
+
+        void str(std::string_view s)
+        {
+            pod(static_cast<uint32_t>(s.size()));
+            bytes(s.data(), s.size());
+        }
+
+        template <typename T>
+        void pod_vec(const std::vector<T>& v)
+        {
+            pod(static_cast<uint64_t>(v.size()));
+            bytes(v.data(), v.size() * sizeof(T));
+        }
+
+       private:
+        std::FILE* f_;
+        bool ok_ = true;
+    };
+
+    // Bounds-checked cursor over a loaded sidecar. Any overrun latches
+    // ok() to false and yields zero values from then on.
+    class IndexReader
     {
-        assert(id.size() <= 8 &&
-               "VCD ID exceeds 8 bytes! Potential collision hazard.");
+       public:
+        explicit IndexReader(std::string_view data) : data_(data) {}
+
+        bool ok() const { return ok_; }
+        bool at_end() const { return pos_ == data_.size(); }
+
+        std::string_view bytes(size_t n)
+        {
+            if (!ok_ || n > data_.size() - pos_)
+            {
+                ok_ = false;
+                return {};
+            }
+            std::string_view v = data_.substr(pos_, n);
+            pos_ += n;
+            return v;
+        }
+
+        template <typename T>
+        T pod()
+        {
+            T v{};
+            std::string_view b = bytes(sizeof(T));
+            if (ok_) std::memcpy(&v, b.data(), sizeof(T));
+            return v;
+        }
+
+        std::string str() { return std::string(bytes(pod<uint32_t>())); }
+
+        template <typename T>
+        bool pod_vec(std::vector<T>& v)
+        {
+            uint64_t n = pod<uint64_t>();
+            if (n > (data_.size() - pos_) / sizeof(T)) ok_ = false;
+            if (!ok_) return false;
+            v.resize(static_cast<size_t>(n));
+            std::string_view b = bytes(v.size() * sizeof(T));
+            if (!v.empty()) std::memcpy(v.data(), b.data(), b.size());
+            return ok_;
+        }
+
+       private:
+        std::string_view data_;
+        size_t pos_ = 0;
+        bool ok_ = true;
+    };
 
-        uint64_t code = 0;
-        size_t len = std::min(static_cast<size_t>(8), id.size());
-        std::memcpy(&code, id.data(), len);
-        return code;
+    inline bool read_whole_file(const std::string& path, std::string& out)
+    {
+        std::FILE* f = std::fopen(path.c_str(), "rb");
+        if (!f) return false;
+        out.clear();
+        char buf[64 * 1024];
+        size_t n;
+        while ((n = std::fread(buf, 1, sizeof(buf), f)) > 0) out.append(buf, n);
+        bool ok = !std::ferror(f);
+        std::fclose(f);
+        return ok;
     }
 
     // ============================================================================
@@ -109,10 +275,38 @@ namespace vcd
         Phase phase = Phase::Idle;
 
         // --- Standard File I/O ---
+        // When the file can be mapped, chunks are parsed in place from
+        // `mapped`; file_handle stays open as the stdio fallback. A gzip
+        // file is read through `gzip` instead, and every offset below is
+        // into the decompressed text.
         std::FILE* file_handle = nullptr;
-        uint64_t file_total_size = 0;
+        MappedFile mapped;
+        GzipReader gzip;
+        uint64_t file_total_size = 0;  // gzip: a guess until indexed
+        uint64_t disk_size = 0;        // of the file itself
         uint64_t global_file_offset = 0;
 
+        // Workers open the file for themselves, which a gzip file can't
+        // support: it is only read serially.
+        bool can_split() const
+        {
+            return !file_path.empty() && !gzip.is_open();
+        }
+
+        size_t read_input(uint8_t* buf, size_t n)
+        {
+            if (gzip.is_open()) return gzip.read(buf, n);
+            return std::fread(buf, 1, n, file_handle);
+        }
+
+        void seek_input(uint64_t offset)
+        {
+            if (gzip.is_open())
+                gzip.seek(offset);
+            else
+                seek_file(file_handle, offset);
+        }
+
         enum class ParseState
         {
             Header,
@@ -128,14 +322,16 @@ namespace vcd
         std::string leftover;
         uint64_t leftover_file_offset = 0;  // absolute file offset of
                                             // leftover[0]
+        LineScanner line_scanner;  // classifies the buffer being processed
 
         // --- Metadata ---
         std::string date_str;
         std::string version_str;
         Timescale ts;
         std::vector<SignalDef> signal_defs;
-        std::unordered_map<uint64_t, std::vector<uint32_t>> id_to_index;
-        std::unordered_map<std::string, uint32_t> path_to_index;
+        IdTable id_table;      // built at $enddefinitions
+        PathIndex path_index;  // likewise
+        NamePool names;        // every name above points into it
         std::unique_ptr<ScopeNode> root;
         ScopeNode* current_scope = nullptr;
 
@@ -148,15 +344,85 @@ namespace vcd
         uint32_t num_1bit = 0;
         uint32_t num_multibit = 0;
         std::vector<uint64_t> current_state_1bit;
-        std::vector<std::string> current_state_multibit;
+        MultibitState current_state_multibit;  // by str_index
 
         // --- Indexing Phase ---
-        std::vector<Snapshot> snapshots;
+        SnapshotStore snapshots;  // keyframes + deltas, see snapshot_store.h
         uint64_t last_snapshot_file_offset = 0;
         bool past_first_snapshot = false;
-        static constexpr size_t SNAPSHOT_INTERVAL = 10 * 1024 * 1024;  // 10 MB
+        static constexpr uint64_t DEFAULT_SNAPSHOT_INTERVAL =
+            10 * 1024 * 1024;  // 10 MB
+        SnapshotPolicy snapshot_policy;
+        uint64_t snapshot_interval = DEFAULT_SNAPSHOT_INTERVAL;
         bool header_done = false;
 
+        // --- Transition Index (set_transition_index) ---
+        // For every 1-bit / multi-bit state slot, the ascending list of
+        // snapshot intervals containing a value change for it. Interval k
+        // spans [snapshots[k].file_offset, snapshots[k + 1].file_offset).
+        bool build_transition_index = false;
+        bool has_transition_index = false;
+        std::vector<std::vector<uint32_t>> touched_1bit;
+        std::vector<std::vector<uint32_t>> touched_multi;
+        // Slots changed in the interval after the latest snapshot, as
+        // bitsets; flush_touched() moves them into the lists in bulk, so a
+        // change costs one OR instead of a visit to its list.
+        std::vector<uint64_t> open_touched_1bit;
+        std::vector<uint64_t> open_touched_multi;
+
+        // --- Parallel Indexing ---
+        // The header and everything before the first '#' line are parsed
+        // serially; the data section is then split at '#' lines and scanned
+        // by worker threads (see index_step_parallel()).
+        std::string file_path;
+        unsigned index_threads = 1;
+        bool parallel_pending = false;  // switch over at the next '#' line
+        bool parallel_active = false;
+        uint64_t parallel_offset = 0;  // start of the next unscanned '#' line
+
+        // --- Live Tail (set_follow) ---
+        // Queries reuse the parse state, so where indexing stopped is set
+        // aside after every indexing pass and brought back to continue.
+        // file_total_size then ends at the last complete line indexed.
+        struct Frontier
+        {
+            ParseState parse_state = ParseState::Header;
+            uint64_t time = 0;
+            uint64_t offset = 0;  // global_file_offset
+            uint64_t leftover_offset = 0;
+            std::string leftover;
+            std::vector<uint64_t> state_1bit;
+            MultibitState state_multibit;
+        };
+        bool follow = false;
+        bool following = false;  // `frontier` holds an unfinished index
+        Frontier frontier;
+
+        void save_frontier()
+        {
+            flush_touched();
+            frontier.parse_state = parse_state;
+            frontier.time = current_time;
+            frontier.offset = global_file_offset;
+            frontier.leftover_offset = leftover_file_offset;
+            frontier.leftover = leftover;
+            frontier.state_1bit = current_state_1bit;
+            frontier.state_multibit = current_state_multibit;
+            following = true;
+            file_total_size = leftover_file_offset;
+        }
+
+        void restore_frontier()
+        {
+            parse_state = frontier.parse_state;
+            current_time = frontier.time;
+            global_file_offset = frontier.offset;
+            leftover_file_offset = frontier.leftover_offset;
+            leftover = frontier.leftover;
+            current_state_1bit = frontier.state_1bit;
+            current_state_multibit = frontier.state_multibit;
+        }
+
         // --- Query Phase ---
         uint64_t query_t_begin = 0;
         uint64_t query_t_end = 0;
@@ -165,18 +431,73 @@ namespace vcd
         bool query_done = false;  // set when current_time > query_t_end
         std::atomic<bool> query_cancel_flag{false};
 
+        // Parallel replay (set_query_threads): each step splits the bytes up
+        // to the read limit at '#' lines into one shard per thread. Shards
+        // only extract the queried signals' changes; merge_query_delta()
+        // feeds them in file order through the normal apply path.
+        unsigned query_threads = 1;
+
+        // Runs of consecutive intervals touched by the queried signals, as
+        // [first, last] interval indices. Only planned when a transition
+        // index exists; everything between runs is skipped.
+        struct IntervalRun
+        {
+            size_t first;
+            size_t last;
+        };
+        bool query_runs_active = false;
+        std::vector<IntervalRun> query_runs;
+        size_t query_run_pos = 0;
+
         // --- LOD (Downsampling) & Glitch State ---
+        // Query-local state is sized to the queried signals, by slot of
+        // query_slots. Like the result vectors, it keeps its capacity
+        // across queries, so panning over the same signals allocates
+        // nothing once the buffers have grown.
+        SignalSlots query_slots;
         LodManager lod_manager;
-        std::vector<int64_t> last_index_1bit;
-        std::vector<int64_t> last_index_multi;
+        ResultSegments segments;
+        QueryCache query_cache;
+        std::vector<int64_t> last_index_1bit;   // by slot
+        std::vector<int64_t> last_index_multi;  // by slot
+        std::vector<uint32_t> query_replay;     // scratch for narrowing
+        std::vector<bool> run_touched;          // scratch of plan_query_runs
+        std::vector<uint8_t> read_buffer;       // query_step, unmapped input
+
+        // --- Value Search (find_next) ---
+        static constexpr size_t SEARCH_CHUNK = 1024 * 1024;
+        LineScanner search_scanner;
+        std::string search_buffer;  // unmapped input, partial line carried
 
         std::vector<Transition1Bit> query_res_1bit;
         std::vector<TransitionMultiBit> query_res_multibit;
         std::string query_string_pool;
         QueryResultBinary binary_result = {};
 
-        // O(1) lookup: is a given signal index in the query set?
-        std::vector<bool> is_signal_queried;
+        // The query set as a bitset by signal index, see is_queried().
+        // Sized to every signal, but only the previous query's bits are
+        // cleared.
+        std::vector<uint64_t> queried_signals;
+
+        // --- Instrumentation (set_stats_enabled) ---
+        StatsRecorder stats;
+        uint64_t glitch_base = 0;    // lod_manager.glitch_count() at enable
+        size_t results_counted = 0;  // of this query, in changes_emitted
+
+        // --- LOD Pyramids (set_lod_pyramids) ---
+        // Built lazily: a whole-trace query with pixel_time_step > 0 records
+        // the changes of the queried signals that have no pyramid yet. Later
+        // zoomed-out queries for them are answered without any replay.
+        struct SignalLod
+        {
+            LodPyramid pyramid;
+            std::vector<std::string> values;  // multi-bit value ids
+            std::unordered_map<std::string, uint32_t> value_ids;
+        };
+        bool lod_pyramids_enabled = false;
+        std::vector<std::unique_ptr<SignalLod>> signal_lods;
+        std::vector<uint32_t> lod_building;  // recorded by this query
+        bool lod_recording = false;
 
         // ================================================================
         // Parsing Helpers
@@ -191,19 +512,39 @@ namespace vcd
             date_str.clear();
             version_str.clear();
             signal_defs.clear();
-            id_to_index.clear();
-            path_to_index.clear();
-            root.reset(new ScopeNode{"<root>", "", nullptr, {}, {}});
+            id_table.clear();
+            path_index.clear();
+            root = std::make_unique<ScopeNode>();
+            names.clear();
+            root->name = names.intern("<root>");
             current_scope = root.get();
             t_begin = t_end = current_time = 0;
             first_ts = true;
             num_1bit = num_multibit = 0;
             current_state_1bit.clear();
             current_state_multibit.clear();
-            snapshots.clear();
+            snapshots.reset(0, 0);
+            snapshot_interval = snapshot_policy.max_replay_bytes
+                                    ? snapshot_policy.max_replay_bytes
+                                    : DEFAULT_SNAPSHOT_INTERVAL;
             last_snapshot_file_offset = 0;
             past_first_snapshot = false;
             header_done = false;
+            has_transition_index = false;
+            touched_1bit.clear();
+            touched_multi.clear();
+            open_touched_1bit.clear();
+            open_touched_multi.clear();
+            query_runs_active = false;
+            query_runs.clear();
+            signal_lods.clear();
+            lod_building.clear();
+            lod_recording = false;
+            parallel_pending = parallel_active = false;
+            parallel_offset = 0;
+            following = false;
+            frontier = Frontier();
+            query_slots.clear();
             last_index_1bit.clear();
             last_index_multi.clear();
         }
@@ -231,14 +572,76 @@ namespace vcd
             uint32_t words = (num_1bit + 31) / 32;
             current_state_1bit.assign(
                 words, 0xAAAAAAAAAAAAAAAAULL);  // Fill with 'x' (10)
-            current_state_multibit.assign(num_multibit, "x");
-            is_signal_queried.assign(signal_defs.size(), false);
+            // Reserve each slot its declared width: values are at most one
+            // character per bit, so updates never reallocate.
+            std::vector<uint32_t> widths(num_multibit, 0);
+            for (const SignalDef& sig : signal_defs)
+                if (sig.width > 1) widths[sig.str_index] = sig.width;
+            current_state_multibit.assign(widths, "x");
+            queried_signals.assign((signal_defs.size() + 63) / 64, 0);
         }
 
-        // Apply a single value-change token.
-        // If `emit` is true and the signal is in the query set, record a
-        // transition.
-        void apply_value_change(std::string_view token, bool emit)
+        bool is_queried(uint32_t idx) const
+        {
+            return (queried_signals[idx / 64] >> (idx % 64)) & 1;
+        }
+
+        void mark_queried(uint32_t idx, bool queried)
+        {
+            if (idx / 64 >= queried_signals.size()) return;
+            uint64_t bit = 1ULL << (idx % 64);
+            uint64_t& word = queried_signals[idx / 64];
+            word = queried ? word | bit : word & ~bit;
+        }
+
+        // Record a change of `slot` in the interval after the latest
+        // snapshot, see flush_touched()
+        static void note_touch(std::vector<uint64_t>& open, uint32_t slot)
+        {
+            open[slot / 64] |= 1ULL << (slot % 64);
+        }
+
+        // Enter the slots changed in the interval after the latest snapshot
+        // into the transition index. Due before the next snapshot and when
+        // indexing stops. Changes before the first snapshot are part of its
+        // state and need no entry.
+        void flush_touched()
+        {
+            if (!has_transition_index) return;
+            bool before_first = snapshots.empty();
+            uint32_t k = static_cast<uint32_t>(snapshots.size() - 1);
+            auto flush = [&](std::vector<uint64_t>& open,
+                             std::vector<std::vector<uint32_t>>& lists)
+            {
+                for (size_t w = 0; w < open.size(); ++w)
+                {
+                    uint64_t m = before_first ? 0 : open[w];
+                    for (; m; m &= m - 1)
+                    {
+                        auto& intervals = lists[w * 64 + __builtin_ctzll(m)];
+                        if (intervals.empty() || intervals.back() != k)
+                            intervals.push_back(k);
+                    }
+                    open[w] = 0;
+                }
+            };
+            flush(open_touched_1bit, touched_1bit);
+            flush(open_touched_multi, touched_multi);
+        }
+
+        uint64_t interval_end(size_t k) const
+        {
+            return k + 1 < snapshots.size() ? snapshots[k + 1].file_offset
+                                            : file_total_size;
+        }
+
+        // Resolve a value-change token to the signals it targets and hand
+        // each one to the matching callback: on_1bit(idx, sig, v) or
+        // on_multi(idx, sig, value). Shared by the serial parser and the
+        // parallel index workers so both interpret tokens identically.
+        template <typename On1Bit, typename OnMulti>
+        void dispatch_value_change(std::string_view token, On1Bit&& on_1bit,
+                                   OnMulti&& on_multi) const
         {
             if (token.empty()) return;
 
@@ -266,29 +669,20 @@ namespace vcd
                 return;
             }
 
-            auto it = id_to_index.find(encode_id(id_tok));
-            if (it == id_to_index.end()) return;
-
-            for (uint32_t idx : it->second)
+            for (uint32_t idx : id_table.find(id_tok))
             {
-                auto& sig = signal_defs[idx];
-                bool is_queried = is_signal_queried[idx];
+                const SignalDef& sig = signal_defs[idx];
 
                 if (sig.width == 1 && is_1bit)
                 {
-                    uint8_t v = char_to_val2b(val_tok[0]);
-                    uint8_t old_v =
-                        get_1bit_state(current_state_1bit, sig.bit_index);
-
-                    if (emit && is_queried)
-                    {
-                        lod_manager.process_1bit(current_time, idx, v, old_v,
-                                                 query_res_1bit,
-                                                 last_index_1bit);
-                    }
-
-                    // Always update internal state
-                    set_1bit_state(current_state_1bit, sig.bit_index, v);
+                    on_1bit(idx, sig, char_to_val2b(val_tok[0]));
+                }
+                else if (sig.width == 1 && (c == 'b' || c == 'B') &&
+                         val_tok.size() > 1)
+                {
+                    // A vector value for a 1-bit signal ("b1 !"): its
+                    // last digit
+                    on_1bit(idx, sig, char_to_val2b(val_tok.back()));
                 }
                 else if (sig.width > 1)
                 {
@@ -297,25 +691,201 @@ namespace vcd
                     if (!multi_val.empty() &&
                         (multi_val[0] == 'b' || multi_val[0] == 'B'))
                         multi_val.remove_prefix(1);
+                    on_multi(idx, sig, multi_val);
+                }
+            }
+        }
+
+        // Apply a single value-change token.
+        // If `emit` is true and the signal is in the query set, record a
+        // transition.
+        void apply_value_change(std::string_view token, bool emit)
+        {
+            ++stats.counts().id_lookups;
+            dispatch_value_change(
+                token,
+                [&](uint32_t idx, const SignalDef& sig, uint8_t v)
+                { apply_1bit(idx, sig, v, emit); },
+                [&](uint32_t idx, const SignalDef& sig,
+                    std::string_view multi_val)
+                { apply_multi(idx, sig, multi_val, emit); });
+        }
+
+        void apply_1bit(uint32_t idx, const SignalDef& sig, uint8_t v,
+                        bool emit)
+        {
+            uint8_t old_v = get_1bit_state(current_state_1bit, sig.bit_index);
+            ++stats.counts().changes_applied;
+
+            if (emit && is_queried(idx))
+            {
+                lod_manager.process_1bit(current_time, idx, v, old_v,
+                                         query_res_1bit, last_index_1bit);
+            }
+            if (lod_recording && v != old_v) record_lod(idx, v);
+
+            // Always update internal state
+            set_1bit_state(current_state_1bit, sig.bit_index, v);
+            if (has_transition_index && phase == Phase::Indexing)
+                note_touch(open_touched_1bit, sig.bit_index);
+        }
+
+        void apply_multi(uint32_t idx, const SignalDef& sig,
+                         std::string_view multi_val, bool emit)
+        {
+            std::string_view old_v = current_state_multibit.get(sig.str_index);
+            ++stats.counts().changes_applied;
+
+            if (emit && is_queried(idx))
+            {
+                lod_manager.process_multibit(current_time, idx, multi_val,
+                                             old_v, query_res_multibit,
+                                             last_index_multi,
+                                             query_string_pool);
+            }
+            if (lod_recording && multi_val != old_v)
+                record_lod_multi(idx, multi_val);
+
+            // Always update internal state
+            current_state_multibit.set(sig.str_index, multi_val);
+            if (has_transition_index && phase == Phase::Indexing)
+                note_touch(open_touched_multi, sig.str_index);
+        }
+
+        // Split a data line into its value-change tokens. A line may carry
+        // several changes ("1! 0\" b1010 #"); vector/real tokens include
+        // their id after the blank. `blanks` must have scanned the buffer
+        // holding `line`.
+        template <typename Fn>
+        static void for_each_value_token(std::string_view line,
+                                         const LineScanner& blanks, Fn&& fn)
+        {
+            const size_t base = blanks.offset_of(line.data());
+            const size_t n = line.size();
+            auto next_blank = [&](size_t from)
+            { return std::min(blanks.next_blank(base + from) - base, n); };
+
+            size_t s_pos = 0;
+            while (s_pos < n)
+            {
+                char c = line[s_pos];
+                size_t end = next_blank(s_pos);
+                if (c == 'b' || c == 'B' || c == 'r' || c == 'R')
+                {
+                    if (end == n) break;  // no id
+                    end = next_blank(end + 1);
+                }
+                fn(line.substr(s_pos, end - s_pos));
+                s_pos = end + 1;
+            }
+        }
+
+        // Inline value change of a "$dumpvars 1! $end" style line, or an
+        // empty view if the line carries none.
+        static std::string_view dump_line_content(std::string_view line)
+        {
+            if (line.rfind("$dump", 0) != 0) return {};
+            size_t v_pos = line.find(' ');
+            if (v_pos == std::string_view::npos) return {};
+            std::string_view content = line.substr(v_pos + 1);
+            size_t e_pos = content.rfind("$end");
+            if (e_pos != std::string_view::npos)
+                content = content.substr(0, e_pos);
+            return trim(content);
+        }
+
+        // Record the state at current_time as a snapshot whose replay starts
+        // at the '#' line found at `file_offset`.
+        void push_snapshot(uint64_t file_offset)
+        {
+            flush_touched();
+            snapshots.push(current_time, file_offset, current_state_1bit,
+                           current_state_multibit);
+            last_snapshot_file_offset = file_offset;
+            enforce_memory_budget();
+        }
+
+        // Called once the header is known: widen the spacing up front so
+        // that the snapshots expected over the whole file fit the budget:
+        // one keyframe, then at most half a keyframe per delta snapshot.
+        void plan_snapshot_interval()
+        {
+            if (!snapshot_policy.memory_budget) return;
+            uint64_t keyframe = current_state_1bit.size() * sizeof(uint64_t) +
+                                num_multibit * sizeof(uint32_t);
+            uint64_t delta = sizeof(SnapshotStore::Entry) + keyframe / 2;
+            uint64_t fit =
+                snapshot_policy.memory_budget > keyframe
+                    ? 1 + (snapshot_policy.memory_budget - keyframe) / delta
+                    : 1;
+            snapshot_interval =
+                std::max(snapshot_interval, file_total_size / fit + 1);
+        }
 
-                    const std::string& old_v =
-                        current_state_multibit[sig.str_index];
+        // The value pool grows as the trace runs, so the estimate can fall
+        // short: whenever the budget is exceeded, drop every other snapshot
+        // and double the spacing. The first snapshot always stays.
+        void enforce_memory_budget()
+        {
+            while (snapshot_policy.memory_budget &&
+                   snapshots.memory_usage() > snapshot_policy.memory_budget &&
+                   snapshots.size() > 1)
+            {
+                snapshots.thin();
+                snapshot_interval *= 2;
+                last_snapshot_file_offset = snapshots.back().file_offset;
 
-                    if (emit && is_queried)
+                // Interval k now spans the old intervals 2k and 2k + 1
+                for (auto* slots : {&touched_1bit, &touched_multi})
+                {
+                    for (auto& list : *slots)
                     {
-                        lod_manager.process_multibit(
-                            current_time, idx, multi_val, old_v,
-                            query_res_multibit, last_index_multi,
-                            query_string_pool);
+                        size_t n = 0;
+                        for (uint32_t k : list)
+                            if (n == 0 || list[n - 1] != (k >> 1))
+                                list[n++] = k >> 1;
+                        list.resize(n);
                     }
-
-                    // Always update internal state
-                    current_state_multibit[sig.str_index] =
-                        std::string(multi_val);
                 }
             }
         }
 
+        // Snapshot placement, evaluated at every '#' line while indexing.
+        // Condition: we have accumulated >= snapshot_interval bytes since the
+        // last snapshot (or the beginning of file).
+        void on_index_timestamp(uint64_t line_abs_offset)
+        {
+            if (!past_first_snapshot)
+            {
+                // Take the very first snapshot at the first timestamp
+                // encountered in the data section.
+                push_snapshot(line_abs_offset);
+                past_first_snapshot = true;
+            }
+            else if (line_abs_offset >=
+                     last_snapshot_file_offset + snapshot_interval)
+            {
+                // Snapshot BEFORE updating to new_time: the snapshot records
+                // the state at current_time (all value changes up to but not
+                // past it).
+                push_snapshot(line_abs_offset);
+            }
+        }
+
+        void advance_time(uint64_t new_time)
+        {
+            current_time = new_time;
+            // A query replays part of the file; the dump's time range is
+            // only learned while indexing.
+            if (phase != Phase::Indexing) return;
+            if (first_ts)
+            {
+                t_begin = current_time;
+                first_ts = false;
+            }
+            t_end = current_time;
+        }
+
         // -----------------------------------------------------------------
         // process_buffer: parse a contiguous buffer of complete lines.
         //
@@ -326,11 +896,13 @@ namespace vcd
         // -----------------------------------------------------------------
         bool process_buffer(std::string_view buf, uint64_t buf_file_offset)
         {
+            ParserStats& counts = stats.counts();
+            counts.bytes_scanned += buf.size();
+            line_scanner.scan(buf);
             size_t pos = 0;
             while (pos < buf.size())
             {
-                size_t eol = buf.find('\n', pos);
-                if (eol == std::string_view::npos) eol = buf.size();
+                size_t eol = line_scanner.next_newline(pos);
                 std::string_view line = trim(buf.substr(pos, eol - pos));
 
                 // The absolute file offset of this line's start character
@@ -339,6 +911,17 @@ namespace vcd
                 pos = eol + 1;  // skip '\n'
 
                 if (line.empty()) continue;
+                ++counts.lines_parsed;
+
+                // Hand the data section over to the index workers at the
+                // first '#' line; everything before it is already applied.
+                if (parallel_pending && header_done && line[0] == '#')
+                {
+                    parallel_pending = false;
+                    parallel_active = true;
+                    parallel_offset = line_abs_offset;
+                    return false;
+                }
 
                 if (parse_state == ParseState::Header)
                 {
@@ -373,7 +956,21 @@ namespace vcd
             if (line.rfind("$enddefinitions", 0) == 0)
             {
                 header_done = true;
+                id_table.build(signal_defs);
+                path_index.build(root.get(), signal_defs);
                 prepare_states();
+                snapshots.reset(current_state_1bit.size(), num_multibit);
+                if (phase == Phase::Indexing) plan_snapshot_interval();
+                // Restart points at half the spacing keep a query's extra
+                // decompression below half an interval
+                gzip.set_checkpoint_span(snapshot_interval / 2);
+                if (has_transition_index)
+                {
+                    touched_1bit.assign(num_1bit, {});
+                    touched_multi.assign(num_multibit, {});
+                    open_touched_1bit.assign((num_1bit + 63) / 64, 0);
+                    open_touched_multi.assign((num_multibit + 63) / 64, 0);
+                }
             }
             else if (line.rfind("$dumpvars", 0) == 0)
             {
@@ -393,12 +990,8 @@ namespace vcd
                         name = trim(name.substr(0, end_kw));
 
                     auto child = std::make_unique<ScopeNode>();
-                    child->name = std::string(name);
+                    child->name = names.intern(name);
                     child->parent = current_scope;
-                    child->full_path =
-                        current_scope->full_path.empty()
-                            ? child->name
-                            : current_scope->full_path + "." + child->name;
                     current_scope->children.push_back(std::move(child));
                     current_scope = current_scope->children.back().get();
                 }
@@ -426,8 +1019,9 @@ namespace vcd
                     SignalDef sig;
                     sig.type = parseVarType(toks[1]);
                     sig.width = std::stoi(std::string(toks[2]));
-                    sig.id_code = std::string(toks[3]);
-                    sig.name = std::string(toks[4]);
+                    sig.id_code = names.add(toks[3]);
+                    sig.name = names.intern(toks[4]);
+                    sig.scope = current_scope;
 
                     // Parse bit range [msb:lsb] if present (e.g. $var wire 8 #
                     // data [7:0] $end)
@@ -444,10 +1038,6 @@ namespace vcd
                                 std::stoi(std::string(inner.substr(colon + 1)));
                         }
                     }
-                    sig.full_path =
-                        current_scope->full_path.empty()
-                            ? sig.name
-                            : current_scope->full_path + "." + sig.name;
                     sig.index = static_cast<uint32_t>(signal_defs.size());
 
                     if (sig.width == 1)
@@ -460,8 +1050,6 @@ namespace vcd
                     }
 
                     current_scope->signal_indices.push_back(sig.index);
-                    id_to_index[encode_id(sig.id_code)].push_back(sig.index);
-                    path_to_index[sig.full_path] = sig.index;
                     signal_defs.push_back(sig);
                 }
             }
@@ -492,51 +1080,14 @@ namespace vcd
         {
             if (line[0] == '#')
             {
-                uint64_t new_time = std::stoull(std::string(line.substr(1)));
+                uint64_t new_time = 0;
+                if (!parse_u64(line.substr(1), new_time)) return true;
 
-                // --- Indexing: snapshot creation ---
                 if (phase == Phase::Indexing)
-                {
-                    // Check if we should create a snapshot.
-                    // Condition: we have accumulated >= SNAPSHOT_INTERVAL
-                    // bytes since the last snapshot (or the beginning of file).
-                    if (!past_first_snapshot)
-                    {
-                        // Take the very first snapshot at the first timestamp
-                        // encountered in the data section.
-                        Snapshot snap;
-                        snap.time = current_time;
-                        snap.file_offset = line_abs_offset;
-                        snap.packed_1bit_states = current_state_1bit;
-                        snap.multibit_states = current_state_multibit;
-                        snapshots.push_back(std::move(snap));
-                        last_snapshot_file_offset = line_abs_offset;
-                        past_first_snapshot = true;
-                    }
-                    else if (line_abs_offset >=
-                             last_snapshot_file_offset + SNAPSHOT_INTERVAL)
-                    {
-                        // Snapshot BEFORE updating to new_time: the
-                        // snapshot records the state at current_time
-                        // (all value changes up to but not past it).
-                        Snapshot snap;
-                        snap.time = current_time;
-                        snap.file_offset = line_abs_offset;
-                        snap.packed_1bit_states = current_state_1bit;
-                        snap.multibit_states = current_state_multibit;
-                        snapshots.push_back(std::move(snap));
-                        last_snapshot_file_offset = line_abs_offset;
-                    }
-                }
+                    on_index_timestamp(line_abs_offset);
 
                 // Now update current_time
-                current_time = new_time;
-                if (first_ts)
-                {
-                    t_begin = current_time;
-                    first_ts = false;
-                }
-                t_end = current_time;
+                advance_time(new_time);
 
                 // --- Query: check early stop ---
                 if (phase == Phase::Querying)
@@ -556,22 +1107,8 @@ namespace vcd
             else if (line[0] == '$')
             {
                 // Handle $dumpvars/$dumpoff/$dumpon/$dumpall etc.
-                if (line.rfind("$dump", 0) == 0)
-                {
-                    size_t v_pos = line.find(' ');
-                    if (v_pos != std::string_view::npos)
-                    {
-                        std::string_view content = line.substr(v_pos + 1);
-                        size_t e_pos = content.rfind("$end");
-                        if (e_pos != std::string_view::npos)
-                            content = content.substr(0, e_pos);
-                        content = trim(content);
-                        if (!content.empty())
-                        {
-                            apply_value_change(content, false);
-                        }
-                    }
-                }
+                std::string_view content = dump_line_content(line);
+                if (!content.empty()) apply_value_change(content, false);
             }
             else
             {
@@ -580,33 +1117,21 @@ namespace vcd
                      current_time <= query_t_end);
 
                 // Parse value changes (possibly multiple on one line)
-                size_t s_pos = 0;
-                while (s_pos < line.size())
-                {
-                    std::string_view rem = line.substr(s_pos);
-                    if (rem[0] == 'b' || rem[0] == 'B' || rem[0] == 'r' ||
-                        rem[0] == 'R')
-                    {
-                        size_t sp1 = rem.find(' ');
-                        if (sp1 == std::string_view::npos) break;
-                        size_t sp2 = rem.find(' ', sp1 + 1);
-                        std::string_view tok = rem.substr(0, sp2);
-                        apply_value_change(tok, emit);
-                        s_pos += tok.size() + 1;
-                    }
-                    else
-                    {
-                        size_t sp = rem.find(' ');
-                        std::string_view tok = rem.substr(0, sp);
-                        apply_value_change(tok, emit);
-                        if (sp == std::string_view::npos) break;
-                        s_pos += sp + 1;
-                    }
-                }
+                for_each_value_token(line, line_scanner,
+                                     [&](std::string_view tok)
+                                     { apply_value_change(tok, emit); });
             }
             return true;
         }
 
+        QueryCache::Output cache_output()
+        {
+            return {query_res_1bit, last_index_1bit, query_res_multibit,
+                    last_index_multi, query_string_pool, query_slots};
+        }
+
+        // Signals continuing a cached prefix resume it instead; it ends in
+        // their current value
         void emit_query_initial_state()
         {
             for (uint32_t idx : query_signal_indices)
@@ -617,13 +1142,19 @@ namespace vcd
                 {
                     uint8_t v =
                         get_1bit_state(current_state_1bit, sig.bit_index);
+                    if (query_cache.resume_1bit(idx, v, lod_manager,
+                                                cache_output()))
+                        continue;
                     lod_manager.emit_initial_1bit(
                         query_t_begin, idx, v, query_res_1bit, last_index_1bit);
                 }
                 else
                 {
-                    const std::string& sv =
-                        current_state_multibit[sig.str_index];
+                    std::string_view sv =
+                        current_state_multibit.get(sig.str_index);
+                    if (query_cache.resume_multibit(idx, sv, lod_manager,
+                                                    cache_output()))
+                        continue;
                     lod_manager.emit_initial_multibit(
                         query_t_begin, idx, sv, query_res_multibit,
                         last_index_multi, query_string_pool);
@@ -632,67 +1163,1292 @@ namespace vcd
         }
 
         // -----------------------------------------------------------------
-        // push_chunk: shared logic for both indexing and query phases.
-        //
-        // Maintains a leftover buffer for incomplete lines.
-        // `chunk_file_offset` is the absolute offset in the original file
-        // where `data` begins.
-        //
-        // Returns true if more data is needed, false if done (query early
-        // stop).
+        // Transition-index query planning
         // -----------------------------------------------------------------
-        bool push_chunk(const uint8_t* data, size_t size,
-                        uint64_t chunk_file_offset)
-        {
-            // Concatenate leftover + new data
-            leftover.append(reinterpret_cast<const char*>(data), size);
-
-            // The absolute file offset of leftover[0] is
-            // leftover_file_offset (set when leftover was established).
-            // After appending, leftover[leftover_len] corresponds to
-            // chunk_file_offset.
-            // So leftover[0] corresponds to:
-            //   chunk_file_offset - leftover_len
-            // BUT leftover_file_offset was already set correctly when the
-            // leftover was saved. Verify consistency:
-            // leftover_file_offset should equal chunk_file_offset -
-            // leftover_len (This holds because we set it correctly below.)
-
-            uint64_t buf_file_offset = leftover_file_offset;
 
-            // Find the last newline - only process complete lines
-            size_t last_nl = leftover.find_last_of('\n');
-            if (last_nl == std::string::npos)
+        // Collect the intervals from `first` up to the one containing
+        // query_t_end in which any queried signal changes, merged into runs.
+        // The queried signals keep their snapshot value across the gaps, so
+        // only the runs need to be replayed.
+        void plan_query_runs(size_t first)
+        {
+            query_runs.clear();
+            query_run_pos = 0;
+            query_runs_active =
+                has_transition_index && first < snapshots.size();
+            if (!query_runs_active) return;
+
+            // Last interval whose opening snapshot is not past the window
+            const auto& entries = snapshots.entries();
+            auto after_end = std::upper_bound(
+                entries.begin() + first + 1, entries.end(), query_t_end,
+                [](uint64_t t, const SnapshotStore::Entry& s)
+                { return t < s.time; });
+            size_t last =
+                static_cast<size_t>(after_end - entries.begin()) - 1;
+
+            std::vector<bool>& touched = run_touched;
+            touched.assign(last - first + 1, false);
+            for (uint32_t idx : query_signal_indices)
             {
-                // No complete line yet; keep everything in leftover.
-                // leftover_file_offset stays unchanged.
-                return true;
+                if (idx >= signal_defs.size()) continue;
+                const SignalDef& sig = signal_defs[idx];
+                const std::vector<uint32_t>& list =
+                    sig.width == 1 ? touched_1bit[sig.bit_index]
+                                   : touched_multi[sig.str_index];
+                auto it = std::lower_bound(list.begin(), list.end(), first);
+                for (; it != list.end() && *it <= last; ++it)
+                    touched[*it - first] = true;
             }
 
-            // Process everything up to and including the last newline
-            std::string_view process_view(leftover.data(), last_nl + 1);
-            bool cont = process_buffer(process_view, buf_file_offset);
-
-            // Save the remainder as the new leftover
-            size_t remaining = leftover.size() - (last_nl + 1);
-            if (remaining > 0)
-            {
-                std::string new_leftover(leftover.data() + last_nl + 1,
-                                         remaining);
-                leftover_file_offset = buf_file_offset + last_nl + 1;
-                leftover = std::move(new_leftover);
-            }
-            else
+            for (size_t k = first; k <= last; ++k)
             {
-                leftover.clear();
-                leftover_file_offset = buf_file_offset + last_nl + 1;
+                if (!touched[k - first]) continue;
+                if (!query_runs.empty() && query_runs.back().last + 1 == k)
+                    query_runs.back().last = k;
+                else
+                    query_runs.push_back({k, k});
             }
-
-            return cont;
         }
-    };
 
-    // ============================================================================
+        // Continue replay at the start of interval k. Only the time needs
+        // restoring: the skipped bytes held no change to a queried signal.
+        void jump_to_interval(size_t k)
+        {
+            const SnapshotStore::Entry& snap = snapshots[k];
+            current_time = snap.time;
+            leftover.clear();
+            leftover_file_offset = global_file_offset = snap.file_offset;
+            if (mapped.is_mapped())
+                mapped.will_need(global_file_offset, snapshot_interval);
+            else if (file_handle)
+                seek_input(global_file_offset);
+        }
+
+        // Offset the next query read must stop at: the end of the current
+        // run (moving on to the next run once it is exhausted), or the end
+        // of the file without a plan. Equals global_file_offset once every
+        // run has been replayed.
+        uint64_t query_read_limit()
+        {
+            if (!query_runs_active) return file_total_size;
+            while (query_run_pos < query_runs.size())
+            {
+                uint64_t end = interval_end(query_runs[query_run_pos].last);
+                if (global_file_offset < end) return end;
+                if (++query_run_pos < query_runs.size())
+                    jump_to_interval(query_runs[query_run_pos].first);
+            }
+            return global_file_offset;
+        }
+
+        // Whether the query replay has read everything it is going to.
+        bool query_input_consumed() const
+        {
+            if (query_runs_active) return query_run_pos >= query_runs.size();
+            return global_file_offset >= file_total_size;
+        }
+
+        // -----------------------------------------------------------------
+        // Value search
+        // -----------------------------------------------------------------
+
+        // Feed the non-empty lines of [begin, end) to fn(line, scanner)
+        // until it returns false. Unmapped input is read in chunks from the
+        // input's own position, which a running query has to restore.
+        template <typename Fn>
+        void for_each_search_line(uint64_t begin, uint64_t end, Fn&& fn)
+        {
+            ParserStats& counts = stats.counts();
+            auto lines = [&](std::string_view buf)
+            {
+                counts.bytes_scanned += buf.size();
+                search_scanner.scan(buf);
+                for (size_t pos = 0; pos < buf.size();)
+                {
+                    size_t eol = search_scanner.next_newline(pos);
+                    std::string_view line = trim(buf.substr(pos, eol - pos));
+                    pos = eol + 1;
+                    if (line.empty()) continue;
+                    ++counts.lines_parsed;
+                    if (!fn(line, search_scanner)) return false;
+                }
+                return true;
+            };
+
+            if (mapped.is_mapped())
+            {
+                lines(mapped.view(begin, end - begin));
+                return;
+            }
+
+            std::string& buf = search_buffer;
+            buf.clear();
+            seek_input(begin);
+            for (uint64_t at = begin;;)
+            {
+                size_t want = static_cast<size_t>(
+                    std::min<uint64_t>(SEARCH_CHUNK, end - at));
+                size_t kept = buf.size();
+                buf.resize(kept + want);
+                size_t n =
+                    read_input(reinterpret_cast<uint8_t*>(&buf[kept]), want);
+                buf.resize(kept + n);
+                at += n;
+
+                // Only complete lines, except for the end of the range
+                bool last = n == 0 || at >= end;
+                size_t nl = buf.find_last_of('\n');
+                size_t complete = last                        ? buf.size()
+                                  : nl == std::string::npos ? 0
+                                                            : nl + 1;
+                if (!lines(std::string_view(buf).substr(0, complete)) || last)
+                    break;
+                buf.erase(0, complete);
+            }
+        }
+
+        // Value of `sig` in snapshot k, as the query results spell it
+        std::string search_value_at(size_t k, const SignalDef& sig) const
+        {
+            if (sig.width > 1)
+                return std::string(snapshots.value_at(k, sig.str_index));
+            uint64_t word = snapshots.word_at(k, sig.bit_index / 32);
+            return std::string(
+                1, val2b_to_char(static_cast<uint8_t>(
+                       word >> (sig.bit_index % 32) * 2)));
+        }
+
+        // Replay interval k for signal `idx` alone, calling
+        // on_change(time, old_v, new_v) per timestamp it changes at, with
+        // the values before and after that timestamp as the query results
+        // settle them, until it returns false or a '#' line passes `until`.
+        // Inline $dump values are applied unreported, as queries do.
+        template <typename Fn>
+        void search_interval(size_t k, uint32_t idx, uint64_t until,
+                             Fn&& on_change)
+        {
+            const SignalDef& sig = signal_defs[idx];
+            std::string_view id = sig.id_code;
+            std::string settled = search_value_at(k, sig);
+            std::string value = settled;
+            bool changed = false;
+            uint64_t time = snapshots[k].time;
+            bool more = true;
+
+            auto report = [&]
+            {
+                if (changed) more = on_change(time, settled, value);
+                settled = value;
+                changed = false;
+                return more;
+            };
+            auto apply = [&](std::string_view tok, bool silent)
+            {
+                // A token can only target the signal if it ends in its id,
+                // which spares the others the id lookup
+                if (tok.size() <= id.size() ||
+                    tok.substr(tok.size() - id.size()) != id)
+                    return;
+                ++stats.counts().id_lookups;
+                auto set = [&](std::string_view v)
+                {
+                    ++stats.counts().changes_applied;
+                    value.assign(v.data(), v.size());
+                    if (silent && !changed) settled = value;
+                    changed |= !silent;
+                };
+                dispatch_value_change(
+                    tok,
+                    [&](uint32_t i, const SignalDef&, uint8_t v)
+                    {
+                        char c = val2b_to_char(v);
+                        if (i == idx) set(std::string_view(&c, 1));
+                    },
+                    [&](uint32_t i, const SignalDef&, std::string_view v)
+                    {
+                        if (i == idx) set(v);
+                    });
+            };
+
+            for_each_search_line(
+                snapshots[k].file_offset, interval_end(k),
+                [&](std::string_view line, const LineScanner& scanner)
+                {
+                    if (line[0] == '#')
+                    {
+                        if (!report()) return false;
+                        uint64_t t = 0;
+                        if (parse_u64(line.substr(1), t)) time = t;
+                        return time <= until;
+                    }
+                    if (line[0] == '$')
+                    {
+                        std::string_view content = dump_line_content(line);
+                        if (!content.empty()) apply(content, true);
+                        return true;
+                    }
+                    for_each_value_token(line, scanner,
+                                         [&](std::string_view tok)
+                                         { apply(tok, false); });
+                    return true;
+                });
+            if (more && time <= until) report();
+        }
+
+        // The intervals in which `sig` changes, or null to search them all
+        const std::vector<uint32_t>* search_intervals(
+            const SignalDef& sig) const
+        {
+            if (!has_transition_index) return nullptr;
+            return sig.width == 1 ? &touched_1bit[sig.bit_index]
+                                  : &touched_multi[sig.str_index];
+        }
+
+        // The first match after `from`, starting at interval `first`: the
+        // one holding the changes right after `from`
+        SearchResult search_forward(uint32_t idx, const ValueMatcher& matcher,
+                                    uint64_t from, size_t first)
+        {
+            SearchResult found;
+            auto search = [&](size_t k)
+            {
+                search_interval(
+                    k, idx, UINT64_MAX,
+                    [&](uint64_t t, std::string_view old_v,
+                        std::string_view new_v)
+                    {
+                        if (t <= from || t <= t_begin ||
+                            !matcher.matches(old_v, new_v))
+                            return true;
+                        found = {true, t};
+                        return false;
+                    });
+                return found.found;
+            };
+
+            if (const std::vector<uint32_t>* list =
+                    search_intervals(signal_defs[idx]))
+            {
+                auto it = std::lower_bound(list->begin(), list->end(), first);
+                for (; it != list->end(); ++it)
+                    if (search(*it)) break;
+            }
+            else
+            {
+                for (size_t k = first; k < snapshots.size(); ++k)
+                    if (search(k)) break;
+            }
+            return found;
+        }
+
+        // The last match before `from` (> t_begin), walking down from
+        // interval `last`: the one holding the changes right before `from`
+        SearchResult search_backward(uint32_t idx,
+                                     const ValueMatcher& matcher,
+                                     uint64_t from, size_t last)
+        {
+            SearchResult found;
+            auto search = [&](size_t k)
+            {
+                search_interval(k, idx, from - 1,
+                                [&](uint64_t t, std::string_view old_v,
+                                    std::string_view new_v)
+                                {
+                                    if (t > t_begin &&
+                                        matcher.matches(old_v, new_v))
+                                        found = {true, t};
+                                    return true;
+                                });
+                return found.found;
+            };
+
+            if (const std::vector<uint32_t>* list =
+                    search_intervals(signal_defs[idx]))
+            {
+                auto it = std::upper_bound(list->begin(), list->end(), last);
+                while (it != list->begin())
+                    if (search(*--it)) break;
+            }
+            else
+            {
+                for (size_t k = last + 1; k-- > 0;)
+                    if (search(k)) break;
+            }
+            return found;
+        }
+
+        // -----------------------------------------------------------------
+        // LOD pyramids
+        // -----------------------------------------------------------------
+
+        SignalLod* lod_being_built(uint32_t idx) const
+        {
+            SignalLod* l = idx < signal_lods.size() ? signal_lods[idx].get()
+                                                    : nullptr;
+            return l && !l->pyramid.ready() ? l : nullptr;
+        }
+
+        void record_lod(uint32_t idx, uint8_t v)
+        {
+            if (SignalLod* l = lod_being_built(idx))
+                l->pyramid.add(current_time, v);
+        }
+
+        void record_lod_multi(uint32_t idx, std::string_view v)
+        {
+            SignalLod* l = lod_being_built(idx);
+            if (!l) return;
+            auto it = l->value_ids.find(std::string(v));
+            if (it == l->value_ids.end())
+            {
+                it = l->value_ids
+                         .emplace(std::string(v),
+                                  static_cast<uint32_t>(l->values.size()))
+                         .first;
+                l->values.emplace_back(v);
+            }
+            l->pyramid.add(current_time, it->second);
+        }
+
+        // Answer the queried signals whose pyramid has a level fine enough
+        // for `pixel_step`; the rest stay in query_signal_indices for replay.
+        void serve_from_lod(float pixel_step)
+        {
+            if (signal_lods.empty() || pixel_step <= 0.0f) return;
+
+            std::vector<uint32_t>& replay = query_replay;
+            replay.clear();
+            uint32_t glitch_offset = UINT32_MAX;
+            for (uint32_t idx : query_signal_indices)
+            {
+                const SignalLod* l =
+                    idx < signal_lods.size() ? signal_lods[idx].get() : nullptr;
+                int level = l ? l->pyramid.level_for(pixel_step) : -1;
+                if (level < 0)
+                {
+                    replay.push_back(idx);
+                    continue;
+                }
+
+                if (signal_defs[idx].width == 1)
+                {
+                    l->pyramid.emit_range(
+                        level, query_t_begin, query_t_end,
+                        [&](uint64_t t, uint32_t v, bool glitch)
+                        {
+                            uint8_t code =
+                                glitch ? 4 : static_cast<uint8_t>(v);
+                            query_res_1bit.push_back({t, idx, code, {0, 0, 0}});
+                        });
+                    continue;
+                }
+                l->pyramid.emit_range(
+                    level, query_t_begin, query_t_end,
+                    [&](uint64_t t, uint32_t v, bool glitch)
+                    {
+                        uint32_t offset, length;
+                        if (glitch)
+                        {
+                            if (glitch_offset == UINT32_MAX)
+                            {
+                                glitch_offset = static_cast<uint32_t>(
+                                    query_string_pool.size());
+                                query_string_pool.append("GLITCH");
+                            }
+                            offset = glitch_offset;
+                            length = 6;
+                        }
+                        else
+                        {
+                            offset =
+                                static_cast<uint32_t>(query_string_pool.size());
+                            length = static_cast<uint32_t>(l->values[v].size());
+                            query_string_pool.append(l->values[v]);
+                        }
+                        query_res_multibit.push_back(
+                            {t, idx, offset, length, 0});
+                    });
+            }
+            query_signal_indices.swap(replay);
+        }
+
+        // A replay from the first snapshot over the whole trace sees every
+        // change, so it can record pyramids for the signals it replays.
+        // Must run after the snapshot state has been restored.
+        void start_lod_builds(size_t snapshot_index, float pixel_step)
+        {
+            for (uint32_t idx : lod_building)
+                if (lod_being_built(idx)) signal_lods[idx].reset();
+            lod_building.clear();
+            lod_recording = false;
+
+            if (!lod_pyramids_enabled || pixel_step <= 0.0f ||
+                snapshot_index != 0 || snapshots.empty() ||
+                query_t_begin > t_begin || query_t_end < t_end)
+                return;
+
+            signal_lods.resize(signal_defs.size());
+            for (uint32_t idx : query_signal_indices)
+            {
+                if (idx >= signal_defs.size() || signal_lods[idx]) continue;
+                const SignalDef& sig = signal_defs[idx];
+                auto l = std::make_unique<SignalLod>();
+                uint32_t initial = 0;
+                if (sig.width == 1)
+                {
+                    initial = get_1bit_state(current_state_1bit, sig.bit_index);
+                }
+                else
+                {
+                    l->values.emplace_back(
+                        current_state_multibit.get(sig.str_index));
+                    l->value_ids.emplace(l->values.back(), 0);
+                }
+                l->pyramid.begin(t_begin, t_end, initial);
+                signal_lods[idx] = std::move(l);
+                lod_building.push_back(idx);
+            }
+            lod_recording = !lod_building.empty();
+        }
+
+        // Called once the replay has consumed all of its input.
+        void finish_lod_builds()
+        {
+            for (uint32_t idx : lod_building)
+            {
+                SignalLod* l = lod_being_built(idx);
+                if (!l) continue;
+                l->pyramid.finish();
+                l->value_ids = {};
+            }
+            lod_building.clear();
+            lod_recording = false;
+        }
+
+        // -----------------------------------------------------------------
+        // push_chunk: shared logic for both indexing and query phases.
+        //
+        // Maintains a leftover buffer for incomplete lines.
+        // `chunk_file_offset` is the absolute offset in the original file
+        // where `data` begins.
+        //
+        // Returns true if more data is needed, false if done (query early
+        // stop).
+        // -----------------------------------------------------------------
+        bool push_chunk(const uint8_t* data, size_t size,
+                        uint64_t chunk_file_offset)
+        {
+            // Concatenate leftover + new data
+            leftover.append(reinterpret_cast<const char*>(data), size);
+
+            // The absolute file offset of leftover[0] is
+            // leftover_file_offset (set when leftover was established).
+            // After appending, leftover[leftover_len] corresponds to
+            // chunk_file_offset.
+            // So leftover[0] corresponds to:
+            //   chunk_file_offset - leftover_len
+            // BUT leftover_file_offset was already set correctly when the
+            // leftover was saved. Verify consistency:
+            // leftover_file_offset should equal chunk_file_offset -
+            // leftover_len (This holds because we set it correctly below.)
+
+            uint64_t buf_file_offset = leftover_file_offset;
+
+            // Find the last newline - only process complete lines
+            size_t last_nl = leftover.find_last_of('\n');
+            if (last_nl == std::string::npos)
+            {
+                // No complete line yet; keep everything in leftover.
+                // leftover_file_offset stays unchanged.
+                return true;
+            }
+
+            // Process everything up to and including the last newline
+            std::string_view process_view(leftover.data(), last_nl + 1);
+            bool cont = process_buffer(process_view, buf_file_offset);
+
+            // Save the remainder as the new leftover
+            size_t remaining = leftover.size() - (last_nl + 1);
+            if (remaining > 0)
+            {
+                // In place, so the buffer keeps its capacity
+                leftover.erase(0, last_nl + 1);
+                leftover_file_offset = buf_file_offset + last_nl + 1;
+            }
+            else
+            {
+                leftover.clear();
+                leftover_file_offset = buf_file_offset + last_nl + 1;
+            }
+
+            return cont;
+        }
+
+        // -----------------------------------------------------------------
+        // push_mapped: zero-copy counterpart of push_chunk.
+        //
+        // With the file mapped, the incomplete line left by the previous
+        // step is just [leftover_file_offset, global_file_offset) of the
+        // mapping, so complete lines up to `end` are parsed in place and
+        // nothing is copied into `leftover`.
+        // -----------------------------------------------------------------
+        bool push_mapped(uint64_t end)
+        {
+            std::string_view pending = mapped.view(
+                leftover_file_offset, end - leftover_file_offset);
+
+            size_t last_nl = pending.find_last_of('\n');
+            if (last_nl == std::string_view::npos) return true;
+
+            bool cont = process_buffer(pending.substr(0, last_nl + 1),
+                                       leftover_file_offset);
+            leftover_file_offset += last_nl + 1;
+            return cont;
+        }
+
+        // Bytes already read but not parsed yet (an incomplete last line).
+        std::string_view pending_tail() const
+        {
+            if (mapped.is_mapped())
+                return mapped.view(leftover_file_offset,
+                                   global_file_offset - leftover_file_offset);
+            return leftover;
+        }
+
+        // ================================================================
+        // Index Sidecar
+        // ================================================================
+
+        // Bytes covered by the sidecar's header hash: everything before the
+        // first '#' line, i.e. the definitions and any leading $dumpvars.
+        uint64_t header_span() const
+        {
+            return snapshots.empty() ? file_total_size
+                                     : snapshots.front().file_offset;
+        }
+
+        // FNV-1a of file bytes [0, len), through the mapping when present.
+        bool hash_file_prefix(uint64_t len, uint64_t& hash)
+        {
+            if (len > file_total_size) return false;
+            if (mapped.is_mapped())
+            {
+                hash = fnv1a(mapped.view(0, len));
+                return true;
+            }
+            if (!file_handle) return false;
+
+            seek_input(0);
+            std::vector<char> buf(64 * 1024);
+            uint64_t h = fnv1a({});
+            while (len > 0)
+            {
+                size_t n =
+                    static_cast<size_t>(std::min<uint64_t>(len, buf.size()));
+                if (read_input(reinterpret_cast<uint8_t*>(buf.data()), n) !=
+                    n)
+                    return false;
+                h = fnv1a(std::string_view(buf.data(), n), h);
+                len -= n;
+            }
+            hash = h;
+            return true;
+        }
+
+        static void write_scope(IndexWriter& w, const ScopeNode& node)
+        {
+            w.str(node.name);
+            w.pod_vec(node.signal_indices);
+            w.pod(static_cast<uint32_t>(node.children.size()));
+            for (const auto& child : node.children) write_scope(w, *child);
+        }
+
+        bool read_scope(IndexReader& r, ScopeNode& node)
+        {
+            node.name = names.intern(r.str());
+            if (!r.pod_vec(node.signal_indices)) return false;
+            for (uint32_t idx : node.signal_indices)
+            {
+                if (idx >= signal_defs.size()) return false;
+                signal_defs[idx].scope = &node;
+            }
+
+            uint32_t child_count = r.pod<uint32_t>();
+            for (uint32_t i = 0; i < child_count && r.ok(); ++i)
+            {
+                auto child = std::make_unique<ScopeNode>();
+                child->parent = &node;
+                if (!read_scope(r, *child)) return false;
+                node.children.push_back(std::move(child));
+            }
+            return r.ok();
+        }
+
+        bool write_index(const std::string& index_path)
+        {
+            // A followed file is still growing
+            if (!header_done || phase == Phase::Indexing || following)
+                return false;
+
+            uint64_t vcd_size = 0;
+            int64_t vcd_mtime = 0;
+            uint64_t header_hash = 0;
+            uint64_t span = header_span();
+            if (!stat_file(file_path, vcd_size, vcd_mtime) ||
+                vcd_size != disk_size ||
+                (gzip.is_open() && !gzip.size_known()) ||
+                !hash_file_prefix(span, header_hash))
+                return false;
+
+            // Write next to the target and rename, so a crash or a reader
+            // racing the writer never sees a half-written sidecar.
+            std::string tmp_path = index_path + ".tmp";
+            std::FILE* f = std::fopen(tmp_path.c_str(), "wb");
+            if (!f) return false;
+
+            IndexWriter w(f);
+            w.bytes(INDEX_MAGIC, sizeof(INDEX_MAGIC));
+            w.pod(INDEX_VERSION);
+            w.pod(INDEX_BYTE_ORDER);
+            w.pod(vcd_size);
+            w.pod(vcd_mtime);
+            w.pod(file_total_size);
+            w.pod(span);
+            w.pod(header_hash);
+
+            w.str(date_str);
+            w.str(version_str);
+            w.pod(static_cast<int32_t>(ts.magnitude));
+            w.pod(ts.unit);
+            w.pod(t_begin);
+            w.pod(t_end);
+            w.pod(current_time);
+            w.pod(num_1bit);
+            w.pod(num_multibit);
+
+            w.pod(static_cast<uint64_t>(signal_defs.size()));
+            for (const SignalDef& sig : signal_defs)
+            {
+                w.str(sig.name);
+                w.str(sig.id_code);
+                w.pod(sig.type);
+                w.pod(static_cast<int32_t>(sig.width));
+                w.pod(static_cast<int32_t>(sig.msb));
+                w.pod(static_cast<int32_t>(sig.lsb));
+                w.pod(sig.bit_index);
+                w.pod(sig.str_index);
+            }
+            write_scope(w, *root);
+
+            snapshots.write(w);
+
+            w.pod(static_cast<uint8_t>(has_transition_index));
+            if (has_transition_index)
+            {
+                for (const auto& list : touched_1bit) w.pod_vec(list);
+                for (const auto& list : touched_multi) w.pod_vec(list);
+            }
+
+            w.pod(static_cast<uint8_t>(gzip.is_open()));
+            if (gzip.is_open()) gzip.save(w);
+
+            bool ok = w.ok();
+            ok = (std::fclose(f) == 0) && ok;
+#if defined(_WIN32)
+            if (ok) std::remove(index_path.c_str());  // rename won't replace
+#endif
+            if (ok) ok = std::rename(tmp_path.c_str(), index_path.c_str()) == 0;
+            if (!ok) std::remove(tmp_path.c_str());
+            return ok;
+        }
+
+        bool read_index(std::string_view data)
+        {
+            IndexReader r(data);
+            if (r.bytes(sizeof(INDEX_MAGIC)) !=
+                    std::string_view(INDEX_MAGIC, sizeof(INDEX_MAGIC)) ||
+                r.pod<uint32_t>() != INDEX_VERSION ||
+                r.pod<uint32_t>() != INDEX_BYTE_ORDER)
+                return false;
+
+            // Reject the sidecar if the VCD changed since it was written.
+            uint64_t vcd_size = r.pod<uint64_t>();
+            int64_t vcd_mtime = r.pod<int64_t>();
+            uint64_t data_size = r.pod<uint64_t>();
+            uint64_t span = r.pod<uint64_t>();
+            uint64_t header_hash = r.pod<uint64_t>();
+            uint64_t cur_size = 0;
+            int64_t cur_mtime = 0;
+            uint64_t cur_hash = 0;
+            if (!r.ok() || !stat_file(file_path, cur_size, cur_mtime) ||
+                cur_size != vcd_size || cur_size != disk_size ||
+                cur_mtime != vcd_mtime)
+                return false;
+            // Only the sidecar knows how large a gzip file's text is
+            if (gzip.is_open())
+                file_total_size = data_size;
+            else if (data_size != file_total_size)
+                return false;
+            if (!hash_file_prefix(span, cur_hash) || cur_hash != header_hash)
+                return false;
+
+            reset_state();
+            auto fail = [this]()
+            {
+                reset_state();
+                return false;
+            };
+
+            date_str = r.str();
+            version_str = r.str();
+            ts.magnitude = r.pod<int32_t>();
+            ts.unit = r.pod<TimeUnit>();
+            t_begin = r.pod<uint64_t>();
+            t_end = r.pod<uint64_t>();
+            current_time = r.pod<uint64_t>();
+            num_1bit = r.pod<uint32_t>();
+            num_multibit = r.pod<uint32_t>();
+            if (ts.unit > TimeUnit::FS) return fail();
+
+            uint64_t signal_count = r.pod<uint64_t>();
+            if (!r.ok() || signal_count > data.size()) return fail();
+            signal_defs.reserve(static_cast<size_t>(signal_count));
+            for (uint64_t i = 0; i < signal_count && r.ok(); ++i)
+            {
+                SignalDef sig;
+                sig.name = names.intern(r.str());
+                sig.id_code = names.add(r.str());
+                sig.type = r.pod<VarType>();
+                sig.width = r.pod<int32_t>();
+                sig.msb = r.pod<int32_t>();
+                sig.lsb = r.pod<int32_t>();
+                sig.bit_index = r.pod<uint32_t>();
+                sig.str_index = r.pod<uint32_t>();
+                sig.index = static_cast<uint32_t>(i);
+                bool slot_ok = sig.width == 1 ? sig.bit_index < num_1bit
+                                              : sig.str_index < num_multibit;
+                if (!slot_ok) return fail();
+                signal_defs.push_back(std::move(sig));
+            }
+            if (!r.ok() || !read_scope(r, *root)) return fail();
+
+            snapshots.reset((num_1bit + 31) / 32, num_multibit);
+            if (!snapshots.read(r, file_total_size)) return fail();
+            if (snapshot_policy.memory_budget &&
+                snapshots.memory_usage() > snapshot_policy.memory_budget)
+                return fail();
+
+            // A sidecar without a transition index doesn't satisfy a parser
+            // configured to build one; re-indexing writes a complete one.
+            has_transition_index = r.pod<uint8_t>() != 0;
+            if (build_transition_index && !has_transition_index) return fail();
+            if (has_transition_index)
+            {
+                touched_1bit.resize(num_1bit);
+                touched_multi.resize(num_multibit);
+                auto read_lists = [&](std::vector<std::vector<uint32_t>>& ls)
+                {
+                    for (auto& list : ls)
+                    {
+                        if (!r.pod_vec(list)) return false;
+                        for (uint32_t k : list)
+                            if (k >= snapshots.size()) return false;
+                    }
+                    return true;
+                };
+                if (!read_lists(touched_1bit) || !read_lists(touched_multi))
+                    return fail();
+            }
+            if ((r.pod<uint8_t>() != 0) != gzip.is_open()) return fail();
+            if (gzip.is_open() &&
+                (!gzip.restore(r) || gzip.size() != file_total_size))
+                return fail();
+            if (!r.ok() || !r.at_end()) return fail();
+
+            id_table.build(signal_defs);
+            path_index.build(root.get(), signal_defs);
+            prepare_states();
+
+            // Leave the parser exactly as finish_indexing() would.
+            header_done = true;
+            parse_state = ParseState::Data;
+            first_ts = snapshots.empty();
+            past_first_snapshot = !snapshots.empty();
+            last_snapshot_file_offset =
+                snapshots.empty() ? 0 : snapshots.back().file_offset;
+            global_file_offset = leftover_file_offset = file_total_size;
+            return true;
+        }
+
+        // ================================================================
+        // Parallel Indexing
+        // ================================================================
+
+        // Value changes scanned by one index worker. Workers only resolve
+        // ids and record deltas; merge_index_delta() replays them in file
+        // order so the snapshot chain matches the serial path exactly.
+        struct IndexDelta
+        {
+            struct TimeMark
+            {
+                uint64_t time;
+                uint64_t file_offset;  // start of the '#' line
+                size_t first_1bit;     // first change belonging to it
+                size_t first_multi;
+            };
+            struct Change1Bit
+            {
+                uint32_t bit_index;
+                uint8_t value;
+            };
+            struct ChangeMulti
+            {
+                uint32_t str_index;
+                uint32_t offset;  // into pool
+                uint32_t length;
+            };
+
+            std::vector<TimeMark> marks;
+            std::vector<Change1Bit> changes_1bit;
+            std::vector<ChangeMulti> changes_multi;
+            std::string pool;
+            uint64_t range_end = 0;  // where the next range starts
+
+            // For ParserStats, added up by the merge
+            uint64_t bytes = 0;
+            uint64_t lines = 0;
+            uint64_t lookups = 0;
+        };
+
+        // First offset >= `pos` that starts a '#' line, or the end of the
+        // file if there is none. Every worker splits at the same offsets, so
+        // adjacent ranges agree on their shared boundary without
+        // coordination.
+        static uint64_t find_timestamp_boundary(std::string_view data,
+                                                uint64_t pos)
+        {
+            if (pos == 0 || pos >= data.size())
+                return std::min<uint64_t>(pos, data.size());
+            size_t nl = data.find("\n#", static_cast<size_t>(pos - 1));
+            return nl == std::string_view::npos ? data.size() : nl + 1;
+        }
+
+        static uint64_t find_timestamp_boundary(std::FILE* f, uint64_t pos,
+                                                uint64_t file_size)
+        {
+            if (pos == 0 || pos >= file_size) return std::min(pos, file_size);
+
+            char buf[64 * 1024];
+            uint64_t at = pos - 1;  // include the byte before `pos`
+            char prev = 0;
+            seek_file(f, at);
+            while (at < file_size)
+            {
+                size_t n = std::fread(buf, 1, sizeof(buf), f);
+                if (n == 0) break;
+                for (size_t i = 0; i < n; ++i)
+                {
+                    if (prev == '\n' && buf[i] == '#' && at + i >= pos)
+                        return at + i;
+                    prev = buf[i];
+                }
+                at += n;
+            }
+            return file_size;
+        }
+
+        // Bytes of [begin, nominal_end) rounded to '#' line boundaries;
+        // `begin` is already a boundary when !align_begin. Without a
+        // mapping they are read into `buf` through a private FILE, so
+        // workers can load ranges concurrently. Sets [start, end) to the
+        // rounded range (end = file size if the file can't be opened).
+        std::string_view load_range(uint64_t begin, uint64_t nominal_end,
+                                    bool align_begin, std::string& buf,
+                                    uint64_t& start, uint64_t& end) const
+        {
+            start = begin;
+            if (mapped.is_mapped())
+            {
+                std::string_view all = mapped.view(0, file_total_size);
+                if (align_begin) start = find_timestamp_boundary(all, begin);
+                end = find_timestamp_boundary(all, nominal_end);
+                if (start >= end) return {};
+                return all.substr(start, end - start);
+            }
+
+            std::FILE* f = std::fopen(file_path.c_str(), "rb");
+            if (!f)
+            {
+                end = file_total_size;
+                return {};
+            }
+            if (align_begin)
+                start = find_timestamp_boundary(f, begin, file_total_size);
+            end = find_timestamp_boundary(f, nominal_end, file_total_size);
+            if (start < end)
+            {
+                buf.resize(static_cast<size_t>(end - start));
+                seek_file(f, start);
+                buf.resize(std::fread(&buf[0], 1, buf.size(), f));
+            }
+            std::fclose(f);
+            return start < end ? std::string_view(buf) : std::string_view();
+        }
+
+        // Scan [begin, nominal_end) rounded to '#' line boundaries. `begin`
+        // is already a boundary for the first worker of a batch.
+        void scan_index_range(uint64_t begin, uint64_t nominal_end,
+                              bool align_begin, IndexDelta& out) const
+        {
+            std::string buf;  // only used without a mapping
+            uint64_t start, end;
+            std::string_view view =
+                load_range(begin, nominal_end, align_begin, buf, start, end);
+
+            out.range_end = end;
+            if (start >= end) return;
+            out.bytes = view.size();
+
+            auto record = [&](std::string_view tok)
+            {
+                ++out.lookups;
+                dispatch_value_change(
+                    tok,
+                    [&](uint32_t, const SignalDef& sig, uint8_t v)
+                    { out.changes_1bit.push_back({sig.bit_index, v}); },
+                    [&](uint32_t, const SignalDef& sig, std::string_view val)
+                    {
+                        out.changes_multi.push_back(
+                            {sig.str_index,
+                             static_cast<uint32_t>(out.pool.size()),
+                             static_cast<uint32_t>(val.size())});
+                        out.pool.append(val);
+                    });
+            };
+
+            LineScanner scanner;
+            scanner.scan(view);
+            size_t pos = 0;
+            while (pos < view.size())
+            {
+                size_t eol = scanner.next_newline(pos);
+                std::string_view line = trim(view.substr(pos, eol - pos));
+                uint64_t line_abs_offset = start + pos;
+                pos = eol + 1;
+
+                if (line.empty()) continue;
+                ++out.lines;
+
+                uint64_t time = 0;
+                if (line[0] == '#')
+                {
+                    if (!parse_u64(line.substr(1), time)) continue;
+                    out.marks.push_back({time, line_abs_offset,
+                                         out.changes_1bit.size(),
+                                         out.changes_multi.size()});
+                }
+                else if (line[0] == '$')
+                {
+                    std::string_view content = dump_line_content(line);
+                    if (!content.empty()) record(content);
+                }
+                else
+                {
+                    for_each_value_token(line, scanner, record);
+                }
+            }
+        }
+
+        void merge_index_delta(const IndexDelta& d)
+        {
+            ParserStats& counts = stats.counts();
+            counts.bytes_scanned += d.bytes;
+            counts.lines_parsed += d.lines;
+            counts.id_lookups += d.lookups;
+            counts.changes_applied +=
+                d.changes_1bit.size() + d.changes_multi.size();
+
+            auto apply = [&](size_t b1, size_t e1, size_t bm, size_t em)
+            {
+                for (size_t i = b1; i < e1; ++i)
+                {
+                    const auto& c = d.changes_1bit[i];
+                    set_1bit_state(current_state_1bit, c.bit_index, c.value);
+                    if (has_transition_index)
+                        note_touch(open_touched_1bit, c.bit_index);
+                }
+                for (size_t i = bm; i < em; ++i)
+                {
+                    const auto& c = d.changes_multi[i];
+                    current_state_multibit.set(
+                        c.str_index,
+                        std::string_view(d.pool).substr(c.offset, c.length));
+                    if (has_transition_index)
+                        note_touch(open_touched_multi, c.str_index);
+                }
+            };
+
+            // Ranges start on a '#' line, so nothing precedes the first mark
+            // unless the range is the tail of a file without timestamps.
+            size_t n1 = d.marks.empty() ? d.changes_1bit.size()
+                                        : d.marks.front().first_1bit;
+            size_t nm = d.marks.empty() ? d.changes_multi.size()
+                                        : d.marks.front().first_multi;
+            apply(0, n1, 0, nm);
+
+            for (size_t m = 0; m < d.marks.size(); ++m)
+            {
+                const auto& mark = d.marks[m];
+                on_index_timestamp(mark.file_offset);
+                advance_time(mark.time);
+
+                bool last = (m + 1 == d.marks.size());
+                apply(mark.first_1bit,
+                      last ? d.changes_1bit.size() : d.marks[m + 1].first_1bit,
+                      mark.first_multi,
+                      last ? d.changes_multi.size()
+                           : d.marks[m + 1].first_multi);
+            }
+        }
+
+        // Scan the next `chunk_size * index_threads` bytes of the data
+        // section. Each worker gets one `chunk_size` slice; deltas are
+        // merged in order as soon as the corresponding worker finishes.
+        void index_batch_parallel(size_t chunk_size)
+        {
+            uint64_t begin = parallel_offset;
+            std::vector<IndexDelta> deltas(index_threads);
+            auto nominal = [&](unsigned i)
+            {
+                return std::min(file_total_size,
+                                begin + static_cast<uint64_t>(chunk_size) * i);
+            };
+
+#if WAVEFORM_HAVE_THREADS
+            std::vector<std::thread> workers;
+            workers.reserve(index_threads);
+            for (unsigned i = 0; i < index_threads; ++i)
+            {
+                workers.emplace_back(
+                    [this, &deltas, &nominal, i]
+                    {
+                        scan_index_range(nominal(i), nominal(i + 1), i > 0,
+                                         deltas[i]);
+                    });
+            }
+            for (unsigned i = 0; i < index_threads; ++i)
+            {
+                workers[i].join();
+                merge_index_delta(deltas[i]);
+                if (i + 1 < index_threads) deltas[i] = IndexDelta();
+            }
+#else
+            for (unsigned i = 0; i < index_threads; ++i)
+            {
+                scan_index_range(nominal(i), nominal(i + 1), i > 0, deltas[i]);
+                merge_index_delta(deltas[i]);
+                if (i + 1 < index_threads) deltas[i] = IndexDelta();
+            }
+#endif
+
+            // The last worker rounded its end up to the next '#' line.
+            parallel_offset = deltas.back().range_end;
+            leftover_file_offset = parallel_offset;
+        }
+
+        // ================================================================
+        // Parallel Query Replay
+        // ================================================================
+
+        // Changes of queried signals found by one query shard, in file
+        // order. Everything else in the shard is skipped: the queried
+        // signals' previous values live in the merging thread's state.
+        struct QueryDelta
+        {
+            struct Change
+            {
+                uint64_t time;
+                uint32_t signal;
+                uint32_t offset;  // multi-bit value in pool
+                uint32_t length;
+                uint8_t value;  // 1-bit value
+                bool emit;      // false for $dumpvars-style lines
+            };
+
+            std::vector<Change> changes;
+            std::string pool;
+            // Index of the first change after the first '#' line at or
+            // past query_t_begin, if the shard has one
+            size_t initial_at = SIZE_MAX;
+            bool stopped = false;  // hit a '#' line past query_t_end
+            bool has_time = false;
+            uint64_t last_time = 0;  // of the last '#' line parsed
+            uint64_t range_end = 0;
+
+            // For ParserStats, like IndexDelta's
+            uint64_t bytes = 0;
+            uint64_t lines = 0;
+            uint64_t lookups = 0;
+        };
+
+        void scan_query_range(uint64_t begin, uint64_t nominal_end,
+                              bool align_begin, QueryDelta& out) const
+        {
+            std::string buf;  // only used without a mapping
+            uint64_t start, end;
+            std::string_view view =
+                load_range(begin, nominal_end, align_begin, buf, start, end);
+
+            out.range_end = end;
+            if (start >= end) return;
+            out.bytes = view.size();
+
+            uint64_t time = 0;
+            bool emit = true;
+            auto record = [&](std::string_view tok)
+            {
+                ++out.lookups;
+                dispatch_value_change(
+                    tok,
+                    [&](uint32_t idx, const SignalDef&, uint8_t v)
+                    {
+                        if (is_queried(idx))
+                            out.changes.push_back({time, idx, 0, 0, v, emit});
+                    },
+                    [&](uint32_t idx, const SignalDef&, std::string_view val)
+                    {
+                        if (!is_queried(idx)) return;
+                        out.changes.push_back(
+                            {time, idx, static_cast<uint32_t>(out.pool.size()),
+                             static_cast<uint32_t>(val.size()), 0, emit});
+                        out.pool.append(val);
+                    });
+            };
+
+            LineScanner scanner;
+            scanner.scan(view);
+            size_t pos = 0;
+            while (pos < view.size())
+            {
+                size_t eol = scanner.next_newline(pos);
+                std::string_view line = trim(view.substr(pos, eol - pos));
+                pos = eol + 1;
+
+                if (line.empty()) continue;
+                ++out.lines;
+
+                if (line[0] == '#')
+                {
+                    if (!parse_u64(line.substr(1), time)) continue;
+                    out.has_time = true;
+                    out.last_time = time;
+                    if (out.initial_at == SIZE_MAX && time >= query_t_begin)
+                        out.initial_at = out.changes.size();
+                    if (time > query_t_end)
+                    {
+                        out.stopped = true;
+                        return;
+                    }
+                }
+                else if (line[0] == '$')
+                {
+                    std::string_view content = dump_line_content(line);
+                    emit = false;
+                    if (!content.empty()) record(content);
+                    emit = true;
+                }
+                else
+                {
+                    for_each_value_token(line, scanner, record);
+                }
+            }
+        }
+
+        // Apply one shard's changes exactly as the serial replay would have
+        void merge_query_delta(const QueryDelta& d)
+        {
+            ParserStats& counts = stats.counts();
+            counts.bytes_scanned += d.bytes;
+            counts.lines_parsed += d.lines;
+            counts.id_lookups += d.lookups;
+
+            auto emit_initial_if_due = [&](size_t i)
+            {
+                if (!query_initial_emitted && d.initial_at == i)
+                {
+                    emit_query_initial_state();
+                    query_initial_emitted = true;
+                }
+            };
+
+            for (size_t i = 0; i < d.changes.size(); ++i)
+            {
+                emit_initial_if_due(i);
+                const QueryDelta::Change& c = d.changes[i];
+                const SignalDef& sig = signal_defs[c.signal];
+                current_time = c.time;
+                bool emit = c.emit && query_initial_emitted;
+                if (sig.width == 1)
+                    apply_1bit(c.signal, sig, c.value, emit);
+                else
+                    apply_multi(
+                        c.signal, sig,
+                        std::string_view(d.pool).substr(c.offset, c.length),
+                        emit);
+            }
+            emit_initial_if_due(d.changes.size());
+            if (d.has_time) current_time = d.last_time;
+            if (d.stopped) query_done = true;
+        }
+
+        // Replay up to `chunk_size * query_threads` bytes before `limit`,
+        // one shard per thread, merging shards in order.
+        void query_batch_parallel(size_t chunk_size, uint64_t limit)
+        {
+            uint64_t begin = global_file_offset;
+            std::vector<QueryDelta> deltas(query_threads);
+            auto nominal = [&](unsigned i)
+            {
+                return std::min(limit,
+                                begin + static_cast<uint64_t>(chunk_size) * i);
+            };
+
+#if WAVEFORM_HAVE_THREADS
+            std::vector<std::thread> workers;
+            workers.reserve(query_threads);
+            for (unsigned i = 0; i < query_threads; ++i)
+            {
+                workers.emplace_back(
+                    [this, &deltas, &nominal, i]
+                    {
+                        scan_query_range(nominal(i), nominal(i + 1), i > 0,
+                                         deltas[i]);
+                    });
+            }
+            for (unsigned i = 0; i < query_threads; ++i)
+            {
+                workers[i].join();
+                if (!query_done) merge_query_delta(deltas[i]);
+                if (i + 1 < query_threads) deltas[i] = QueryDelta();
+            }
+#else
+            for (unsigned i = 0; i < query_threads; ++i)
+            {
+                scan_query_range(nominal(i), nominal(i + 1), i > 0, deltas[i]);
+                if (!query_done) merge_query_delta(deltas[i]);
+                if (i + 1 < query_threads) deltas[i] = QueryDelta();
+            }
+#endif
+
+            // The last shard rounded its end up to the next '#' line, and
+            // `limit` is either one or the end of the file.
+            global_file_offset = leftover_file_offset =
+                std::min(limit, deltas.back().range_end);
+        }
+    };
+
+    // ============================================================================
     // VcdParser public API
     // ============================================================================
 
@@ -721,18 +2477,14 @@ namespace vcd
 
     const SignalDef* VcdParser::find_signal(const std::string& full_path) const
     {
-        auto it = impl_->path_to_index.find(full_path);
-        return (it != impl_->path_to_index.end())
-                   ? &impl_->signal_defs[it->second]
-                   : nullptr;
+        uint32_t idx = impl_->path_index.find(full_path);
+        return idx != PathIndex::NONE ? &impl_->signal_defs[idx] : nullptr;
     }
 
     uint32_t VcdParser::find_signal_by_id(const std::string& id_code) const
     {
-        auto it = impl_->id_to_index.find(encode_id(id_code));
-        return (it != impl_->id_to_index.end() && !it->second.empty())
-                   ? it->second.front()
-                   : UINT32_MAX;
+        IdTable::Aliases ids = impl_->id_table.find(id_code);
+        return ids.empty() ? UINT32_MAX : *ids.begin();
     }
 
     // ========================================================================
@@ -741,26 +2493,53 @@ namespace vcd
 
     bool VcdParser::open_file(const std::string& filepath)
     {
+        StatsRecorder::Span span(impl_->stats, ParserPhase::Open);
         close_file();
         impl_->file_handle = std::fopen(filepath.c_str(), "rb");
         if (!impl_->file_handle) return false;
+        impl_->file_path = filepath;
 
         // Use standard C-style fseek to seek to end and get size
         std::fseek(impl_->file_handle, 0, SEEK_END);
         impl_->file_total_size = std::ftell(impl_->file_handle);
         std::fseek(impl_->file_handle, 0, SEEK_SET);
+        impl_->disk_size = impl_->file_total_size;
         impl_->global_file_offset = 0;
+
+        // Compressed input is decoded as it is read, never mapped. Until
+        // indexed, its compressed size stands in for the text's.
+        if (GzipReader::is_gzip(impl_->file_handle))
+        {
+            if (impl_->gzip.open(impl_->file_handle, impl_->disk_size))
+                return true;
+            close_file();
+            return false;
+        }
+
+        // Parse straight out of the page cache where mmap is available
+        impl_->mapped.map(filepath);
         return true;
     }
 
+    uint64_t VcdParser::input_position() const
+    {
+        return impl_->gzip.is_open() ? impl_->gzip.input_position()
+                                     : impl_->global_file_offset;
+    }
+
     void VcdParser::close_file()
     {
+        impl_->gzip.close();
         if (impl_->file_handle)
         {
             std::fclose(impl_->file_handle);
             impl_->file_handle = nullptr;
         }
-        impl_->file_total_size = 0;
+        impl_->mapped.unmap();
+        impl_->file_path.clear();
+        impl_->query_cache.clear();
+        impl_->following = false;
+        impl_->file_total_size = impl_->disk_size = 0;
         impl_->global_file_offset = 0;
     }
 
@@ -768,43 +2547,149 @@ namespace vcd
     // Indexing Phase
     // ========================================================================
 
+    void VcdParser::set_index_threads(unsigned threads)
+    {
+#if WAVEFORM_HAVE_THREADS
+        if (threads == 0) threads = std::thread::hardware_concurrency();
+        impl_->index_threads = std::max(1u, threads);
+#else
+        (void)threads;
+        impl_->index_threads = 1;
+#endif
+    }
+
+    void VcdParser::set_query_threads(unsigned threads)
+    {
+#if WAVEFORM_HAVE_THREADS
+        if (threads == 0) threads = std::thread::hardware_concurrency();
+        impl_->query_threads = std::max(1u, threads);
+#else
+        (void)threads;
+        impl_->query_threads = 1;
+#endif
+    }
+
+    void VcdParser::set_snapshot_policy(const SnapshotPolicy& policy)
+    {
+        impl_->snapshot_policy = policy;
+    }
+
+    void VcdParser::set_transition_index(bool enabled)
+    {
+        impl_->build_transition_index = enabled;
+    }
+
+    void VcdParser::set_lod_pyramids(bool enabled)
+    {
+        impl_->lod_pyramids_enabled = enabled;
+        if (!enabled) impl_->signal_lods.clear();
+    }
+
+    void VcdParser::set_query_cache_budget(size_t bytes)
+    {
+        impl_->query_cache.set_budget(bytes);
+    }
+    const QueryCache::Stats& VcdParser::query_cache_stats() const
+    {
+        return impl_->query_cache.stats();
+    }
+
     void VcdParser::begin_indexing()
     {
         impl_->reset_state();
+        impl_->query_cache.clear();
         impl_->phase = Impl::Phase::Indexing;
+        impl_->has_transition_index = impl_->build_transition_index;
+        impl_->parallel_pending =
+            impl_->index_threads > 1 && impl_->can_split() && !impl_->follow;
 
         if (impl_->file_handle)
         {
-            std::fseek(impl_->file_handle, 0, SEEK_SET);
+            impl_->seek_input(0);
             impl_->global_file_offset = 0;
         }
+        impl_->mapped.advise_sequential();
     }
 
     size_t VcdParser::index_step(size_t chunk_size)
     {
         if (impl_->phase != Impl::Phase::Indexing || !impl_->file_handle)
             return 0;
+        StatsRecorder::Span span(impl_->stats, ParserPhase::Index);
+        if (impl_->parallel_active) return index_step_parallel(chunk_size);
+
+        if (impl_->mapped.is_mapped())
+        {
+            uint64_t begin = impl_->global_file_offset;
+            if (begin >= impl_->file_total_size) return 0;
+            uint64_t end = std::min<uint64_t>(impl_->file_total_size,
+                                              begin + chunk_size);
+
+            impl_->push_mapped(end);
+            impl_->global_file_offset = end;
+
+            size_t bytes = static_cast<size_t>(end - begin);
+            if (impl_->parallel_active)
+                return bytes + index_step_parallel(chunk_size);
+            return bytes;
+        }
 
         std::vector<uint8_t> buffer(chunk_size);
-        size_t bytes_read =
-            std::fread(buffer.data(), 1, chunk_size, impl_->file_handle);
+        size_t bytes_read = impl_->read_input(buffer.data(), chunk_size);
 
         if (bytes_read > 0)
         {
             impl_->push_chunk(buffer.data(), bytes_read,
                               impl_->global_file_offset);
             impl_->global_file_offset += bytes_read;
+
+            // The serial pass stopped at the first '#' line; the rest of
+            // this chunk is rescanned by the workers.
+            if (impl_->parallel_active)
+            {
+                impl_->leftover.clear();
+                return bytes_read + index_step_parallel(chunk_size);
+            }
         }
 
         return bytes_read;
     }
 
+    size_t VcdParser::index_step_parallel(size_t chunk_size)
+    {
+        // global_file_offset counts the bytes reported so far, which may
+        // run ahead of parallel_offset right after the serial hand-over.
+        uint64_t reported = impl_->global_file_offset;
+        while (impl_->parallel_offset < impl_->file_total_size)
+        {
+            impl_->index_batch_parallel(std::max<size_t>(chunk_size, 1));
+            if (impl_->parallel_offset > reported) break;
+        }
+        if (impl_->parallel_offset <= reported) return 0;
+
+        impl_->global_file_offset = impl_->parallel_offset;
+        return static_cast<size_t>(impl_->parallel_offset - reported);
+    }
+
     void VcdParser::finish_indexing()
     {
+        StatsRecorder::Span span(impl_->stats, ParserPhase::Index);
+
+        // A live file's last line may still be half written
+        if (impl_->follow && impl_->phase == Impl::Phase::Indexing &&
+            !impl_->gzip.is_open())
+        {
+            impl_->save_frontier();
+            impl_->parallel_active = false;
+            impl_->phase = Impl::Phase::Idle;
+            return;
+        }
+
         // Process any remaining leftover
-        if (!impl_->leftover.empty())
+        std::string_view tail = impl_->pending_tail();
+        if (!tail.empty())
         {
-            impl_->process_buffer(impl_->leftover, impl_->leftover_file_offset);
+            impl_->process_buffer(tail, impl_->leftover_file_offset);
             impl_->leftover.clear();
         }
 
@@ -812,19 +2697,113 @@ namespace vcd
         if (impl_->snapshots.empty() ||
             impl_->snapshots.back().time < impl_->current_time)
         {
-            Snapshot snap;
-            snap.time = impl_->current_time;
-            // Point to "end of file" - this snapshot won't be seeked to for
-            // re-reading, it's just for completeness.
-            snap.file_offset = impl_->leftover_file_offset;  // approximate EOF
-            snap.packed_1bit_states = impl_->current_state_1bit;
-            snap.multibit_states = impl_->current_state_multibit;
-            impl_->snapshots.push_back(std::move(snap));
+            // Point past everything consumed: the state already includes
+            // the last (possibly unterminated) line, and the interval before
+            // it must end at EOF for the transition index.
+            impl_->push_snapshot(impl_->global_file_offset);
         }
+        impl_->flush_touched();  // changes after an up-to-date last snapshot
+
+        // The text's size is only known once all of it was decompressed
+        if (impl_->gzip.is_open())
+            impl_->file_total_size = impl_->global_file_offset;
 
+        impl_->parallel_active = false;
         impl_->phase = Impl::Phase::Idle;
     }
 
+    // ========================================================================
+    // Live Tail
+    // ========================================================================
+
+    void VcdParser::set_follow(bool enabled)
+    {
+        impl_->follow = enabled;
+        if (enabled || !impl_->following ||
+            impl_->phase == Impl::Phase::Indexing)
+            return;
+
+        // Pick up where indexing stopped and finish it normally
+        uint64_t old_end = impl_->t_end;
+        impl_->restore_frontier();
+        impl_->following = false;
+        impl_->phase = Impl::Phase::Indexing;
+        if (!impl_->mapped.is_mapped())
+            impl_->seek_input(impl_->global_file_offset);
+        finish_indexing();
+        impl_->file_total_size = impl_->global_file_offset;
+        impl_->query_cache.truncate(old_end);
+        impl_->signal_lods.clear();
+    }
+
+    size_t VcdParser::follow_step(size_t chunk_size)
+    {
+        if (!impl_->following || !impl_->follow ||
+            impl_->phase == Impl::Phase::Indexing)
+            return 0;
+
+        uint64_t size = 0;
+        int64_t mtime = 0;
+        if (!stat_file(impl_->file_path, size, mtime) ||
+            size <= impl_->frontier.offset)
+            return 0;
+
+        // The mapping has the old size: map the file again, or for the
+        // first time if it was empty when opened
+        bool was_mapped = impl_->mapped.is_mapped();
+        impl_->mapped.map(impl_->file_path);
+        impl_->disk_size = impl_->file_total_size = size;
+
+        uint64_t old_end = impl_->t_end;
+        impl_->restore_frontier();
+        if (was_mapped != impl_->mapped.is_mapped())
+        {
+            // The two paths keep the pending line differently: read it again
+            impl_->leftover.clear();
+            impl_->global_file_offset = impl_->leftover_file_offset;
+        }
+        impl_->phase = Impl::Phase::Indexing;
+        if (!impl_->mapped.is_mapped())
+            impl_->seek_input(impl_->global_file_offset);
+        size_t bytes = index_step(chunk_size);
+        impl_->save_frontier();
+        impl_->phase = Impl::Phase::Idle;
+
+        // Changes at the old end time may continue in the new bytes
+        impl_->query_cache.truncate(old_end);
+        impl_->signal_lods.clear();
+        return bytes;
+    }
+
+    // ========================================================================
+    // Index Persistence
+    // ========================================================================
+
+    bool VcdParser::save_index(const std::string& index_path) const
+    {
+        return impl_->write_index(index_path);
+    }
+
+    bool VcdParser::load_index(const std::string& index_path)
+    {
+        if (!impl_->file_handle || impl_->phase == Impl::Phase::Indexing)
+            return false;
+        StatsRecorder::Span span(impl_->stats, ParserPhase::LoadIndex);
+
+        // Snapshots are copied out of the sidecar, so the mapping (or the
+        // fallback buffer) only has to live for the duration of the load.
+        MappedFile sidecar;
+        std::string buffer;
+        std::string_view data;
+        if (sidecar.map(index_path))
+            data = sidecar.view(0, sidecar.size());
+        else if (read_whole_file(index_path, buffer))
+            data = buffer;
+        else
+            return false;
+        return impl_->read_index(data);
+    }
+
     // ========================================================================
     // Query Phase
     // ========================================================================
@@ -846,7 +2825,7 @@ namespace vcd
         }
         size_t si = (lo > 0) ? lo - 1 : 0;
 
-        const Snapshot& snap = impl_->snapshots[si];
+        const SnapshotStore::Entry& snap = impl_->snapshots[si];
         plan.file_offset = snap.file_offset;
         plan.snapshot_time = snap.time;
         plan.snapshot_index = si;
@@ -857,6 +2836,12 @@ namespace vcd
                                 const std::vector<uint32_t>& signal_indices,
                                 size_t snapshot_index, float pixel_step)
     {
+        StatsRecorder::Span span(impl_->stats, ParserPhase::BeginQuery);
+
+        // Unmark the previous query's signals before its slots go
+        for (uint32_t idx : impl_->query_slots.signals())
+            impl_->mark_queried(idx, false);
+
         impl_->phase = Impl::Phase::Querying;
         impl_->query_t_begin = start_time;
         impl_->query_t_end = end_time;
@@ -866,19 +2851,53 @@ namespace vcd
         impl_->query_res_1bit.clear();
         impl_->query_res_multibit.clear();
         impl_->query_string_pool.clear();
+        impl_->results_counted = 0;
         impl_->query_cancel_flag.store(false);
-
-        size_t n_sigs = impl_->signal_defs.size();
-        impl_->lod_manager.reset(n_sigs, pixel_step);
-        impl_->last_index_1bit.assign(n_sigs, -1);
-        impl_->last_index_multi.assign(n_sigs, -1);
+        impl_->leftover.clear();
+
+        // Slots cover every requested signal, including those served from
+        // pyramids or the cache below
+        impl_->query_slots.assign(signal_indices, impl_->signal_defs.size());
+        size_t n_slots = impl_->query_slots.size();
+        impl_->lod_manager.reset(impl_->query_slots, pixel_step);
+        impl_->last_index_1bit.assign(n_slots, -1);
+        impl_->last_index_multi.assign(n_slots, -1);
+        impl_->segments.reset();
+
+        impl_->serve_from_lod(pixel_step);
+
+        // Cached results leave one gap to replay, possibly from a later
+        // snapshot
+        impl_->query_cache.begin(start_time, end_time, pixel_step,
+                                 impl_->query_signal_indices,
+                                 impl_->query_replay, impl_->query_t_begin,
+                                 impl_->query_t_end, impl_->lod_manager,
+                                 impl_->cache_output());
+        impl_->query_signal_indices.swap(impl_->query_replay);
+        // Replay from a snapshot before query_t_begin, not one holding the
+        // changes at it: the cache needs those as changes, to continue
+        // glitch detection through them and to tell whether the first
+        // record is a change of its own
+        if (impl_->query_t_begin > 0)
+        {
+            size_t before =
+                get_query_plan(impl_->query_t_begin - 1).snapshot_index;
+            snapshot_index = impl_->query_t_begin > start_time
+                                 ? std::max(snapshot_index, before)
+                                 : std::min(snapshot_index, before);
+        }
+        impl_->plan_query_runs(snapshot_index);
 
         // Restore state from the specified snapshot
         if (snapshot_index < impl_->snapshots.size())
         {
-            const Snapshot& snap = impl_->snapshots[snapshot_index];
-            impl_->current_state_1bit = snap.packed_1bit_states;
-            impl_->current_state_multibit = snap.multibit_states;
+            StatsRecorder::Span restore(impl_->stats,
+                                        ParserPhase::SnapshotRestore);
+            const SnapshotStore::Entry& snap =
+                impl_->snapshots[snapshot_index];
+            impl_->snapshots.restore(snapshot_index,
+                                     impl_->current_state_1bit,
+                                     impl_->current_state_multibit);
             impl_->current_time = snap.time;
             impl_->leftover_file_offset = snap.file_offset;
             impl_->global_file_offset = snap.file_offset;
@@ -887,35 +2906,44 @@ namespace vcd
         {
             impl_->prepare_states();
             impl_->current_time = 0;
+            impl_->leftover_file_offset = 0;
             impl_->global_file_offset = 0;
         }
+        impl_->start_lod_builds(snapshot_index, pixel_step);
 
-        if (impl_->file_handle)
+        if (impl_->mapped.is_mapped())
         {
-            // Seek to the point in the file from the snapshot
-            // On large files fseeko (fseek with offset_t) is preferred if
-            // offset > 2GB but standard fseek might wrap. Assuming fseek works
-            // or requires platform-specific like fseeko64
-#if defined(_WIN32)
-            _fseeki64(impl_->file_handle, impl_->global_file_offset, SEEK_SET);
-#else
-            fseeko(impl_->file_handle, impl_->global_file_offset, SEEK_SET);
-#endif
+            // Queries jump between snapshots: no readahead across the whole
+            // file, but prefetch the interval we are about to replay.
+            impl_->mapped.advise_random();
+            impl_->mapped.will_need(impl_->global_file_offset,
+                                    impl_->snapshot_interval);
+        }
+        else if (impl_->file_handle)
+        {
+            // Seek to the point in the file from the snapshot (for gzip,
+            // from the checkpoint before it)
+            impl_->seek_input(impl_->global_file_offset);
         }
 
+        // Skip leading intervals that don't touch any queried signal
+        if (!impl_->query_runs.empty() &&
+            impl_->query_runs.front().first != snapshot_index)
+            impl_->jump_to_interval(impl_->query_runs.front().first);
+
         // Switch to data-section parsing (we're seeking past the header)
         impl_->parse_state = Impl::ParseState::Data;
 
-        // Mark actively queried signals for O(1) lookup
-        std::fill(impl_->is_signal_queried.begin(),
-                  impl_->is_signal_queried.end(), false);
-        for (uint32_t idx : signal_indices)
+        // Everything was answered from LOD pyramids: nothing to replay
+        if (impl_->query_signal_indices.empty())
         {
-            if (idx < impl_->is_signal_queried.size())
-            {
-                impl_->is_signal_queried[idx] = true;
-            }
+            impl_->query_initial_emitted = true;
+            impl_->query_done = true;
         }
+
+        // Mark actively queried signals for O(1) lookup
+        for (uint32_t idx : impl_->query_signal_indices)
+            impl_->mark_queried(idx, true);
     }
 
     bool VcdParser::query_step(size_t chunk_size)
@@ -924,10 +2952,39 @@ namespace vcd
             return false;
         if (impl_->query_done) return false;
         if (impl_->query_cancel_flag.load()) return false;
+        StatsRecorder::Span span(impl_->stats, ParserPhase::QueryStep);
 
-        std::vector<uint8_t> buffer(chunk_size);
-        size_t bytes_read =
-            std::fread(buffer.data(), 1, chunk_size, impl_->file_handle);
+        // End of the file, or of the current run of touched intervals
+        uint64_t limit = impl_->query_read_limit();
+        if (impl_->global_file_offset >= limit) return false;
+
+        // Shards start on line boundaries, so only split when no partial
+        // line is pending from a serial step.
+        if (impl_->query_threads > 1 && impl_->can_split() &&
+            impl_->pending_tail().empty())
+        {
+            impl_->query_batch_parallel(chunk_size, limit);
+            if (!impl_->mapped.is_mapped())
+                seek_file(impl_->file_handle, impl_->global_file_offset);
+            return !impl_->query_done;
+        }
+
+        if (impl_->mapped.is_mapped())
+        {
+            uint64_t begin = impl_->global_file_offset;
+            uint64_t end = std::min<uint64_t>(limit, begin + chunk_size);
+
+            impl_->mapped.will_need(end, chunk_size);  // next step
+            bool more_needed = impl_->push_mapped(end);
+            impl_->global_file_offset = end;
+            return more_needed;
+        }
+
+        size_t to_read = static_cast<size_t>(std::min<uint64_t>(
+            chunk_size, limit - impl_->global_file_offset));
+        std::vector<uint8_t>& buffer = impl_->read_buffer;
+        buffer.resize(to_read);
+        size_t bytes_read = impl_->read_input(buffer.data(), to_read);
 
         if (bytes_read == 0) return false;  // EOF or error
 
@@ -939,12 +2996,24 @@ namespace vcd
 
     QueryResultBinary VcdParser::flush_query_binary()
     {
-        // Process any remaining leftover if the query hasn't ended early
-        if (!impl_->leftover.empty() && !impl_->query_done)
+        StatsRecorder::Span span(impl_->stats, ParserPhase::Flush);
+
+        // Process any remaining leftover if the query hasn't ended early.
+        // Before EOF the tail is an incomplete line that the next
+        // query_step completes, so it must not be parsed yet.
+        std::string_view tail = impl_->pending_tail();
+        if (!tail.empty() && !impl_->query_done &&
+            impl_->global_file_offset >= impl_->file_total_size)
         {
-            impl_->process_buffer(impl_->leftover, impl_->leftover_file_offset);
+            impl_->process_buffer(tail, impl_->leftover_file_offset);
+            impl_->leftover.clear();
+            impl_->leftover_file_offset = impl_->global_file_offset;
         }
 
+        if (impl_->lod_recording && impl_->query_input_consumed() &&
+            !impl_->query_cancel_flag.load())
+            impl_->finish_lod_builds();
+
         // Ensure initial state is emitted even if data never reached
         // query_t_begin
         if (!impl_->query_initial_emitted)
@@ -953,6 +3022,13 @@ namespace vcd
             impl_->query_initial_emitted = true;
         }
 
+        // Cached with the glitches still open, so a later query can
+        // continue them
+        if ((impl_->query_done || impl_->query_input_consumed()) &&
+            !impl_->query_cancel_flag.load())
+            impl_->query_cache.finish(impl_->lod_manager,
+                                      impl_->cache_output());
+
         // Flush any open glitches at the end of the query range
         impl_->lod_manager.flush_glitches(
             impl_->query_res_1bit, impl_->last_index_1bit,
@@ -975,6 +3051,12 @@ namespace vcd
                                              : impl_->query_string_pool.data();
         impl_->binary_result.string_pool_size = impl_->query_string_pool.size();
 
+        size_t results =
+            impl_->query_res_1bit.size() + impl_->query_res_multibit.size();
+        impl_->stats.counts().changes_emitted +=
+            results - impl_->results_counted;
+        impl_->results_counted = results;
+
         // Clear vectors after attaching to result context
         // So they are fresh for the next chunk while these flat outputs
         // sit within WASM block. Note: std::vector::data() is guaranteed
@@ -985,19 +3067,94 @@ namespace vcd
         return impl_->binary_result;
     }
 
+    QueryResultBinary VcdParser::take_query_segment(bool final)
+    {
+        if (final) flush_query_binary();
+        return impl_->segments.take(
+            impl_->query_slots, impl_->query_res_1bit, impl_->last_index_1bit,
+            impl_->query_res_multibit, impl_->last_index_multi,
+            impl_->query_string_pool, final);
+    }
+
     void VcdParser::cancel_query() { impl_->query_cancel_flag.store(true); }
 
+    SearchResult VcdParser::find_next(uint32_t signal_index,
+                                      const SearchPredicate& predicate,
+                                      uint64_t from_time,
+                                      SearchDirection direction)
+    {
+        if (!impl_->header_done || impl_->phase == Impl::Phase::Indexing ||
+            !impl_->file_handle || impl_->snapshots.empty() ||
+            signal_index >= impl_->signal_defs.size())
+            return {};
+        StatsRecorder::Span span(impl_->stats, ParserPhase::Search);
+
+        ValueMatcher matcher(impl_->signal_defs[signal_index], predicate);
+        SearchResult result;
+        if (!matcher.valid())
+        {
+            result.invalid_value = true;
+            return result;
+        }
+        if (direction == SearchDirection::Forward)
+            result = impl_->search_forward(
+                signal_index, matcher, from_time,
+                get_query_plan(from_time).snapshot_index);
+        else if (from_time > impl_->t_begin)
+            result = impl_->search_backward(
+                signal_index, matcher, from_time,
+                get_query_plan(from_time - 1).snapshot_index);
+
+        // A running query reads on from the input's position
+        if (impl_->phase == Impl::Phase::Querying &&
+            !impl_->mapped.is_mapped())
+            impl_->seek_input(impl_->global_file_offset);
+        return result;
+    }
+
     // --- Statistics ---
     size_t VcdParser::snapshot_count() const { return impl_->snapshots.size(); }
+    size_t VcdParser::snapshot_memory_usage() const
+    {
+        return impl_->snapshots.memory_usage();
+    }
     size_t VcdParser::index_memory_usage() const
     {
-        size_t b = 0;
-        for (auto& s : impl_->snapshots)
+        size_t b = impl_->snapshots.memory_usage();
+        for (auto& l : impl_->touched_1bit) b += l.size() * sizeof(uint32_t);
+        for (auto& l : impl_->touched_multi) b += l.size() * sizeof(uint32_t);
+        for (auto& l : impl_->signal_lods)
         {
-            b += s.packed_1bit_states.size() * sizeof(uint64_t);
-            for (auto& st : s.multibit_states) b += st.size();
+            if (!l) continue;
+            b += l->pyramid.memory_usage();
+            for (auto& v : l->values) b += v.size();
         }
+        b += impl_->names.memory_usage() + impl_->path_index.memory_usage();
+        b += impl_->gzip.memory_usage();
         return b;
     }
 
+    // --- Instrumentation ---
+    void VcdParser::set_stats_enabled(bool enabled, bool trace)
+    {
+        impl_->stats.enable(enabled, trace);
+        impl_->glitch_base = impl_->lod_manager.glitch_count();
+        impl_->results_counted =
+            impl_->query_res_1bit.size() + impl_->query_res_multibit.size();
+    }
+
+    ParserStats VcdParser::stats() const
+    {
+        ParserStats s = impl_->stats.stats();
+        if (impl_->stats.enabled())
+            s.glitches_collapsed =
+                impl_->lod_manager.glitch_count() - impl_->glitch_base;
+        return s;
+    }
+
+    std::string VcdParser::trace_json() const
+    {
+        return impl_->stats.trace_json(stats());
+    }
+
 }  // namespace vcd
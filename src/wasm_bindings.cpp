@@ -1,16 +1,20 @@
 #include <emscripten/bind.h>
 #include <emscripten/val.h>
 
+#include <algorithm>
 #include <cstdlib>
-#include <nlohmann/json.hpp>
 #include <string>
+#include <type_traits>
 #include <vector>
 
+#include "columnar_result.h"
 #include "fst_parser.h"
+#include "hierarchy_pages.h"
+#include "result_ring.h"
 #include "vcd_parser.h"
+#include "waveform_json.h"
 
 using namespace emscripten;
-using json = nlohmann::json;
 
 // ============================================================================
 // WASM wrapper: operates on 0-copy binary chunks and high-precision BigInts
@@ -24,23 +28,99 @@ class WaveformParserWasm
     WaveformParserWasm() : parser_(std::make_unique<ParserType>()) {}
     ~WaveformParserWasm() { parser_->close_file(); }
 
-    void close() { parser_->close_file(); }
+    void close() { close_file(); }
     bool isOpen() const { return parser_->is_open(); }
 
     // --- File I/O ---
+    // Results handed out for the previous file are dropped with it
     bool open_file(const std::string& filepath)
     {
+        hierarchy_.clear();
+        results_.release_all();
         return parser_->open_file(filepath);
     }
-    void close_file() { parser_->close_file(); }
+    void close_file()
+    {
+        hierarchy_.clear();
+        results_.release_all();
+        parser_->close_file();
+    }
 
     // --- Indexing Phase ---
-    void begin_indexing() { parser_->begin_indexing(); }
+    void set_snapshot_policy(size_t memory_budget, size_t max_replay_bytes)
+    {
+        vcd::SnapshotPolicy policy;
+        policy.memory_budget = memory_budget;
+        policy.max_replay_bytes = max_replay_bytes;
+        parser_->set_snapshot_policy(policy);
+    }
+    void begin_indexing()
+    {
+        hierarchy_.clear();
+        parser_->begin_indexing();
+    }
     size_t index_step(size_t chunk_size)
     {
         return parser_->index_step(chunk_size);
     }
-    void finish_indexing() { parser_->finish_indexing(); }
+    void finish_indexing()
+    {
+        hierarchy_.clear();
+        parser_->finish_indexing();
+    }
+
+    // --- Index Persistence ---
+    bool save_index(const std::string& index_path) const
+    {
+        return parser_->save_index(index_path);
+    }
+    bool load_index(const std::string& index_path)
+    {
+        hierarchy_.clear();
+        return parser_->load_index(index_path);
+    }
+
+    // VCD only: libfst can't read an FST file before it is closed
+    void set_follow(bool enabled)
+    {
+        if constexpr (std::is_same_v<ParserType, vcd::VcdParser>)
+            typed().set_follow(enabled);
+    }
+    size_t follow_step(size_t chunk_size)
+    {
+        if constexpr (std::is_same_v<ParserType, vcd::VcdParser>)
+            return typed().follow_step(chunk_size);
+        return 0;
+    }
+
+    // VCD only: FST blocks are already addressable per signal
+    void set_transition_index(bool enabled)
+    {
+        if constexpr (std::is_same_v<ParserType, vcd::VcdParser>)
+            typed().set_transition_index(enabled);
+    }
+    void set_lod_pyramids(bool enabled)
+    {
+        if constexpr (std::is_same_v<ParserType, vcd::VcdParser>)
+            typed().set_lod_pyramids(enabled);
+    }
+
+    // 0 = every hardware thread, no-op without thread support
+    void set_query_threads(uint32_t threads)
+    {
+        typed().set_query_threads(threads);
+    }
+
+    // FST only: VCD queries replay from snapshots instead
+    void set_block_cache_budget(size_t bytes)
+    {
+        if constexpr (std::is_same_v<ParserType, vcd::FstParser>)
+            typed().set_block_cache_budget(bytes);
+    }
+    void set_query_cache_budget(size_t bytes)
+    {
+        typed().set_query_cache_budget(bytes);
+    }
 
     // --- Query Phase ---
     emscripten::val get_query_plan(uint64_t start_time) const
@@ -54,13 +134,22 @@ class WaveformParserWasm
         return obj;
     }
 
-    void begin_query(uint64_t start_time, uint64_t end_time,
-                     const std::string& indicesJSON, uint32_t snapshot_index,
-                     float pixel_time_step)
+    // The next query's signal indices are written straight into this
+    // buffer (through a Uint32Array view of the heap), then begin_query()
+    // takes the first `count` of them
+    uintptr_t query_indices_buffer(uint32_t count)
+    {
+        query_indices_.resize(count);
+        return reinterpret_cast<uintptr_t>(query_indices_.data());
+    }
+
+    void begin_query(uint64_t start_time, uint64_t end_time, uint32_t count,
+                     uint32_t snapshot_index, float pixel_time_step)
     {
-        auto parsed = json::parse(indicesJSON);
-        std::vector<uint32_t> indices = parsed.get<std::vector<uint32_t>>();
-        parser_->begin_query(start_time, end_time, indices,
+        count = std::min<uint32_t>(count, query_indices_.size());
+        query_signals_.assign(query_indices_.begin(),
+                              query_indices_.begin() + count);
+        parser_->begin_query(start_time, end_time, query_signals_,
                              static_cast<size_t>(snapshot_index),
                              pixel_time_step);
     }
@@ -91,6 +180,51 @@ class WaveformParserWasm
         return obj;
     }
 
+    // Same result, one run per queried signal in begin_query order (see
+    // ColumnarEncoder). The buffer stays valid until the next call.
+    emscripten::val flush_query_columnar(bool compressed)
+    {
+        const std::vector<uint8_t>& buf = columnar_.encode(
+            parser_->flush_query_binary(), query_signals_, compressed);
+        auto obj = emscripten::val::object();
+        obj.set("ptr", val(reinterpret_cast<uintptr_t>(buf.data())));
+        obj.set("size", val(buf.size()));
+        return obj;
+    }
+
+    // Columnar result in an arena owned by JS until release_query_result.
+    // handle is 0 when every arena is still held.
+    emscripten::val acquire_query_result(bool compressed)
+    {
+        vcd::ResultRing::Handle h = results_.acquire(
+            parser_->flush_query_binary(), query_signals_, compressed);
+        auto obj = emscripten::val::object();
+        obj.set("handle", val(h.id));
+        obj.set("ptr", val(reinterpret_cast<uintptr_t>(h.data)));
+        obj.set("size", val(h.size));
+        return obj;
+    }
+    // Like acquire_query_result, holding only what take_query_segment
+    // returns: records finalized since the previous segment. Taking a
+    // segment moves past its records, so none is taken (and the same
+    // records come with the next call) while every arena is held.
+    emscripten::val acquire_query_segment(bool final, bool compressed)
+    {
+        vcd::ResultRing::Handle h;
+        if (!results_.full())
+            h = results_.acquire(parser_->take_query_segment(final),
+                                 query_signals_, compressed);
+        auto obj = emscripten::val::object();
+        obj.set("handle", val(h.id));
+        obj.set("ptr", val(reinterpret_cast<uintptr_t>(h.data)));
+        obj.set("size", val(h.size));
+        return obj;
+    }
+    bool release_query_result(uint32_t handle)
+    {
+        return results_.release(handle);
+    }
+
     // --- Metadata ---
     std::string getDate() const { return parser_->date(); }
     std::string getVersion() const { return parser_->version(); }
@@ -102,23 +236,7 @@ class WaveformParserWasm
 
     std::string getTimescaleUnit() const
     {
-        switch (parser_->timescale().unit)
-        {
-            case vcd::TimeUnit::S:
-                return "s";
-            case vcd::TimeUnit::MS:
-                return "ms";
-            case vcd::TimeUnit::US:
-                return "us";
-            case vcd::TimeUnit::NS:
-                return "ns";
-            case vcd::TimeUnit::PS:
-                return "ps";
-            case vcd::TimeUnit::FS:
-                return "fs";
-            default:
-                return "ns";
-        }
+        return vcd::time_unit_name(parser_->timescale().unit);
     }
 
     uint64_t getTimeBegin() const { return parser_->time_begin(); }
@@ -135,35 +253,107 @@ class WaveformParserWasm
     {
         return static_cast<uint32_t>(parser_->index_memory_usage());
     }
+    emscripten::val getBlockCacheStats() const
+    {
+        vcd::BlockCache::Stats stats;
+        if constexpr (std::is_same_v<ParserType, vcd::FstParser>)
+            stats = typed().block_cache_stats();
+        auto obj = emscripten::val::object();
+        obj.set("hits", val(static_cast<double>(stats.hits)));
+        obj.set("misses", val(static_cast<double>(stats.misses)));
+        obj.set("entries", val(static_cast<uint32_t>(stats.entries)));
+        obj.set("memoryUsage",
+                val(static_cast<uint32_t>(stats.memory_usage)));
+        return obj;
+    }
+    emscripten::val getQueryCacheStats() const
+    {
+        const vcd::QueryCache::Stats& stats = typed().query_cache_stats();
+        auto obj = emscripten::val::object();
+        obj.set("hits", val(static_cast<double>(stats.hits)));
+        obj.set("partialHits", val(static_cast<double>(stats.partial_hits)));
+        obj.set("misses", val(static_cast<double>(stats.misses)));
+        obj.set("entries", val(static_cast<uint32_t>(stats.entries)));
+        obj.set("memoryUsage",
+                val(static_cast<uint32_t>(stats.memory_usage)));
+        return obj;
+    }
 
-    // --- Signal list as JSON ---
-    std::string getSignalsJSON() const
+    // --- Value search, see IWaveformParser::find_next ---
+    // `kind` as vcd::SearchKind: 0 any change, 1 rising, 2 falling, 3 equals
+    emscripten::val findNext(uint32_t signal, uint32_t kind,
+                             const std::string& value, uint64_t from_time,
+                             bool backward)
     {
-        auto& sigs = parser_->signals();
-        json arr = json::array();
-        for (auto& s : sigs)
+        auto obj = emscripten::val::object();
+        vcd::SearchResult r;
+        if (kind <= static_cast<uint32_t>(vcd::SearchKind::Equals))
         {
-            json obj = {
-                {"name", s.name},      {"fullPath", s.full_path},
-                {"idCode", s.id_code}, {"width", s.width},
-                {"index", s.index},    {"type", varTypeStr(s.type)},
-            };
-            if (s.msb >= 0)
-            {
-                obj["msb"] = s.msb;
-                obj["lsb"] = s.lsb;
-            }
-            arr.push_back(std::move(obj));
+            vcd::SearchPredicate predicate;
+            predicate.kind = static_cast<vcd::SearchKind>(kind);
+            predicate.value = value;
+            r = parser_->find_next(signal, predicate, from_time,
+                                   backward ? vcd::SearchDirection::Backward
+                                            : vcd::SearchDirection::Forward);
         }
-        return arr.dump();
+        obj.set("found", val(r.found));
+        obj.set("time", val(r.time));
+        obj.set("invalidValue", val(r.invalid_value));
+        return obj;
+    }
+
+    // --- Instrumentation, off until enabled ---
+    void setStatsEnabled(bool enabled, bool trace)
+    {
+        parser_->set_stats_enabled(enabled, trace);
+    }
+    std::string getStatsJSON() const
+    {
+        return vcd::stats_json(parser_->stats());
     }
+    std::string getTraceJSON() const { return parser_->trace_json(); }
 
-    // --- Hierarchy as JSON ---
+    // --- Signal list and hierarchy as JSON ---
+    std::string getSignalsJSON() const
+    {
+        return vcd::signals_json(*parser_);
+    }
     std::string getHierarchyJSON() const
     {
-        auto* root = parser_->root_scope();
-        if (!root) return "{}";
-        return serializeScope(root).dump();
+        return vcd::hierarchy_json(*parser_);
+    }
+
+    // --- Hierarchy, one scope page at a time (see hierarchy_pages.h) ---
+    uint32_t getScopeCount()
+    {
+        return static_cast<uint32_t>(pages().scope_count());
+    }
+    uint32_t getNameCount()
+    {
+        return static_cast<uint32_t>(pages().name_count());
+    }
+    emscripten::val getScopePage(uint32_t scope, uint32_t child_offset,
+                                 uint32_t child_limit, uint32_t signal_offset,
+                                 uint32_t signal_limit)
+    {
+        return bytes(pages().scope_page(scope, child_offset, child_limit,
+                                        signal_offset, signal_limit));
+    }
+    emscripten::val getNamePage(uint32_t first, uint32_t count)
+    {
+        return bytes(pages().name_page(first, count));
+    }
+
+    // Per-signal lookups, so a query needn't fetch the whole signal table
+    std::string getSignalPath(uint32_t index) const
+    {
+        auto& sigs = parser_->signals();
+        return index < sigs.size() ? sigs[index].full_path() : std::string();
+    }
+    int getSignalWidth(uint32_t index) const
+    {
+        auto& sigs = parser_->signals();
+        return index < sigs.size() ? sigs[index].width : 0;
     }
 
     int findSignal(const std::string& fullPath) const
@@ -175,63 +365,33 @@ class WaveformParserWasm
 
    private:
     std::unique_ptr<vcd::IWaveformParser> parser_;
+    std::vector<uint32_t> query_signals_;  // of the current query
+    std::vector<uint32_t> query_indices_;  // of the next one
+    vcd::ColumnarEncoder columnar_;
+    vcd::ResultRing results_;
+    vcd::HierarchyPages hierarchy_;  // built on first use
 
-    // --- Helpers ---
-    static const char* varTypeStr(vcd::VarType t)
+    vcd::HierarchyPages& pages()
     {
-        switch (t)
-        {
-            case vcd::VarType::Wire:
-                return "wire";
-            case vcd::VarType::Reg:
-                return "reg";
-            case vcd::VarType::Integer:
-                return "integer";
-            case vcd::VarType::Real:
-                return "real";
-            case vcd::VarType::Parameter:
-                return "parameter";
-            case vcd::VarType::Event:
-                return "event";
-            case vcd::VarType::Supply0:
-                return "supply0";
-            case vcd::VarType::Supply1:
-                return "supply1";
-            case vcd::VarType::Tri:
-                return "tri";
-            case vcd::VarType::TriAnd:
-                return "triand";
-            case vcd::VarType::TriOr:
-                return "trior";
-            case vcd::VarType::TriReg:
-                return "trireg";
-            case vcd::VarType::Tri0:
-                return "tri0";
-            case vcd::VarType::Tri1:
-                return "tri1";
-            case vcd::VarType::WAnd:
-                return "wand";
-            case vcd::VarType::WOr:
-                return "wor";
-            default:
-                return "unknown";
-        }
+        if (hierarchy_.empty())
+            hierarchy_.build(parser_->root_scope(), parser_->signals());
+        return hierarchy_;
     }
 
-    static json serializeScope(const vcd::ScopeNode* node)
+    static emscripten::val bytes(const std::vector<uint8_t>& buf)
     {
-        json obj = {{"name", node->name}, {"fullPath", node->full_path}};
-        if (!node->signal_indices.empty())
-            obj["signals"] = node->signal_indices;
-        if (!node->children.empty())
-        {
-            json children = json::array();
-            for (auto& child : node->children)
-                children.push_back(serializeScope(child.get()));
-            obj["children"] = std::move(children);
-        }
+        auto obj = emscripten::val::object();
+        obj.set("ptr", val(reinterpret_cast<uintptr_t>(buf.data())));
+        obj.set("size", val(buf.size()));
         return obj;
     }
+
+    // The concrete parser, for options outside IWaveformParser
+    ParserType& typed() { return static_cast<ParserType&>(*parser_); }
+    const ParserType& typed() const
+    {
+        return static_cast<const ParserType&>(*parser_);
+    }
 };
 
 using VcdParserWasm = WaveformParserWasm<vcd::VcdParser>;
@@ -249,14 +409,32 @@ EMSCRIPTEN_BINDINGS(vcd_parser_wasm)
         .function("isOpen", &VcdParserWasm::isOpen)
         .function("open_file", &VcdParserWasm::open_file)
         .function("close_file", &VcdParserWasm::close_file)
+        .function("set_snapshot_policy", &VcdParserWasm::set_snapshot_policy)
         .function("begin_indexing", &VcdParserWasm::begin_indexing)
         .function("index_step", &VcdParserWasm::index_step)
         .function("finish_indexing", &VcdParserWasm::finish_indexing)
+        .function("set_follow", &VcdParserWasm::set_follow)
+        .function("follow_step", &VcdParserWasm::follow_step)
+        .function("save_index", &VcdParserWasm::save_index)
+        .function("set_transition_index", &VcdParserWasm::set_transition_index)
+        .function("set_lod_pyramids", &VcdParserWasm::set_lod_pyramids)
+        .function("set_query_threads", &VcdParserWasm::set_query_threads)
+        .function("set_block_cache_budget",
+                  &VcdParserWasm::set_block_cache_budget)
+        .function("set_query_cache_budget",
+                  &VcdParserWasm::set_query_cache_budget)
+        .function("load_index", &VcdParserWasm::load_index)
         .function("get_query_plan", &VcdParserWasm::get_query_plan)
+        .function("query_indices_buffer", &VcdParserWasm::query_indices_buffer)
         .function("begin_query", &VcdParserWasm::begin_query)
         .function("query_step", &VcdParserWasm::query_step)
         .function("cancel_query", &VcdParserWasm::cancel_query)
         .function("flush_query_binary", &VcdParserWasm::flush_query_binary)
+        .function("flush_query_columnar", &VcdParserWasm::flush_query_columnar)
+        .function("acquire_query_result", &VcdParserWasm::acquire_query_result)
+        .function("acquire_query_segment",
+                  &VcdParserWasm::acquire_query_segment)
+        .function("release_query_result", &VcdParserWasm::release_query_result)
         .function("getDate", &VcdParserWasm::getDate)
         .function("getVersion", &VcdParserWasm::getVersion)
         .function("getTimescaleMagnitude",
@@ -267,8 +445,20 @@ EMSCRIPTEN_BINDINGS(vcd_parser_wasm)
         .function("getSignalCount", &VcdParserWasm::getSignalCount)
         .function("getSnapshotCount", &VcdParserWasm::getSnapshotCount)
         .function("getIndexMemoryUsage", &VcdParserWasm::getIndexMemoryUsage)
+        .function("getBlockCacheStats", &VcdParserWasm::getBlockCacheStats)
+        .function("getQueryCacheStats", &VcdParserWasm::getQueryCacheStats)
+        .function("setStatsEnabled", &VcdParserWasm::setStatsEnabled)
+        .function("getStatsJSON", &VcdParserWasm::getStatsJSON)
+        .function("getTraceJSON", &VcdParserWasm::getTraceJSON)
+        .function("findNext", &VcdParserWasm::findNext)
         .function("getSignalsJSON", &VcdParserWasm::getSignalsJSON)
         .function("getHierarchyJSON", &VcdParserWasm::getHierarchyJSON)
+        .function("getScopeCount", &VcdParserWasm::getScopeCount)
+        .function("getNameCount", &VcdParserWasm::getNameCount)
+        .function("getScopePage", &VcdParserWasm::getScopePage)
+        .function("getNamePage", &VcdParserWasm::getNamePage)
+        .function("getSignalPath", &VcdParserWasm::getSignalPath)
+        .function("getSignalWidth", &VcdParserWasm::getSignalWidth)
         .function("findSignal", &VcdParserWasm::findSignal);
 
     class_<FstParserWasm>("FstParser")
@@ -277,14 +467,32 @@ EMSCRIPTEN_BINDINGS(vcd_parser_wasm)
         .function("isOpen", &FstParserWasm::isOpen)
         .function("open_file", &FstParserWasm::open_file)
         .function("close_file", &FstParserWasm::close_file)
+        .function("set_snapshot_policy", &FstParserWasm::set_snapshot_policy)
         .function("begin_indexing", &FstParserWasm::begin_indexing)
         .function("index_step", &FstParserWasm::index_step)
         .function("finish_indexing", &FstParserWasm::finish_indexing)
+        .function("set_follow", &FstParserWasm::set_follow)
+        .function("follow_step", &FstParserWasm::follow_step)
+        .function("save_index", &FstParserWasm::save_index)
+        .function("set_transition_index", &FstParserWasm::set_transition_index)
+        .function("set_lod_pyramids", &FstParserWasm::set_lod_pyramids)
+        .function("set_query_threads", &FstParserWasm::set_query_threads)
+        .function("set_block_cache_budget",
+                  &FstParserWasm::set_block_cache_budget)
+        .function("set_query_cache_budget",
+                  &FstParserWasm::set_query_cache_budget)
+        .function("load_index", &FstParserWasm::load_index)
         .function("get_query_plan", &FstParserWasm::get_query_plan)
+        .function("query_indices_buffer", &FstParserWasm::query_indices_buffer)
         .function("begin_query", &FstParserWasm::begin_query)
         .function("query_step", &FstParserWasm::query_step)
         .function("cancel_query", &FstParserWasm::cancel_query)
         .function("flush_query_binary", &FstParserWasm::flush_query_binary)
+        .function("flush_query_columnar", &FstParserWasm::flush_query_columnar)
+        .function("acquire_query_result", &FstParserWasm::acquire_query_result)
+        .function("acquire_query_segment",
+                  &FstParserWasm::acquire_query_segment)
+        .function("release_query_result", &FstParserWasm::release_query_result)
         .function("getDate", &FstParserWasm::getDate)
         .function("getVersion", &FstParserWasm::getVersion)
         .function("getTimescaleMagnitude",
@@ -295,7 +503,19 @@ EMSCRIPTEN_BINDINGS(vcd_parser_wasm)
         .function("getSignalCount", &FstParserWasm::getSignalCount)
         .function("getSnapshotCount", &FstParserWasm::getSnapshotCount)
         .function("getIndexMemoryUsage", &FstParserWasm::getIndexMemoryUsage)
+        .function("getBlockCacheStats", &FstParserWasm::getBlockCacheStats)
+        .function("getQueryCacheStats", &FstParserWasm::getQueryCacheStats)
+        .function("setStatsEnabled", &FstParserWasm::setStatsEnabled)
+        .function("getStatsJSON", &FstParserWasm::getStatsJSON)
+        .function("getTraceJSON", &FstParserWasm::getTraceJSON)
+        .function("findNext", &FstParserWasm::findNext)
         .function("getSignalsJSON", &FstParserWasm::getSignalsJSON)
         .function("getHierarchyJSON", &FstParserWasm::getHierarchyJSON)
+        .function("getScopeCount", &FstParserWasm::getScopeCount)
+        .function("getNameCount", &FstParserWasm::getNameCount)
+        .function("getScopePage", &FstParserWasm::getScopePage)
+        .function("getNamePage", &FstParserWasm::getNamePage)
+        .function("getSignalPath", &FstParserWasm::getSignalPath)
+        .function("getSignalWidth", &FstParserWasm::getSignalWidth)
         .function("findSignal", &FstParserWasm::findSignal);
 }
@@ -0,0 +1,295 @@
+#include "waveform_c_api.h"
+
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "columnar_result.h"
+#include "fst_parser.h"
+#include "hierarchy_pages.h"
+#include "vcd_parser.h"
+#include "waveform_json.h"
+
+// ============================================================================
+// Handle: the parser plus the buffers its accessors hand out
+// ============================================================================
+
+struct wv_parser
+{
+    std::unique_ptr<vcd::IWaveformParser> parser;
+    vcd::VcdParser* vcd = nullptr;  // parser, when it is a VCD
+    vcd::FstParser* fst = nullptr;  // parser, when it is an FST
+
+    vcd::HierarchyPages hierarchy;  // built on first use
+    std::string signals_json;
+    std::string hierarchy_json;
+    std::string stats_json;
+    std::string trace_json;
+    std::vector<uint32_t> query_signals;  // of the current query
+    vcd::ColumnarEncoder columnar;
+
+    vcd::HierarchyPages& pages()
+    {
+        if (hierarchy.empty())
+            hierarchy.build(parser->root_scope(), parser->signals());
+        return hierarchy;
+    }
+};
+
+namespace
+{
+    bool ends_with(const std::string& s, const char* suffix)
+    {
+        size_t n = std::strlen(suffix);
+        return s.size() >= n && s.compare(s.size() - n, n, suffix) == 0;
+    }
+}  // namespace
+
+// --- Lifecycle ---
+
+wv_parser* wv_open(const char* path)
+{
+    auto p = std::make_unique<wv_parser>();
+    std::string file(path);
+    if (ends_with(file, ".fst"))
+    {
+        auto fst = std::make_unique<vcd::FstParser>();
+        p->fst = fst.get();
+        p->parser = std::move(fst);
+    }
+    else
+    {
+        auto vcd = std::make_unique<vcd::VcdParser>();
+        p->vcd = vcd.get();
+        p->parser = std::move(vcd);
+    }
+    if (!p->parser->open_file(file)) return nullptr;
+    return p.release();
+}
+
+void wv_close(wv_parser* p)
+{
+    if (!p) return;
+    p->parser->close_file();
+    delete p;
+}
+
+// --- Options ---
+
+void wv_set_snapshot_policy(wv_parser* p, uint64_t memory_budget,
+                            uint64_t max_replay_bytes)
+{
+    vcd::SnapshotPolicy policy;
+    policy.memory_budget = static_cast<size_t>(memory_budget);
+    policy.max_replay_bytes = max_replay_bytes;
+    p->parser->set_snapshot_policy(policy);
+}
+
+void wv_set_index_threads(wv_parser* p, unsigned threads)
+{
+    if (p->vcd) p->vcd->set_index_threads(threads);
+}
+
+void wv_set_query_threads(wv_parser* p, unsigned threads)
+{
+    if (p->vcd) p->vcd->set_query_threads(threads);
+    if (p->fst) p->fst->set_query_threads(threads);
+}
+
+void wv_set_transition_index(wv_parser* p, int enabled)
+{
+    if (p->vcd) p->vcd->set_transition_index(enabled != 0);
+}
+
+void wv_set_lod_pyramids(wv_parser* p, int enabled)
+{
+    if (p->vcd) p->vcd->set_lod_pyramids(enabled != 0);
+}
+
+// --- Indexing ---
+
+int wv_load_index(wv_parser* p, const char* index_path)
+{
+    p->hierarchy.clear();
+    return p->parser->load_index(index_path) ? 1 : 0;
+}
+
+int wv_save_index(const wv_parser* p, const char* index_path)
+{
+    return p->parser->save_index(index_path) ? 1 : 0;
+}
+
+void wv_begin_indexing(wv_parser* p)
+{
+    p->hierarchy.clear();
+    p->parser->begin_indexing();
+}
+
+size_t wv_index_step(wv_parser* p, size_t chunk_size)
+{
+    return p->parser->index_step(chunk_size);
+}
+
+void wv_finish_indexing(wv_parser* p)
+{
+    p->hierarchy.clear();
+    p->parser->finish_indexing();
+}
+
+uint64_t wv_input_position(const wv_parser* p)
+{
+    return p->vcd ? p->vcd->input_position() : 0;
+}
+
+int wv_is_open(const wv_parser* p) { return p->parser->is_open() ? 1 : 0; }
+
+// --- Metadata ---
+
+const char* wv_date(const wv_parser* p) { return p->parser->date().c_str(); }
+
+const char* wv_version(const wv_parser* p)
+{
+    return p->parser->version().c_str();
+}
+
+int wv_timescale_magnitude(const wv_parser* p)
+{
+    return p->parser->timescale().magnitude;
+}
+
+const char* wv_timescale_unit(const wv_parser* p)
+{
+    return vcd::time_unit_name(p->parser->timescale().unit);
+}
+
+uint64_t wv_time_begin(const wv_parser* p) { return p->parser->time_begin(); }
+uint64_t wv_time_end(const wv_parser* p) { return p->parser->time_end(); }
+
+uint32_t wv_signal_count(const wv_parser* p)
+{
+    return static_cast<uint32_t>(p->parser->signal_count());
+}
+
+uint32_t wv_snapshot_count(const wv_parser* p)
+{
+    return static_cast<uint32_t>(p->parser->snapshot_count());
+}
+
+uint64_t wv_index_memory_usage(const wv_parser* p)
+{
+    return p->parser->index_memory_usage();
+}
+
+const char* wv_signals_json(wv_parser* p)
+{
+    p->signals_json = vcd::signals_json(*p->parser);
+    return p->signals_json.c_str();
+}
+
+const char* wv_hierarchy_json(wv_parser* p)
+{
+    p->hierarchy_json = vcd::hierarchy_json(*p->parser);
+    return p->hierarchy_json.c_str();
+}
+
+// --- Instrumentation ---
+
+void wv_set_stats_enabled(wv_parser* p, int enabled, int trace)
+{
+    p->parser->set_stats_enabled(enabled != 0, trace != 0);
+}
+
+const char* wv_stats_json(wv_parser* p)
+{
+    p->stats_json = vcd::stats_json(p->parser->stats());
+    return p->stats_json.c_str();
+}
+
+const char* wv_trace_json(wv_parser* p)
+{
+    p->trace_json = p->parser->trace_json();
+    return p->trace_json.c_str();
+}
+
+// --- Hierarchy pages ---
+
+uint32_t wv_scope_count(wv_parser* p)
+{
+    return static_cast<uint32_t>(p->pages().scope_count());
+}
+
+uint32_t wv_name_count(wv_parser* p)
+{
+    return static_cast<uint32_t>(p->pages().name_count());
+}
+
+const uint8_t* wv_scope_page(wv_parser* p, uint32_t scope,
+                             uint32_t child_offset, uint32_t child_limit,
+                             uint32_t signal_offset, uint32_t signal_limit,
+                             size_t* size)
+{
+    auto& buf = p->pages().scope_page(scope, child_offset, child_limit,
+                                      signal_offset, signal_limit);
+    *size = buf.size();
+    return buf.data();
+}
+
+const uint8_t* wv_name_page(wv_parser* p, uint32_t first, uint32_t count,
+                            size_t* size)
+{
+    auto& buf = p->pages().name_page(first, count);
+    *size = buf.size();
+    return buf.data();
+}
+
+int64_t wv_find_signal(const wv_parser* p, const char* full_path)
+{
+    auto* sig = p->parser->find_signal(full_path);
+    return sig ? static_cast<int64_t>(sig->index) : -1;
+}
+
+// --- Queries ---
+
+void wv_begin_query(wv_parser* p, uint64_t start_time, uint64_t end_time,
+                    const uint32_t* signals, size_t count,
+                    float pixel_time_step)
+{
+    p->query_signals.assign(signals, signals + count);
+    vcd::QueryPlan plan = p->parser->get_query_plan(start_time);
+    p->parser->begin_query(start_time, end_time, p->query_signals,
+                           plan.snapshot_index, pixel_time_step);
+}
+
+int wv_query_step(wv_parser* p, size_t chunk_size)
+{
+    return p->parser->query_step(chunk_size) ? 1 : 0;
+}
+
+void wv_cancel_query(wv_parser* p) { p->parser->cancel_query(); }
+
+const uint8_t* wv_take_query_frame(wv_parser* p, int final, size_t* size)
+{
+    auto& buf = p->columnar.encode(p->parser->take_query_segment(final != 0),
+                                   p->query_signals, true);
+    *size = buf.size();
+    return buf.data();
+}
+
+// --- Value search ---
+
+int wv_find_next(wv_parser* p, uint32_t signal, int kind, const char* value,
+                 uint64_t from_time, int backward, uint64_t* time)
+{
+    if (kind < WV_SEARCH_ANY_CHANGE || kind > WV_SEARCH_EQUALS) return 0;
+    vcd::SearchPredicate predicate;
+    predicate.kind = static_cast<vcd::SearchKind>(kind);
+    if (value) predicate.value = value;
+    vcd::SearchResult r = p->parser->find_next(
+        signal, predicate, from_time,
+        backward ? vcd::SearchDirection::Backward
+                 : vcd::SearchDirection::Forward);
+    if (r.invalid_value) return -1;
+    if (r.found) *time = r.time;
+    return r.found ? 1 : 0;
+}
@@ -0,0 +1,169 @@
+#include "waveform_json.h"
+
+#include <nlohmann/json.hpp>
+
+namespace vcd
+{
+
+    using json = nlohmann::json;
+
+    const char* var_type_name(VarType type)
+    {
+        switch (type)
+        {
+            case VarType::Wire:
+                return "wire";
+            case VarType::Reg:
+                return "reg";
+            case VarType::Integer:
+                return "integer";
+            case VarType::Real:
+                return "real";
+            case VarType::Parameter:
+                return "parameter";
+            case VarType::Event:
+                return "event";
+            case VarType::Supply0:
+                return "supply0";
+            case VarType::Supply1:
+                return "supply1";
+            case VarType::Tri:
+                return "tri";
+            case VarType::TriAnd:
+                return "triand";
+            case VarType::TriOr:
+                return "trior";
+            case VarType::TriReg:
+                return "trireg";
+            case VarType::Tri0:
+                return "tri0";
+            case VarType::Tri1:
+                return "tri1";
+            case VarType::WAnd:
+                return "wand";
+            case VarType::WOr:
+                return "wor";
+            default:
+                return "unknown";
+        }
+    }
+
+    const char* time_unit_name(TimeUnit unit)
+    {
+        switch (unit)
+        {
+            case TimeUnit::S:
+                return "s";
+            case TimeUnit::MS:
+                return "ms";
+            case TimeUnit::US:
+                return "us";
+            case TimeUnit::NS:
+                return "ns";
+            case TimeUnit::PS:
+                return "ps";
+            case TimeUnit::FS:
+                return "fs";
+            default:
+                return "ns";
+        }
+    }
+
+    const char* parser_phase_name(ParserPhase phase)
+    {
+        switch (phase)
+        {
+            case ParserPhase::Open:
+                return "open";
+            case ParserPhase::Index:
+                return "index";
+            case ParserPhase::LoadIndex:
+                return "load_index";
+            case ParserPhase::BeginQuery:
+                return "begin_query";
+            case ParserPhase::SnapshotRestore:
+                return "snapshot_restore";
+            case ParserPhase::QueryStep:
+                return "query_step";
+            case ParserPhase::Flush:
+                return "flush";
+            case ParserPhase::Search:
+                return "search";
+            default:
+                return "unknown";
+        }
+    }
+
+    std::string signals_json(const IWaveformParser& parser)
+    {
+        json arr = json::array();
+        for (const SignalDef& s : parser.signals())
+        {
+            json obj = {
+                {"name", std::string(s.name)},
+                {"fullPath", s.full_path()},
+                {"idCode", std::string(s.id_code)},
+                {"width", s.width},
+                {"index", s.index},
+                {"type", var_type_name(s.type)},
+            };
+            if (s.msb >= 0)
+            {
+                obj["msb"] = s.msb;
+                obj["lsb"] = s.lsb;
+            }
+            arr.push_back(std::move(obj));
+        }
+        return arr.dump();
+    }
+
+    namespace
+    {
+        // `path` is the node's full path, handed down instead of rebuilt
+        json serialize_scope(const ScopeNode* node, const std::string& path)
+        {
+            json obj = {{"name", std::string(node->name)}, {"fullPath", path}};
+            if (!node->signal_indices.empty())
+                obj["signals"] = node->signal_indices;
+            if (!node->children.empty())
+            {
+                json children = json::array();
+                for (auto& child : node->children)
+                {
+                    std::string child_path = path.empty() ? path : path + ".";
+                    child_path.append(child->name);
+                    children.push_back(
+                        serialize_scope(child.get(), child_path));
+                }
+                obj["children"] = std::move(children);
+            }
+            return obj;
+        }
+    }  // namespace
+
+    std::string hierarchy_json(const IWaveformParser& parser)
+    {
+        const ScopeNode* root = parser.root_scope();
+        if (!root) return "{}";
+        return serialize_scope(root, std::string()).dump();
+    }
+
+    std::string stats_json(const ParserStats& stats)
+    {
+        json phases = json::object();
+        for (size_t p = 0; p < ParserStats::PHASES; ++p)
+            phases[parser_phase_name(static_cast<ParserPhase>(p))] = {
+                {"ms", stats.phase_ns[p] / 1e6},
+                {"calls", stats.phase_calls[p]}};
+        json obj = {{"bytesScanned", stats.bytes_scanned},
+                    {"linesParsed", stats.lines_parsed},
+                    {"idLookups", stats.id_lookups},
+                    {"changesApplied", stats.changes_applied},
+                    {"changesEmitted", stats.changes_emitted},
+                    {"glitchesCollapsed", stats.glitches_collapsed},
+                    {"blocksDecoded", stats.blocks_decoded},
+                    {"phases", std::move(phases)}};
+        return obj.dump();
+    }
+
+}  // namespace vcd
@@ -0,0 +1,214 @@
+// Checks that queries answered with the query cache return the same records
+// as the same queries replayed from the file.
+//
+// Usage: query_cache_test <scratch.vcd>  (the trace is written there)
+
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "vcd_parser.h"
+
+namespace
+{
+
+    // Records of one query, per signal in emitted order
+    using Records =
+        std::map<uint32_t, std::vector<std::pair<uint64_t, std::string>>>;
+
+    struct Window
+    {
+        uint64_t begin;
+        uint64_t end;
+    };
+
+    // Small deterministic generator, so failures reproduce
+    struct Lcg
+    {
+        uint64_t state;
+        uint32_t next(uint32_t n)
+        {
+            state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+            return static_cast<uint32_t>(state >> 33) % n;
+        }
+    };
+
+    // Four 1-bit and two multi-bit signals with bursts of short pulses,
+    // several changes at one timestamp and changes restating a value
+    bool write_trace(const char* path, uint64_t& t_end)
+    {
+        FILE* f = std::fopen(path, "w");
+        if (!f) return false;
+        std::fputs(
+            "$timescale 1ns $end\n$scope module top $end\n"
+            "$var wire 1 ! a $end\n$var wire 1 \" b $end\n"
+            "$var wire 1 # c $end\n$var wire 1 $ d $end\n"
+            "$var wire 8 % bus $end\n$var wire 4 & nib $end\n"
+            "$upscope $end\n$enddefinitions $end\n"
+            "#0\n$dumpvars\n0!\n0\"\nx#\n1$\nb0 %\nbx &\n$end\n",
+            f);
+        const char ids[] = "!\"#$%&";
+        const char bits[] = "01xz";
+        Lcg rng{12345};
+        uint64_t t = 0;
+        for (int step = 0; step < 4000; ++step)
+        {
+            // Mostly short gaps, so pulses fall inside a pixel
+            t += rng.next(8) ? 1 + rng.next(6) : 20 + rng.next(80);
+            std::fprintf(f, "#%llu\n", static_cast<unsigned long long>(t));
+            int changes = 1 + static_cast<int>(rng.next(4));
+            for (int c = 0; c < changes; ++c)
+            {
+                uint32_t s = rng.next(6);
+                if (s < 4)
+                {
+                    std::fprintf(f, "%c%c\n", bits[rng.next(4)], ids[s]);
+                    continue;
+                }
+                int width = s == 4 ? 8 : 4;
+                std::string v;
+                for (int b = 0; b < width; ++b)
+                    v += bits[rng.next(10) ? rng.next(2) : 2 + rng.next(2)];
+                std::fprintf(f, "b%s %c\n", v.c_str(), ids[s]);
+            }
+        }
+        t_end = t;
+        return std::fclose(f) == 0;
+    }
+
+    Records run(vcd::VcdParser& p, Window w,
+                const std::vector<uint32_t>& signals, float px)
+    {
+        vcd::QueryPlan plan = p.get_query_plan(w.begin);
+        p.begin_query(w.begin, w.end, signals, plan.snapshot_index, px);
+        while (p.query_step(4096))
+        {
+        }
+        vcd::QueryResultBinary r = p.flush_query_binary();
+
+        Records out;
+        for (size_t i = 0; i < r.count_1bit; ++i)
+        {
+            const vcd::Transition1Bit& t = r.transitions_1bit[i];
+            out[t.signal_index].emplace_back(
+                t.timestamp, std::string(1, static_cast<char>('0' + t.value)));
+        }
+        for (size_t i = 0; i < r.count_multibit; ++i)
+        {
+            const vcd::TransitionMultiBit& t = r.transitions_multibit[i];
+            out[t.signal_index].emplace_back(
+                t.timestamp,
+                std::string(r.string_pool + t.string_offset, t.string_length));
+        }
+        return out;
+    }
+
+    void print_first_difference(const Records& want, const Records& got)
+    {
+        for (const auto& [sig, records] : want)
+        {
+            auto it = got.find(sig);
+            size_t n = it == got.end() ? 0 : it->second.size();
+            for (size_t i = 0; i < records.size() || i < n; ++i)
+            {
+                bool have_want = i < records.size();
+                bool have_got = i < n;
+                if (have_want && have_got && records[i] == it->second[i])
+                    continue;
+                std::fprintf(
+                    stderr, "  signal %u, record %zu: want %s, got %s\n", sig,
+                    i,
+                    have_want ? (std::to_string(records[i].first) + ":" +
+                                 records[i].second)
+                                    .c_str()
+                              : "none",
+                    have_got ? (std::to_string(it->second[i].first) + ":" +
+                                it->second[i].second)
+                                   .c_str()
+                             : "none");
+                return;
+            }
+        }
+        std::fprintf(stderr, "  a signal is missing from the result\n");
+    }
+
+}  // namespace
+
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        std::fprintf(stderr, "usage: %s <scratch.vcd>\n", argv[0]);
+        return 2;
+    }
+    uint64_t t_end = 0;
+    if (!write_trace(argv[1], t_end))
+    {
+        std::fprintf(stderr, "cannot write %s\n", argv[1]);
+        return 2;
+    }
+
+    // Small replay intervals, so queries start from snapshots in the middle
+    vcd::SnapshotPolicy policy;
+    policy.max_replay_bytes = 2048;
+    vcd::VcdParser plain, cached;
+    plain.set_query_cache_budget(0);
+    cached.set_query_cache_budget(64 * 1024 * 1024);
+    for (vcd::VcdParser* p : {&plain, &cached})
+    {
+        p->set_snapshot_policy(policy);
+        if (!p->open_file(argv[1])) return 2;
+        p->begin_indexing();
+        while (p->index_step(4096))
+        {
+        }
+        p->finish_indexing();
+    }
+
+    // Repeated, extended, shortened and panned windows, including ones
+    // meeting or overlapping earlier ones at a single timestamp
+    uint64_t q = t_end / 8;
+    std::vector<Window> windows = {
+        {2 * q, 3 * q},          {2 * q, 3 * q},
+        {2 * q, 4 * q},          {2 * q, 3 * q},
+        {2 * q + 7, 3 * q + 7},  {2 * q - 7, 3 * q - 7},
+        {3 * q, 4 * q},          {4 * q + 1, 5 * q},
+        {3 * q + 50, 5 * q},     {q, 6 * q},
+        {5 * q, 5 * q},          {0, t_end},
+        {0, t_end},              {6 * q, t_end + 100},
+        {6 * q + 3, t_end + 100}};
+    std::vector<std::vector<uint32_t>> signal_sets = {
+        {0, 1, 2, 3, 4, 5}, {0, 4}, {1, 2, 4, 5}};
+
+    int failures = 0;
+    for (float px : {0.0f, 3.0f, 10.0f, 45.0f})
+    {
+        for (const std::vector<uint32_t>& signals : signal_sets)
+        {
+            for (const Window& w : windows)
+            {
+                Records want = run(plain, w, signals, px);
+                Records got = run(cached, w, signals, px);
+                if (want == got) continue;
+                ++failures;
+                std::fprintf(stderr,
+                             "px %g, [%llu, %llu], %zu signals: cached "
+                             "records differ\n",
+                             px, static_cast<unsigned long long>(w.begin),
+                             static_cast<unsigned long long>(w.end),
+                             signals.size());
+                print_first_difference(want, got);
+            }
+        }
+    }
+
+    const vcd::QueryCache::Stats& stats = cached.query_cache_stats();
+    std::printf("%d mismatches; cache: %llu hits, %llu partial, %llu misses\n",
+                failures, static_cast<unsigned long long>(stats.hits),
+                static_cast<unsigned long long>(stats.partial_hits),
+                static_cast<unsigned long long>(stats.misses));
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,168 @@
+// Checks find_next() on values written in the forms VCD allows: 1-bit
+// signals dumped as vectors ("b1 !") and Equals values given in hex.
+//
+// Usage: value_search_test <scratch.vcd>  (the trace is written there)
+
+#include <cstdint>
+#include <cstdio>
+#include <utility>
+#include <vector>
+
+#include "vcd_parser.h"
+
+namespace
+{
+
+    // clk is only ever dumped as a vector, en as a scalar
+    const char* kTrace =
+        "$timescale 1ns $end\n$scope module top $end\n"
+        "$var wire 1 ! clk $end\n$var wire 16 \" addr $end\n"
+        "$var wire 1 # en $end\n"
+        "$upscope $end\n$enddefinitions $end\n"
+        "#0\n$dumpvars\nb0 !\nb0 \"\n0#\n$end\n"
+        "#10\nb1 !\n"
+        "#20\nb0 !\n"
+        "#25\nb1101111010101101 \"\n"
+        "#30\nb01 !\n"
+        "#40\nB0 !\n"
+        "#45\nb0 \"\n"
+        "#50\nb1 !\n1#\n"
+        "#60\nbx !\n"
+        "#70\nb1 !\n"
+        "#80\nb1101111010101101 \"\n";
+
+    enum : uint32_t
+    {
+        kClk,
+        kAddr,
+        kEn
+    };
+
+    struct Case
+    {
+        uint32_t signal;
+        vcd::SearchKind kind;
+        const char* value;
+        uint64_t from;
+        vcd::SearchDirection direction;
+        bool found;
+        uint64_t time;
+    };
+
+    const vcd::SearchDirection kFwd = vcd::SearchDirection::Forward;
+    const vcd::SearchDirection kBack = vcd::SearchDirection::Backward;
+
+    const Case kCases[] = {
+        {kClk, vcd::SearchKind::Rising, "", 0, kFwd, true, 10},
+        {kClk, vcd::SearchKind::Rising, "", 10, kFwd, true, 30},
+        {kClk, vcd::SearchKind::Rising, "", 30, kFwd, true, 50},
+        {kClk, vcd::SearchKind::Rising, "", 50, kFwd, true, 70},
+        {kClk, vcd::SearchKind::Rising, "", 70, kFwd, false, 0},
+        {kClk, vcd::SearchKind::Rising, "", 70, kBack, true, 50},
+        {kClk, vcd::SearchKind::Falling, "", 0, kFwd, true, 20},
+        {kClk, vcd::SearchKind::Falling, "", 20, kFwd, true, 40},
+        {kClk, vcd::SearchKind::Falling, "", 40, kFwd, false, 0},
+        {kClk, vcd::SearchKind::Falling, "", 100, kBack, true, 40},
+        {kClk, vcd::SearchKind::AnyChange, "", 50, kFwd, true, 60},
+        {kClk, vcd::SearchKind::Equals, "1", 10, kFwd, true, 30},
+        {kEn, vcd::SearchKind::Rising, "", 0, kFwd, true, 50},
+        {kAddr, vcd::SearchKind::Equals, "0xdead", 0, kFwd, true, 25},
+        {kAddr, vcd::SearchKind::Equals, "0XDEAD", 25, kFwd, true, 80},
+        {kAddr, vcd::SearchKind::Equals, "hdead", 100, kBack, true, 80},
+        {kAddr, vcd::SearchKind::Equals, "b1101111010101101", 0, kFwd, true,
+         25},
+        {kAddr, vcd::SearchKind::Equals, "0x0", 25, kFwd, true, 45},
+    };
+
+    // Equals values that are neither binary nor hex
+    const char* const kInvalid[] = {"", "0x", "0xdeag", "12", "dead"};
+
+    // 1-bit records of a whole-trace query for `signal`
+    std::vector<std::pair<uint64_t, uint8_t>> query_1bit(vcd::VcdParser& p,
+                                                         uint32_t signal)
+    {
+        vcd::QueryPlan plan = p.get_query_plan(0);
+        p.begin_query(0, 100, {signal}, plan.snapshot_index, 0.0f);
+        while (p.query_step(4096))
+        {
+        }
+        vcd::QueryResultBinary r = p.flush_query_binary();
+        std::vector<std::pair<uint64_t, uint8_t>> out;
+        for (size_t i = 0; i < r.count_1bit; ++i)
+            out.emplace_back(r.transitions_1bit[i].timestamp,
+                             r.transitions_1bit[i].value);
+        return out;
+    }
+
+}  // namespace
+
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        std::fprintf(stderr, "usage: %s <scratch.vcd>\n", argv[0]);
+        return 2;
+    }
+    FILE* f = std::fopen(argv[1], "w");
+    if (!f || std::fputs(kTrace, f) < 0 || std::fclose(f) != 0)
+    {
+        std::fprintf(stderr, "cannot write %s\n", argv[1]);
+        return 2;
+    }
+
+    vcd::VcdParser p;
+    if (!p.open_file(argv[1])) return 2;
+    p.begin_indexing();
+    while (p.index_step(4096))
+    {
+    }
+    p.finish_indexing();
+
+    int failures = 0;
+    for (const Case& c : kCases)
+    {
+        vcd::SearchPredicate predicate;
+        predicate.kind = c.kind;
+        predicate.value = c.value;
+        vcd::SearchResult r = p.find_next(c.signal, predicate, c.from,
+                                          c.direction);
+        if (r.found == c.found && (!r.found || r.time == c.time) &&
+            !r.invalid_value)
+            continue;
+        ++failures;
+        std::fprintf(stderr,
+                     "signal %u, kind %d, value \"%s\", %s from %llu: want "
+                     "%s %llu, got %s %llu\n",
+                     c.signal, static_cast<int>(c.kind), c.value,
+                     c.direction == kFwd ? "forward" : "backward",
+                     static_cast<unsigned long long>(c.from),
+                     c.found ? "found" : "none",
+                     static_cast<unsigned long long>(c.time),
+                     r.invalid_value ? "invalid"
+                     : r.found       ? "found"
+                                     : "none",
+                     static_cast<unsigned long long>(r.time));
+    }
+
+    for (const char* value : kInvalid)
+    {
+        vcd::SearchPredicate predicate;
+        predicate.kind = vcd::SearchKind::Equals;
+        predicate.value = value;
+        if (p.find_next(kAddr, predicate, 0, kFwd).invalid_value) continue;
+        ++failures;
+        std::fprintf(stderr, "Equals \"%s\" was not rejected\n", value);
+    }
+
+    // The vector-dumped changes reach queries too
+    const std::vector<std::pair<uint64_t, uint8_t>> want = {
+        {0, 0}, {10, 1}, {20, 0}, {30, 1}, {40, 0}, {50, 1}, {60, 2}, {70, 1}};
+    if (query_1bit(p, kClk) != want)
+    {
+        ++failures;
+        std::fprintf(stderr, "clk query records differ\n");
+    }
+
+    std::printf("%d failures\n", failures);
+    return failures ? 1 : 0;
+}